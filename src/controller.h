@@ -43,6 +43,13 @@
 #define CONTROLLER_PREFIX    "ctrl"
 #define CONTROLLER_NAMESPACE "http://clicon.org/controller"
 
+/*! RFC 8525 YANG library namespace and RFC 8526 NETCONF yang-library capability
+ *
+ * Used for content-id driven schema discovery
+ */
+#define YANG_LIBRARY_NAMESPACE  "urn:ietf:params:xml:ns:yang:ietf-yang-library"
+#define YANG_LIBRARY_CAPABILITY "urn:ietf:params:netconf:capability:yang-library:1.1"
+
 /*! Skip junos-configuration-metadata.yang
  *
  * cRPD gives error if you request it with get-schema:
@@ -78,4 +85,16 @@
 
 #define ACTION_PROCESS "Action process"
 
+/*! Number of devices per datastore-diff reply requested by the CLI
+ *
+ * Device diffs are requested in pages and each page is shown as it arrives
+ */
+#define CONTROLLER_DIFF_PAGE 100
+
+/*! Max size in bytes of one edit-config batch in CLI stream load
+ *
+ * A batch is sent when either the number of devices or its size is reached
+ */
+#define CONTROLLER_LOAD_BATCH_BYTES (16*1024*1024)
+
 #endif /* _CONTROLLER_H */
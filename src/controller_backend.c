@@ -91,12 +91,12 @@ disconnect_device_byxml(clixon_handle h,
     device_handle dh = NULL;
 
     if ((name = xml_find_body(xn, "name")) != NULL &&
-        (dh = device_handle_find(h, name)) != NULL &&
-        device_handle_conn_state_get(dh) != CS_CLOSED){
-        device_close_connection(dh, NULL); /* Regular disconnect, no reason */
-    }
-    if (dh)
+        (dh = device_handle_find(h, name)) != NULL){
+        device_reconnect_cancel(dh); /* Removed or disabled, no auto-reconnect */
+        if (device_handle_conn_state_get(dh) != CS_CLOSED)
+            device_close_connection(dh, NULL); /* Regular disconnect, no reason */
         device_handle_free(dh);
+    }
     return 0;
 }
 
@@ -140,6 +140,55 @@ controller_commit_processes(clixon_handle h,
     return retval;
 }
 
+/*! Cache changed uint32 or boolean config leaf as clicon data int for fast access
+ *
+ * Boolean true is cached as 1 and false as 0
+ * @param[in] h      Clixon handle
+ * @param[in] nsc    Namespace context
+ * @param[in] target Post target xml tree
+ * @param[in] xpath  Path to config leaf, eg devices/device-timeout
+ * @param[in] name   Name of clicon data int, eg controller-device-timeout
+ * @retval    0      OK
+ * @retval   -1      Error
+ */
+static int
+controller_commit_data_int(clixon_handle h,
+                           cvec         *nsc,
+                           cxobj        *target,
+                           char         *xpath,
+                           char         *name)
+{
+    int       retval = -1;
+    cxobj   **vec = NULL;
+    size_t    veclen;
+    int       i;
+    char     *body;
+    uint32_t  val;
+
+    if (xpath_vec_flag(target, nsc, "%s",
+                       XML_FLAG_ADD | XML_FLAG_CHANGE,
+                       &vec, &veclen, xpath) < 0)
+        goto done;
+    for (i=0; i<veclen; i++){
+        if ((body = xml_body(vec[i])) == NULL)
+            continue;
+        if (strcmp(body, "true") == 0)
+            val = 1;
+        else if (strcmp(body, "false") == 0)
+            val = 0;
+        else if (parse_uint32(body, &val, NULL) < 1){
+            clixon_err(OE_UNIX, errno, "error parsing limit:%s", body);
+            goto done;
+        }
+        clicon_data_int_set(h, name, val);
+    }
+    retval = 0;
+ done:
+    if (vec)
+        free(vec);
+    return retval;
+}
+
 /*! Commit device config
  *
  * @param[in] h    Clixon handle
@@ -162,29 +211,46 @@ controller_commit_device(clixon_handle h,
                          cxobj        *target)
 {
     int       retval = -1;
-    cxobj   **vec0= NULL;
     cxobj   **vec1 = NULL;
     cxobj   **vec2 = NULL;
-    size_t    veclen0;
     size_t    veclen1;
     size_t    veclen2;
     int       i;
     char     *body;
-    uint32_t  dt;
 
-    if (xpath_vec_flag(target, nsc, "devices/device-timeout",
-                       XML_FLAG_ADD | XML_FLAG_CHANGE,
-                       &vec0, &veclen0) < 0)
+    if (controller_commit_data_int(h, nsc, target, "devices/device-timeout",
+                                   "controller-device-timeout") < 0)
+        goto done;
+    if (controller_commit_data_int(h, nsc, target, "devices/transaction-queue-depth",
+                                   "controller-transaction-queue-depth") < 0)
+        goto done;
+    if (controller_commit_data_int(h, nsc, target, "devices/transaction-history-max",
+                                   "controller-transaction-history-max") < 0)
+        goto done;
+    if (controller_commit_data_int(h, nsc, target, "devices/transaction-history-age",
+                                   "controller-transaction-history-age") < 0)
+        goto done;
+    if (controller_commit_data_int(h, nsc, target, "devices/device-timeout-min",
+                                   "controller-device-timeout-min") < 0)
+        goto done;
+    if (controller_commit_data_int(h, nsc, target, "devices/device-timeout-max",
+                                   "controller-device-timeout-max") < 0)
+        goto done;
+    if (controller_commit_data_int(h, nsc, target, "devices/connect-max-inflight",
+                                   "controller-connect-max-inflight") < 0)
+        goto done;
+    if (controller_commit_data_int(h, nsc, target, "devices/connect-rate",
+                                   "controller-connect-rate") < 0)
+        goto done;
+    if (controller_commit_data_int(h, nsc, target, "devices/warm-restart",
+                                   "controller-warm-restart") < 0)
+        goto done;
+    if (controller_commit_data_int(h, nsc, target, "devices/services-commit-delta",
+                                   "controller-services-commit-delta") < 0)
+        goto done;
+    if (controller_commit_data_int(h, nsc, target, "devices/transaction-trace",
+                                   "controller-transaction-trace") < 0)
         goto done;
-    for (i=0; i<veclen0; i++){
-        if ((body = xml_body(vec0[i])) == NULL)
-            continue;
-        if (parse_uint32(body, &dt, NULL) < 1){
-            clixon_err(OE_UNIX, errno, "error parsing limit:%s", body);
-            goto done;
-        }
-        clicon_data_int_set(h, "controller-device-timeout", dt);
-    }
 
     /* 1) if device removed, disconnect */
     if (xpath_vec_flag(src, nsc, "devices/device",
@@ -194,6 +260,10 @@ controller_commit_device(clixon_handle h,
     for (i=0; i<veclen1; i++){
         if (disconnect_device_byxml(h, vec1[i]) < 0)
             goto done;
+        /* Remove persisted warm restart state */
+        if ((body = xml_find_body(vec1[i], "name")) != NULL &&
+            device_state_persist_remove(h, body) < 0)
+            goto done;
     }
     /* 2a) if enable changed to false, disconnect, to true connect
      */
@@ -211,8 +281,6 @@ controller_commit_device(clixon_handle h,
     }
     retval = 0;
  done:
-    if (vec0)
-        free(vec0);
     if (vec1)
         free(vec1);
     if (vec2)
@@ -241,6 +309,10 @@ controller_commit(clixon_handle    h,
         goto done;
     if (controller_commit_processes(h, nsc, src, target) < 0)
         goto done;
+    if (controller_created_index_commit(h, nsc, src, target) < 0)
+        goto done;
+    if (controller_template_commit(h, nsc, src, target) < 0)
+        goto done;
     retval = 0;
  done:
     if (nsc)
@@ -248,6 +320,24 @@ controller_commit(clixon_handle    h,
     return retval;
 }
 
+/*! Transaction end, commit succeeded
+ */
+static int
+controller_commit_end(clixon_handle    h,
+                      transaction_data td)
+{
+    return controller_created_index_end(h);
+}
+
+/*! Transaction abort, validation or commit failed
+ */
+static int
+controller_commit_abort(clixon_handle    h,
+                        transaction_data td)
+{
+    return controller_created_index_abort(h);
+}
+
 /*! Callback for yang extensions controller
  *
  * @param[in] h    Clixon handle
@@ -508,7 +598,8 @@ controller_reset(clixon_handle h,
 static int
 controller_start(clixon_handle h)
 {
-    return 0;
+    /* There may be no startup commit, eg in running startup mode */
+    return controller_created_index_init(h);
 }
 
 /*! Called just before plugin unloaded.
@@ -521,9 +612,13 @@ controller_exit(clixon_handle h)
     device_handle dh = NULL;
 
     controller_transaction_free_all(h);
-    while ((dh = device_handle_each(h, dh)) != NULL)
+    while ((dh = device_handle_each(h, dh)) != NULL){
+        device_reconnect_cancel(dh);
         device_close_connection(dh, "controller exit");
+    }
     device_handle_free_all(h);
+    controller_created_index_free(h);
+    controller_template_free(h);
     return 0;
 }
 
@@ -538,6 +633,8 @@ static clixon_plugin_api api = {
     .ca_extension    = controller_unknown,
     .ca_statedata    = controller_statedata,
     .ca_trans_commit = controller_commit,
+    .ca_trans_end    = controller_commit_end,
+    .ca_trans_abort  = controller_commit_abort,
     .ca_yang_mount   = controller_yang_mount,
 #ifdef CONTROLLER_JUNOS_ADD_COMMAND_FORWARDING
     .ca_yang_patch   = controller_yang_patch_junos,
@@ -565,6 +662,11 @@ clixon_plugin_init(clixon_handle h)
                    "A transaction has been completed.",
                    0, NULL) < 0)
         goto done;
+    /* see device_handle_change_notify */
+    if (stream_add(h, "controller-device-change",
+                   "A device has been added, removed or opened.",
+                   0, NULL) < 0)
+        goto done;
     /* Register pyapi sub-process */
     if (action_daemon_register(h) < 0)
         goto done;
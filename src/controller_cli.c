@@ -30,6 +30,7 @@
 #include <syslog.h>
 #include <unistd.h>
 #include <fnmatch.h>
+#include <dlfcn.h>
 #include <signal.h> /* matching strings */
 #include <sys/stat.h>
 #include <sys/time.h>
@@ -76,6 +77,11 @@ controller_cli_start(clixon_handle h)
     if (clicon_data_int_set(h, "controller-transaction-notify-socket", s) < 0)
         goto done;
     clixon_debug(CLIXON_DBG_DEFAULT, "%s notification socket:%d", __FUNCTION__, s);
+    /* Device add/remove/open events invalidate the cached device list */
+    if (clicon_rpc_create_subscription(h, "controller-device-change", NULL, &s) < 0)
+        goto done;
+    if (clicon_data_int_set(h, "controller-device-notify-socket", s) < 0)
+        goto done;
     if (gentree_expand_all == 1)
         if (controller_cligen_gentree_all(cli_cligen(h)) < 0)
             goto done;
@@ -124,6 +130,11 @@ controller_cli_exit(clixon_handle h)
         clicon_data_int_del(h, "controller-transaction-notify-socket");
         close(s);
     }
+    if ((s = clicon_data_int_get(h, "controller-device-notify-socket")) > 0){
+        clicon_data_int_del(h, "controller-device-notify-socket");
+        close(s);
+    }
+    rpc_get_yanglib_mount_cache_free(h);
     if ((s = clicon_client_socket_get(h)) > 0){
         close(s);
         clicon_client_socket_set(h, -1);
@@ -140,7 +151,7 @@ controller_cli_exit(clixon_handle h)
 /*! Check if there is another equivalent xyanglib and if so reuse that yspec
  *
  * Prereq: schema-list (xyanglib) is completely known.
- * Look for an existing equivalent schema-list among other devices.
+ * Look for an existing equivalent schema-list among other devices, ie with same fingerprint.
  * If found, re-use that YANG-SPEC.
  * @param[in]  h         Clixon handle
  * @param[in]  xdev0     XML device tree full state
@@ -161,16 +172,19 @@ device_shared_yspec_xml(clixon_handle h,
 #ifdef SHARED_PROFILE_YSPEC
     yang_stmt *yspec = NULL;
     cxobj     *xdev;
-    cxobj     *xyanglib;
     char      *devname;
+    char      *fp0;
+    char      *fp;
 
+    fp0 = xml_find_body(xdev0, "fingerprint");
     xdev = NULL;
     while ((xdev = xml_child_each(xdevs, xdev, CX_ELMNT)) != NULL) {
         if (strcmp(xml_find_body(xdev, "name"), xml_find_body(xdev0, "name")) == 0)
             continue;
-        if ((xyanglib = xpath_first(xdev, 0, "config/yang-library")) == NULL)
+        /* Equal yang-libs have equal fingerprints */
+        if (fp0 == NULL || (fp = xml_find_body(xdev, "fingerprint")) == NULL)
             continue;
-        if (xml_tree_equal(xyanglib0, xyanglib) != 0)
+        if (strcmp(fp0, fp) != 0)
             continue;
         if ((devname = xml_find_body(xdev, "name")) == NULL)
             continue;
@@ -238,8 +252,9 @@ create_autocli_mount_tree(clixon_handle h,
         /* 5. Check if there is another equivalent xyanglib and if so reuse that yspec */
         if (device_shared_yspec_xml(h, xdev, xdevs0, xyanglib, &yspec1) < 0)
             goto done;
-        /* 5. Parse YANGs locally from the yang specs */
-        if ((ret = yang_lib2yspec(h, xyanglib, yspec1)) < 0)
+        /* 5. Parse YANGs locally from the yang specs, unless shared */
+        if (yang_len_get(yspec1) == 0 &&
+            (ret = yang_lib2yspec(h, xyanglib, yspec1)) < 0)
             goto done;
         if (controller_mount_yspec_set(h, devname, yspec1) < 0)
             goto done;
@@ -253,43 +268,346 @@ create_autocli_mount_tree(clixon_handle h,
     return retval;
 }
 
-/*! Check one level of parsetree equivalence
+/*! Resolve callback and expand function names of a cached autocli tree
  *
- * @param[in]  pt1
- * @param[in]  pt2
- * @retval     0    If equal
- * @retval    <0    If co1 is less than co2
- * @retval    >0    If co1 is greater than co2
+ * Autocli callbacks are CLI library functions, found in the global symbol table
+ * @param[in]  name   Function name
+ * @param[in]  arg    dlopen handle of global symbol table
+ * @param[out] error  Error string if not found
+ * @retval     fn     Function pointer
+ * @retval     NULL   Not found
+ */
+static void *
+controller_autocli_str2fn(char  *name,
+                          void  *arg,
+                          char **error)
+{
+    void *fn;
+
+    if ((fn = dlsym(arg, name)) == NULL)
+        *error = "autocli cache callback not found";
+    return fn;
+}
+
+/*! qsort string compare
  */
 static int
-pt_eq1(parse_tree *pt1,
-       parse_tree *pt2)
+controller_strcmp(const void *a,
+                  const void *b)
 {
-    int     ptlen;
-    int     eq;
-    cg_obj *co1;
-    cg_obj *co2;
-    int     i;
-
-    ptlen = pt_len_get(pt1);
-    if ((eq = ptlen - pt_len_get(pt1)) == 0)
-        for (i=0; i<ptlen; i++){
-            co1 = pt_vec_i_get(pt1, i);
-            co2 = pt_vec_i_get(pt2, i);
-            if (co1 == NULL && co2 == NULL)
-                continue;
-            else if (co1 == NULL){
-                eq = -1;
-                break;
-            }
-            else if (co2 == NULL){
-                eq = 1;
-                break;
-            }
-            if ((eq = co_eq(co1, co2)) != 0)
-                break;
+    return strcmp(*(char**)a, *(char**)b);
+}
+
+/*! Get hash of the autocli configuration, ie CLICON_CLI_* options and autocli rules
+ *
+ * The hash is computed once and then kept in the handle
+ * @param[in]  h        Clixon handle
+ * @param[out] hash     Autocli configuration hash as hex string
+ * @retval     0        OK
+ * @retval    -1        Error
+ */
+static int
+controller_autocli_conf_hash(clixon_handle h,
+                             char        **hash)
+{
+    int            retval = -1;
+    clicon_hash_t *options;
+    char         **keys = NULL;
+    size_t         nkeys;
+    cxobj         *xautocli;
+    cbuf          *cb = NULL;
+    char          *str;
+    char           hashstr[17];
+    uint64_t       fnv = 0xcbf29ce484222325ULL;
+    int            i;
+
+    if (clicon_data_get(h, "controller-autocli-conf-hash", hash) == 0)
+        goto ok;
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    /* Sorted since hash key order is not defined */
+    options = clicon_options(h);
+    if (clicon_hash_keys(options, &keys, &nkeys) < 0)
+        goto done;
+    qsort(keys, nkeys, sizeof(char*), controller_strcmp);
+    for (i=0; i<nkeys; i++){
+        if (strncmp(keys[i], "CLICON_CLI_", strlen("CLICON_CLI_")) != 0)
+            continue;
+        if ((str = clicon_option_str(h, keys[i])) == NULL)
+            str = "";
+        cprintf(cb, "%s=%s\n", keys[i], str);
+    }
+    if ((xautocli = clicon_conf_autocli(h)) != NULL &&
+        clixon_xml2cbuf(cb, xautocli, 0, 0, NULL, -1, 0) < 0)
+        goto done;
+    for (str = cbuf_get(cb); *str; str++){
+        fnv ^= (unsigned char)*str;
+        fnv *= 0x100000001b3ULL;
+    }
+    snprintf(hashstr, sizeof(hashstr), "%016" PRIx64, fnv);
+    if (clicon_data_set(h, "controller-autocli-conf-hash", hashstr) < 0)
+        goto done;
+    if (clicon_data_get(h, "controller-autocli-conf-hash", hash) < 0)
+        goto done;
+ ok:
+    retval = 0;
+ done:
+    if (keys)
+        free(keys);
+    if (cb)
+        cbuf_free(cb);
+    return retval;
+}
+
+/*! Get filename of autocli cache of a fingerprint
+ *
+ * Key is module-set fingerprint, autocli configuration hash and controller version
+ * @param[in]  h        Clixon handle
+ * @param[in]  fp       Module-set fingerprint
+ * @param[out] cb       Filename
+ * @retval     1        OK
+ * @retval     0        Cache not enabled
+ * @retval    -1        Error
+ */
+static int
+controller_autocli_cache_file(clixon_handle h,
+                              char         *fp,
+                              cbuf         *cb)
+{
+    char *dir;
+    char *hash = NULL;
+
+    if ((dir = clicon_option_str(h, "CONTROLLER_AUTOCLI_CACHE_DIR")) == NULL ||
+        strlen(dir) == 0)
+        return 0;
+    if (controller_autocli_conf_hash(h, &hash) < 0)
+        return -1;
+    cprintf(cb, "%s/autocli-%s-%s-%s.cli", dir, fp, hash, CONTROLLER_VERSION);
+    return 1;
+}
+
+/*! Load autocli tree from on-disk cache
+ *
+ * @param[in]  h        Clixon handle
+ * @param[in]  fp       Module-set fingerprint
+ * @param[in]  treename Autocli tree name
+ * @retval     1        OK, tree loaded
+ * @retval     0        Cache not enabled or no cache file
+ * @retval    -1        Error
+ * @see controller_autocli_cache_save
+ */
+static int
+controller_autocli_cache_load(clixon_handle h,
+                              char         *fp,
+                              char         *treename)
+{
+    int         retval = -1;
+    cbuf       *cb = NULL;
+    FILE       *f = NULL;
+    parse_tree *pt = NULL;
+    pt_head    *ph;
+    struct stat st;
+    void       *dlh = NULL;
+    int         ret;
+
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    if ((ret = controller_autocli_cache_file(h, fp, cb)) < 0)
+        goto done;
+    if (ret == 0)
+        goto fail;
+    if (stat(cbuf_get(cb), &st) < 0)
+        goto fail;
+    if ((f = fopen(cbuf_get(cb), "r")) == NULL){
+        clixon_err(OE_UNIX, errno, "fopen(%s)", cbuf_get(cb));
+        goto done;
+    }
+    if ((pt = pt_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "pt_new");
+        goto done;
+    }
+    if (clispec_parse_file(cli_cligen(h), f, treename, NULL, pt, NULL) < 0){
+        /* Regenerate and overwrite */
+        clixon_log(h, LOG_WARNING, "Autocli cache %s not loaded: %s", cbuf_get(cb), clixon_err_reason());
+        goto fail;
+    }
+    if ((dlh = dlopen(NULL, RTLD_NOW)) == NULL){
+        clixon_err(OE_PLUGIN, 0, "dlopen: %s", dlerror());
+        goto done;
+    }
+    if (cligen_callbackv_str2fn(pt, (cgv_str2fn_t*)controller_autocli_str2fn, dlh) < 0)
+        goto done;
+    if (cligen_expandv_str2fn(pt, (expandv_str2fn_t*)controller_autocli_str2fn, dlh) < 0)
+        goto done;
+    if ((ph = cligen_ph_add(cli_cligen(h), treename)) == NULL)
+        goto done;
+    if (cligen_ph_parsetree_set(ph, pt) < 0){
+        clixon_err(OE_UNIX, 0, "cligen_ph_parsetree_set");
+        goto done;
+    }
+    pt = NULL;
+    clixon_debug(CLIXON_DBG_DEFAULT, "%s loaded %s", __FUNCTION__, treename);
+    retval = 1;
+ done:
+    if (dlh)
+        dlclose(dlh);
+    if (pt)
+        pt_free(pt, 1);
+    if (f)
+        fclose(f);
+    if (cb)
+        cbuf_free(cb);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Save autocli tree to on-disk cache
+ *
+ * Write to a temporary file and rename, so that concurrent CLIs do not read partial files
+ * @param[in]  h        Clixon handle
+ * @param[in]  fp       Module-set fingerprint
+ * @param[in]  ph       Parse-tree head of autocli tree
+ * @retval     0        OK, or cache not enabled
+ * @retval    -1        Error
+ * @see controller_autocli_cache_load
+ */
+static int
+controller_autocli_cache_save(clixon_handle h,
+                              char         *fp,
+                              pt_head      *ph)
+{
+    int   retval = -1;
+    cbuf *cb = NULL;
+    cbuf *cbtmp = NULL;
+    cbuf *cbpt = NULL;
+    FILE *f = NULL;
+    int   ret;
+
+    if ((cb = cbuf_new()) == NULL ||
+        (cbtmp = cbuf_new()) == NULL ||
+        (cbpt = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    if ((ret = controller_autocli_cache_file(h, fp, cb)) < 0)
+        goto done;
+    if (ret == 0)
+        goto ok;
+    if (pt2cbuf(cbpt, cligen_ph_parsetree_get(ph), 0, 0) < 0)
+        goto done;
+    cprintf(cbtmp, "%s.%u", cbuf_get(cb), getpid());
+    if ((f = fopen(cbuf_get(cbtmp), "w")) == NULL){
+        clixon_err(OE_UNIX, errno, "fopen(%s)", cbuf_get(cbtmp));
+        goto done;
+    }
+    if (fwrite(cbuf_get(cbpt), 1, cbuf_len(cbpt), f) != cbuf_len(cbpt)){
+        clixon_err(OE_UNIX, errno, "fwrite");
+        goto done;
+    }
+    fclose(f);
+    f = NULL;
+    if (rename(cbuf_get(cbtmp), cbuf_get(cb)) < 0){
+        clixon_err(OE_UNIX, errno, "rename(%s)", cbuf_get(cb));
+        goto done;
+    }
+ ok:
+    retval = 0;
+ done:
+    if (f){
+        fclose(f);
+        unlink(cbuf_get(cbtmp));
+    }
+    if (cb)
+        cbuf_free(cb);
+    if (cbtmp)
+        cbuf_free(cbtmp);
+    if (cbpt)
+        cbuf_free(cbpt);
+    return retval;
+}
+
+/*! Get shared autocli tree of a device, generate it if it does not exist
+ *
+ * Autocli trees are named mountpoint-<fingerprint> and shared by all devices with the same
+ * module-set fingerprint. The YANG spec of the device mount-point is set, shared with
+ * other devices of the same fingerprint if possible.
+ * If CONTROLLER_AUTOCLI_CACHE_DIR is set, trees are loaded from and saved to that dir.
+ * @param[in]  h         Clixon handle
+ * @param[in]  xdevs     Devices with yang-libraries, see rpc_get_yanglib_mount_match
+ * @param[in]  xdev      Device
+ * @param[out] cb        Name of autocli tree
+ * @param[out] php       Parse-tree head of autocli tree
+ * @retval     1         OK, tree name in cb
+ * @retval     0         Device yang-library unknown, no tree
+ * @retval    -1         Error
+ */
+static int
+controller_autocli_tree(clixon_handle h,
+                        cxobj        *xdevs,
+                        cxobj        *xdev,
+                        cbuf         *cb,
+                        pt_head     **php)
+{
+    int        retval = -1;
+    char      *fp;
+    char      *newtree;
+    cxobj     *xyanglib;
+    yang_stmt *yspec1 = NULL;
+    pt_head   *ph;
+    char      *dir;
+    int        cache;
+    int        ret;
+
+    if ((fp = xml_find_body(xdev, "fingerprint")) == NULL)
+        goto fail;
+    if ((xyanglib = device_yang_library_find(xdevs, xdev)) == NULL)
+        goto fail;
+    cache = (dir = clicon_option_str(h, "CONTROLLER_AUTOCLI_CACHE_DIR")) != NULL && strlen(dir);
+    cbuf_reset(cb);
+    cprintf(cb, "mountpoint-%s", fp);
+    newtree = cbuf_get(cb);
+    if ((ph = cligen_ph_find(cli_cligen(h), newtree)) == NULL && cache){
+        if ((ret = controller_autocli_cache_load(h, fp, newtree)) < 0)
+            goto done;
+        if (ret == 1)
+            ph = cligen_ph_find(cli_cligen(h), newtree);
+    }
+    /* With autocli cache, device YANG specs are only parsed if the tree is generated,
+     * otherwise they are parsed on demand by the yang-mount callback */
+    if (ph == NULL || !cache){
+        if (create_autocli_mount_tree(h, xdev, xdevs, xyanglib, newtree, &yspec1) < 0)
+            goto done;
+        if (yspec1 == NULL){
+            clixon_err(OE_YANG, 0, "No yang spec");
+            goto done;
+        }
+    }
+    if (ph == NULL){
+        /* Generate auto-cligen tree from the specs, once per fingerprint */
+        if (yang2cli_yspec(h, yspec1, newtree) < 0)
+            goto done;
+        /* Sanity */
+        if ((ph = cligen_ph_find(cli_cligen(h), newtree)) == NULL){
+            clixon_err(OE_YANG, 0, "autocli should have been generated but is not?");
+            goto done;
         }
-    return eq;
+        if (controller_autocli_cache_save(h, fp, ph) < 0)
+            goto done;
+    }
+    if (php)
+        *php = ph;
+    retval = 1;
+ done:
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
 }
 
 /*! Force generation of clisprec trees for device set given by pattern
@@ -306,69 +624,32 @@ controller_cligen_gentree_all(cligen_handle ch)
 {
     int           retval = -1;
     clixon_handle h;
-    cxobj        *xdevs0 = NULL;
-    cxobj        *xdev0;
     cxobj        *xdevs1 = NULL;
     cxobj        *xdev1;
     cbuf         *cb = NULL;
-    yang_stmt    *yspec1 = NULL;
     char         *devname;
-    char         *newtree;
-    cxobj        *xyanglib;
     char         *pattern = "*";
 
     h = cligen_userhandle(ch);
-    if (rpc_get_yanglib_mount_match(h, pattern, 0, 0, &xdevs0) < 0)
+    if (rpc_get_yanglib_mount_cached(h, 1, &xdevs1) < 0)
         goto done;
     if ((cb = cbuf_new()) == NULL){
         clixon_err(OE_UNIX, errno, "cbuf_new");
         goto done;
     }
-    xdev0 = NULL;
-    while ((xdev0 = xml_child_each(xdevs0, xdev0, CX_ELMNT)) != NULL) {
-        if ((devname = xml_find_body(xdev0, "name")) == NULL)
+    xdev1 = NULL;
+    while ((xdev1 = xml_child_each(xdevs1, xdev1, CX_ELMNT)) != NULL) {
+        if ((devname = xml_find_body(xdev1, "name")) == NULL)
             continue;
         if (pattern != NULL && fnmatch(pattern, devname, 0) != 0)
             continue;
-        cbuf_reset(cb);
-        cprintf(cb, "mountpoint-%s", devname);
-        newtree = cbuf_get(cb);
-        if (cligen_ph_find(ch, newtree) == NULL){
-            /* No such cligen specs, query full modules once
-             */
-            if (xdevs1 == NULL)
-                if (rpc_get_yanglib_mount_match(h, "*", 0, 1, &xdevs1) < 0)
-                    goto done;
-            if (xdevs1 == NULL)
-                continue;
-            if ((xdev1 = xpath_first(xdevs1, 0, "device[name='%s']", devname)) == NULL)
-                continue;
-            if ((xyanglib = xpath_first(xdev1, 0, "config/yang-library")) == NULL)
-                continue;
-            if (create_autocli_mount_tree(h, xdev1, xdevs1, xyanglib, newtree, &yspec1) < 0)
-                goto done;
-            if (yspec1 == NULL){
-                clixon_err(OE_YANG, 0, "No yang spec");
-                goto done;
-            }
-            /* Generate auto-cligen tree from the specs */
-            if (yang2cli_yspec(h, yspec1, newtree) < 0)
-                goto done;
-            /* Sanity */
-            if (cligen_ph_find(ch, newtree) == NULL){
-                clixon_err(OE_YANG, 0, "autocli should have been generated but is not?");
-                goto done;
-            }
-        }
+        if (controller_autocli_tree(h, xdevs1, xdev1, cb, NULL) < 0)
+            goto done;
     }
     retval = 0;
  done:
     if (cb)
         cbuf_free(cb);
-    if (xdevs0)
-        xml_free(xdevs0);
-    if (xdevs1)
-        xml_free(xdevs1);
     return retval;
 }
 
@@ -400,16 +681,13 @@ controller_cligen_treeref_wrap(cligen_handle ch,
     char         *newtree;
     char         *firsttree = NULL;
     cbuf         *cb = NULL;
-    yang_stmt    *yspec1 = NULL;
     clixon_handle h;
     cvec         *cvv_edit;
-    cxobj        *xdevs0 = NULL;
-    cxobj        *xdev0;
     cxobj        *xdevs1 = NULL;
     cxobj        *xdev1;
     pt_head      *ph;
     int           nomatch = 0;
-    cxobj        *xyanglib;
+    int           ret;
 
     h = cligen_userhandle(ch);
     if (strcmp(name, "mountpoint") != 0)
@@ -432,69 +710,40 @@ controller_cligen_treeref_wrap(cligen_handle ch,
     if ((pattern = cv_string_get(cvdev)) == NULL)
         goto ok;
     /* Pattern match all devices (mountpoints) into xdevs
-     * Match devname against all existing devices via get-config (using depth?)
-     * Find a "newtree" device name (or NULL)
-     * construct a treename from that: mountpoint-<newtree>
+     * Find the module-set fingerprint of the matching devices
+     * construct a treename from that: mountpoint-<fingerprint>
      * If it does not exist, call a yang2cli_yspec from that
-     * create_autocli_mount_tree() should probably be rewritten
      */
     clixon_debug(1, "");
-    if (rpc_get_yanglib_mount_match(h, "*", 0, 0, &xdevs0) < 0)
+    if (rpc_get_yanglib_mount_cached(h, 1, &xdevs1) < 0)
         goto done;
     if ((cb = cbuf_new()) == NULL){
         clixon_err(OE_UNIX, errno, "cbuf_new");
         goto done;
     }
-    /* Loop through all matching devices, check if clispec exists, if not generate
-     * But only for first match
+    /* Loop through all matching devices, generate shared clispec if not exists.
+     * Devices are compatible if they have the same fingerprint, ie share clispec
      */
-    xdev0 = NULL;
-    while ((xdev0 = xml_child_each(xdevs0, xdev0, CX_ELMNT)) != NULL) {
-        if ((devname = xml_find_body(xdev0, "name")) == NULL)
+    xdev1 = NULL;
+    while ((xdev1 = xml_child_each(xdevs1, xdev1, CX_ELMNT)) != NULL) {
+        if ((devname = xml_find_body(xdev1, "name")) == NULL)
             continue;
         if (pattern != NULL && fnmatch(pattern, devname, 0) != 0)
             continue;
-        cbuf_reset(cb);
-        cprintf(cb, "mountpoint-%s", devname);
-        newtree = cbuf_get(cb);
-        if (firsttree == NULL &&
-            (firsttree= strdup(newtree)) == NULL){
-            clixon_err(OE_UNIX, errno, "strdup");
+        if ((ret = controller_autocli_tree(h, xdevs1, xdev1, cb, NULL)) < 0)
             goto done;
-        }
-        if ((ph = cligen_ph_find(ch, newtree)) == NULL){
-            if (xdevs1 == NULL)
-                /* No such cligen specs, query full modules and generate clispec */
-                if (rpc_get_yanglib_mount_match(h, "*", 0, 1, &xdevs1) < 0)
-                    goto done;
-            if (xdevs1 == NULL)
-                continue;
-            if ((xdev1 = xpath_first(xdevs1, 0, "device[name='%s']", devname)) == NULL)
-                continue;
-            if ((xyanglib = xpath_first(xdev1, 0, "config/yang-library")) == NULL)
-                continue;
-            if (create_autocli_mount_tree(h, xdev1, xdevs1, xyanglib, newtree, &yspec1) < 0)
-                goto done;
-            if (yspec1 == NULL){
-                clixon_err(OE_YANG, 0, "No yang spec");
-                goto done;
-            }
-            /* Generate auto-cligen tree from the specs */
-            if (yang2cli_yspec(h, yspec1, newtree) < 0)
-                goto done;
-            /* Sanity (ph needed further down) */
-            if ((ph = cligen_ph_find(ch, newtree)) == NULL){
-                clixon_err(OE_YANG, 0, "autocli should have been generated but is not?");
+        if (ret == 0)
+            continue;
+        newtree = cbuf_get(cb);
+        if (firsttree == NULL){
+            if ((firsttree = strdup(newtree)) == NULL){
+                clixon_err(OE_UNIX, errno, "strdup");
                 goto done;
             }
         }
-        /* Check if multiple trees are equal */
-        if (strcmp(firsttree, newtree) != 0){
-            parse_tree *pt0 = cligen_ph_parsetree_get(cligen_ph_find(ch, firsttree));
-            parse_tree *pt1 = cligen_ph_parsetree_get(ph);
-
-            if (pt_eq1(pt0, pt1) != 0)
-                nomatch++;
+        else if (strcmp(firsttree, newtree) != 0){
+            nomatch++;
+            break;
         }
     }
     if (namep){
@@ -522,10 +771,6 @@ controller_cligen_treeref_wrap(cligen_handle ch,
  done:
     if (firsttree)
         free(firsttree);
-    if (xdevs0)
-        xml_free(xdevs0);
-    if (xdevs1)
-        xml_free(xdevs1);
     if (cb)
         cbuf_free(cb);
     return retval;
@@ -544,7 +789,7 @@ controller_cligen_treeref_wrap(cligen_handle ch,
  *         ...
  *      </module-set>
  *   </yang-library>
- * Get the schema-list for this device from the backend
+ * Get the schema-list for this device from the backend using get-device-yang-library
  * @param[in]  h       Clixon handle
  * @param[in]  xt      XML mount-point in XML tree
  * @param[out] config  If '0' all data nodes in the mounted schema are read-only
@@ -554,7 +799,6 @@ controller_cligen_treeref_wrap(cligen_handle ch,
  * @retval    -1       Error
  * @see RFC 8528 (schema-mount) and RFC 8525 (yang-lib)
  * @see device_send_get_schema_list/device_state_recv_schema_list Backend fns for send/rcv
- * XXX 1. Recursion in clicon_rpc_get
  * XXX 2. Cache somewhere?
  */
 int
@@ -565,47 +809,28 @@ controller_cli_yang_mount(clixon_handle   h,
                           cxobj         **yanglib)
 {
     int    retval = -1;
-    cxobj *xt = NULL;
-    cxobj *xerr = NULL;
+    cxobj *xdevs = NULL;
     cxobj *xmodset;
-    cvec  *nsc = NULL;
-    char  *xpath = NULL;
     cbuf  *cb = NULL;
-    char  *str;
-    static int recursion = 0; /* clicon_rpc_get() -> bind back to here */
+    char  *devname;
+    static int recursion = 0; /* Guard against binding back to here */
 
     if (recursion)
         goto ok;
-    if ((cb = cbuf_new()) == NULL){
-        clixon_err(OE_XML, errno, "cbuf_new");
-        goto done;
-    }
-    if (xml_nsctx_node(xm, &nsc) < 0)
-        goto done;
-    if (xml2xpath(xm, nsc, 1, 1, &xpath) < 0)
-        goto done;
-    /* xm can be rooted somewhere else than "/devices" , such as /rpc-reply */
-    if ((str = strstr(xpath, "/devices/device")) == NULL)
+    if ((devname = xml_find_body(xml_parent(xm), "name")) == NULL)
         goto ok;
-    cprintf(cb, "%s", str);
     recursion++;
-    /* First xpath is on mount-point (to get config) */
-    if (clicon_rpc_get2(h, cbuf_get(cb), nsc, CONTENT_ALL, -1, "explicit", 0, &xt) < 0){
+    if (rpc_get_yanglib_mount_match(h, devname, 1, 1, &xdevs) < 0){
         recursion--;
         goto done;
     }
     recursion--;
-    if ((xerr = xpath_first(xt, NULL, "/rpc-error")) != NULL){
-        clixon_err_netconf(h, OE_XML, 0, xerr, "clicon_rpc_get");
+    if ((xmodset = xpath_first(xdevs, 0, "device/library/yang-library/module-set[name='mount']")) == NULL)
+        goto ok;
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_XML, errno, "cbuf_new");
         goto done;
     }
-    /* Second xpath is specific on module-set */
-    if (xml_nsctx_add(nsc, "yanglib", "urn:ietf:params:xml:ns:yang:ietf-yang-library") < 0)
-        goto done;
-    cprintf(cb, "/yanglib:yang-library/yanglib:module-set[yanglib:name='mount']");
-    if ((xmodset = xpath_first(xt, nsc, "%s", cbuf_get(cb))) == NULL)
-        goto ok;
-    cbuf_reset(cb);
     cprintf(cb, "<yang-library xmlns=\"urn:ietf:params:xml:ns:yang:ietf-yang-library\"/>");
     if (clixon_xml_parse_string(cbuf_get(cb), YB_NONE, NULL, yanglib, NULL) < 0)
         goto done;
@@ -616,14 +841,8 @@ controller_cli_yang_mount(clixon_handle   h,
  done:
     if (cb)
         cbuf_free(cb);
-    if (xpath)
-        free(xpath);
-    if (xt)
-        xml_free(xt);
-    if (xerr)
-        xml_free(xerr);
-    if (nsc)
-        xml_nsctx_free(nsc);
+    if (xdevs)
+        xml_free(xdevs);
     return retval;
 }
 
@@ -27,10 +27,12 @@
 #include <stdint.h>
 #include <inttypes.h>
 #include <string.h>
+#include <ctype.h>
 #include <errno.h>
 #include <syslog.h>
 #include <unistd.h>
 #include <fnmatch.h>
+#include <poll.h>
 #include <signal.h> /* matching strings */
 #include <sys/stat.h>
 #include <sys/time.h>
@@ -125,16 +127,92 @@ cli_apipath2xpath(clixon_handle h,
     return retval;
 }
 
+/*! Send get-device-yang-library rpc to backend
+ *
+ * @param[in]  h         Clixon handle
+ * @param[in]  pattern   Name glob pattern
+ * @param[in]  dedup     Only get yang-library once per fingerprint
+ * @param[out] xdevsp    XML on the form <devices><device><name>x</name><fingerprint>..
+ * @retval     0         OK
+ * @retval    -1         Error
+ */
+static int
+rpc_get_device_yang_library(clixon_handle h,
+                            char         *pattern,
+                            int           dedup,
+                            cxobj       **xdevsp)
+{
+    int    retval = -1;
+    cbuf  *cb = NULL;
+    cxobj *xtop = NULL;
+    cxobj *xrpc;
+    cxobj *xret = NULL;
+    cxobj *xreply;
+    cxobj *xerr;
+    cxobj *xdevs = NULL;
+    cxobj *xdev;
+
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_PLUGIN, errno, "cbuf_new");
+        goto done;
+    }
+    cprintf(cb, "<rpc xmlns=\"%s\" username=\"%s\" %s>",
+            NETCONF_BASE_NAMESPACE,
+            clicon_username_get(h),
+            NETCONF_MESSAGE_ID_ATTR);
+    cprintf(cb, "<get-device-yang-library xmlns=\"%s\">", CONTROLLER_NAMESPACE);
+    cprintf(cb, "<devname>%s</devname>", pattern);
+    if (dedup)
+        cprintf(cb, "<dedup>true</dedup>");
+    cprintf(cb, "</get-device-yang-library>");
+    cprintf(cb, "</rpc>");
+    if (clixon_xml_parse_string(cbuf_get(cb), YB_NONE, NULL, &xtop, NULL) < 0)
+        goto done;
+    xrpc = xml_child_i(xtop, 0);
+    if (clicon_rpc_netconf_xml(h, xrpc, &xret, NULL) < 0)
+        goto done;
+    if ((xerr = xpath_first(xret, NULL, "rpc-reply/rpc-error")) != NULL){
+        clixon_err_netconf(h, OE_XML, 0, xerr, "Get device yang-library");
+        goto done;
+    }
+    if ((xreply = xpath_first(xret, NULL, "rpc-reply")) != NULL &&
+        xml_find_type(xreply, NULL, "device", CX_ELMNT) != NULL){
+        if ((xdevs = xml_new("devices", NULL, CX_ELMNT)) == NULL)
+            goto done;
+        while ((xdev = xml_find_type(xreply, NULL, "device", CX_ELMNT)) != NULL){
+            if (xml_rm(xdev) < 0)
+                goto done;
+            if (xml_addsub(xdevs, xdev) < 0)
+                goto done;
+        }
+        *xdevsp = xdevs;
+        xdevs = NULL;
+    }
+    retval = 0;
+ done:
+    if (xdevs)
+        xml_free(xdevs);
+    if (xtop)
+        xml_free(xtop);
+    if (xret)
+        xml_free(xret);
+    if (cb)
+        cbuf_free(cb);
+    return retval;
+}
+
 /*! Send get yanglib of all mountpoints to backend and only return devices/yang-libs that match pattern
  *
+ * With yanglib set, the dedicated get-device-yang-library rpc is used instead of
+ * reading the device configs. The yang-library is then only included once per
+ * fingerprint, use device_yang_library_find() to get the yang-library of a device.
  * @param[in]  h         Clixon handle
  * @param[in]  pattern   Name glob pattern
  * @param[in]  single    pattern is a single device that can be used in an xpath
- * @param[in]  yanglib   0: only device name, 1: Also include config/yang-librarylib
+ * @param[in]  yanglib   0: only device name, 1: Also include fingerprint and library/yang-library
  * @param[out] xdevsp    XML on the form <devices><device><name>x</name>...
  * @retval     0         OK
  * @retval    -1         Error
- * XXX: see https://github.com/clicon/clixon/issues/485
  */
 int
 rpc_get_yanglib_mount_match(clixon_handle h,
@@ -154,6 +232,11 @@ rpc_get_yanglib_mount_match(clixon_handle h,
     cxobj *xerr;
 
     clixon_debug(1, "%s", __FUNCTION__);
+    if (yanglib){
+        if (rpc_get_device_yang_library(h, pattern, 1, xdevsp) < 0)
+            goto done;
+        goto ok;
+    }
     if ((cb = cbuf_new()) == NULL){
         clixon_err(OE_PLUGIN, errno, "cbuf_new");
         goto done;
@@ -167,17 +250,9 @@ rpc_get_yanglib_mount_match(clixon_handle h,
     cprintf(cb, " select=\"/ctrl:devices/ctrl:device");
     if (single)
         cprintf(cb, "[ctrl:name='%s']", pattern);
-    if (yanglib){
-        cprintf(cb, "/ctrl:config");
-        // XXX: see https://github.com/clicon/clixon/issues/485
-        //        cprintf(cb, "/yanglib:yang-library");
-    }
-    else
-        cprintf(cb, "/ctrl:name");
+    cprintf(cb, "/ctrl:name");
     cprintf(cb, "\"");
-    cprintf(cb, " xmlns:ctrl=\"%s\" xmlns:yanglib=\"urn:ietf:params:xml:ns:yang:ietf-yang-library\">",
-                    CONTROLLER_NAMESPACE);
-
+    cprintf(cb, " xmlns:ctrl=\"%s\">", CONTROLLER_NAMESPACE);
     cprintf(cb, "</filter>");
     cprintf(cb, "</get>");
     cprintf(cb, "</rpc>");
@@ -208,6 +283,7 @@ rpc_get_yanglib_mount_match(clixon_handle h,
             xml_rm(*xdevsp);
         }
     }
+ ok:
     retval = 0;
  done:
     if (xtop)
@@ -219,6 +295,151 @@ rpc_get_yanglib_mount_match(clixon_handle h,
     return retval;
 }
 
+/*! Find yang-library of a device in a result of rpc_get_yanglib_mount_match with yanglib
+ *
+ * The yang-library is either in the device itself or, if deduplicated, in another
+ * device with the same fingerprint
+ * @param[in]  xdevs     XML on the form <devices><device>...
+ * @param[in]  xdev      XML device
+ * @retval     xyanglib  yang-library XML
+ * @retval     NULL      Not found
+ */
+cxobj *
+device_yang_library_find(cxobj *xdevs,
+                         cxobj *xdev)
+{
+    cxobj *xyanglib;
+    char  *fp;
+
+    if ((xyanglib = xpath_first(xdev, 0, "library/yang-library")) != NULL)
+        return xyanglib;
+    if ((fp = xml_find_body(xdev, "fingerprint")) == NULL)
+        return NULL;
+    return xpath_first(xdevs, 0, "device[fingerprint='%s']/library/yang-library", fp);
+}
+
+/* Device cache: devices with only name, and devices with yang-library */
+static char *devices_cache_key[] = {"controller-devices-cache",
+                                    "controller-devices-yanglib-cache"};
+/* Cache generation of each device cache when read */
+static char *devices_cache_gen[] = {"controller-devices-cache-gen",
+                                    "controller-devices-yanglib-cache-gen"};
+
+/*! Read device-change notifications and increment device cache generation if any
+ *
+ * If there is no device-change notification socket, the generation is always incremented,
+ * ie the cache is not used
+ * @param[in]  h       Clixon handle
+ * @retval     gen     Current device cache generation
+ * @retval    -1       Error
+ */
+static int
+devices_cache_check(clixon_handle h)
+{
+    int                retval = -1;
+    int                s;
+    int                gen;
+    int                eof = 0;
+    struct clicon_msg *reply = NULL;
+    struct pollfd      pfd = {0,};
+
+    if ((gen = clicon_data_int_get(h, "controller-devices-cache-generation")) < 0)
+        gen = 0;
+    if ((s = clicon_data_int_get(h, "controller-device-notify-socket")) < 0)
+        gen++;
+    else {
+        pfd.fd = s;
+        pfd.events = POLLIN;
+        while (poll(&pfd, 1, 0) > 0){
+            if (clicon_msg_rcv(s, NULL, 0, &reply, &eof) < 0)
+                goto done;
+            if (reply){
+                free(reply);
+                reply = NULL;
+            }
+            gen++;
+            if (eof){
+                close(s);
+                clicon_data_int_set(h, "controller-device-notify-socket", -1);
+                break;
+            }
+        }
+    }
+    if (clicon_data_int_set(h, "controller-devices-cache-generation", gen) < 0)
+        goto done;
+    retval = gen;
+ done:
+    if (reply)
+        free(reply);
+    return retval;
+}
+
+/*! Get all devices, and optionally their yang-libs, from a cache in the CLI
+ *
+ * Same as rpc_get_yanglib_mount_match(h, "*", 0, yanglib, xdevsp), but reads from the
+ * backend only if a device has been added, removed or opened since last read, as
+ * signalled by a device-change notification.
+ * @param[in]  h         Clixon handle
+ * @param[in]  yanglib   0: only device name, 1: Also include fingerprint and library/yang-library
+ * @param[out] xdevsp    XML on the form <devices><device><name>x</name>..., or NULL
+ * @retval     0         OK
+ * @retval    -1         Error
+ * @note xdevsp is owned by the cache, do not free, and is valid until next call with same yanglib
+ */
+int
+rpc_get_yanglib_mount_cached(clixon_handle h,
+                             int           yanglib,
+                             cxobj       **xdevsp)
+{
+    int    retval = -1;
+    int    gen;
+    cxobj *xdevs = NULL;
+
+    yanglib = yanglib?1:0;
+    if ((gen = devices_cache_check(h)) < 0)
+        goto done;
+    if (clicon_data_int_get(h, devices_cache_gen[yanglib]) != gen){
+        if (clicon_ptr_get(h, devices_cache_key[yanglib], (void**)&xdevs) == 0 && xdevs){
+            xml_free(xdevs);
+            xdevs = NULL;
+        }
+        clicon_ptr_del(h, devices_cache_key[yanglib]);
+        if (rpc_get_yanglib_mount_match(h, "*", 0, yanglib, &xdevs) < 0)
+            goto done;
+        if (xdevs)
+            clicon_ptr_set(h, devices_cache_key[yanglib], xdevs);
+        if (clicon_data_int_set(h, devices_cache_gen[yanglib], gen) < 0)
+            goto done;
+    }
+    else if (clicon_ptr_get(h, devices_cache_key[yanglib], (void**)&xdevs) < 0)
+        xdevs = NULL;
+    *xdevsp = xdevs;
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Free device cache in the CLI
+ *
+ * @param[in]  h         Clixon handle
+ * @retval     0         OK
+ */
+int
+rpc_get_yanglib_mount_cache_free(clixon_handle h)
+{
+    cxobj *xdevs;
+    int    i;
+
+    for (i=0; i<2; i++){
+        xdevs = NULL;
+        if (clicon_ptr_get(h, devices_cache_key[i], (void**)&xdevs) == 0 && xdevs){
+            xml_free(xdevs);
+            clicon_ptr_del(h, devices_cache_key[i]);
+        }
+    }
+    return 0;
+}
+
 /*! Specialization of clixon cli_show_auto to handle device globs
  *
  * @param[in]  h    Clixon handle
@@ -871,6 +1092,10 @@ cli_rpc_controller_commit(clixon_handle h,
         cprintf(cb, "</service-instance>");
     }
     cprintf(cb, "<source>ds:%s</source>", source); /* Note add datastore prefix */
+    if ((cv = cvec_find(cvv, "window")) != NULL)
+        cprintf(cb, "<max-concurrent>%u</max-concurrent>", cv_uint32_get(cv));
+    if ((cv = cvec_find(cvv, "canary")) != NULL)
+        cprintf(cb, "<canary>%u</canary>", cv_uint32_get(cv));
     cprintf(cb, "</controller-commit>");
     cprintf(cb, "</rpc>");
     if (clixon_xml_parse_string(cbuf_get(cb), YB_NONE, NULL, &xtop, NULL) < 0)
@@ -1264,6 +1489,68 @@ cli_show_transactions(clixon_handle h,
     return retval;
 }
 
+/*! Show trace of a transaction as Chrome trace-event JSON
+ *
+ * @param[in] h
+ * @param[in] cvv  tid: Transaction id
+ * @param[in] argv
+ * @retval    0    OK
+ * @retval   -1    Error
+ */
+int
+cli_show_transaction_trace(clixon_handle h,
+                           cvec         *cvv,
+                           cvec         *argv)
+{
+    int     retval = -1;
+    cbuf   *cb = NULL;
+    cxobj  *xtop = NULL;
+    cxobj  *xrpc;
+    cxobj  *xret = NULL;
+    cxobj  *xerr;
+    cxobj  *x;
+    cg_var *cv;
+    char   *body;
+
+    if ((cv = cvec_find(cvv, "tid")) == NULL){
+        clixon_err(OE_PLUGIN, EINVAL, "tid not found");
+        goto done;
+    }
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_PLUGIN, errno, "cbuf_new");
+        goto done;
+    }
+    cprintf(cb, "<rpc xmlns=\"%s\" username=\"%s\" %s>",
+            NETCONF_BASE_NAMESPACE,
+            clicon_username_get(h),
+            NETCONF_MESSAGE_ID_ATTR);
+    cprintf(cb, "<transaction-trace xmlns=\"%s\">", CONTROLLER_NAMESPACE);
+    cprintf(cb, "<tid>%" PRIu64 "</tid>", cv_uint64_get(cv));
+    cprintf(cb, "</transaction-trace>");
+    cprintf(cb, "</rpc>");
+    if (clixon_xml_parse_string(cbuf_get(cb), YB_NONE, NULL, &xtop, NULL) < 0)
+        goto done;
+    xrpc = xml_child_i(xtop, 0);
+    if (clicon_rpc_netconf_xml(h, xrpc, &xret, NULL) < 0)
+        goto done;
+    if ((xerr = xpath_first(xret, NULL, "rpc-reply/rpc-error")) != NULL){
+        clixon_err_netconf(h, OE_XML, 0, xerr, "Get transaction trace");
+        goto done;
+    }
+    if ((x = xpath_first(xret, NULL, "rpc-reply/trace")) != NULL &&
+        (body = xml_body(x)) != NULL)
+        cligen_output(stdout, "%s\n", body);
+    retval = 0;
+ done:
+    if (xtop)
+        xml_free(xtop);
+    if (xret)
+        xml_free(xret);
+    if (cb)
+        cbuf_free(cb);
+    return retval;
+}
+
 /*! Show controller client sessions
  *
  * @param[in] h
@@ -1441,14 +1728,16 @@ send_pull_transient(clixon_handle h,
 
 /*! Compare device config types: running with last saved synced or current device (transient)
  *
+ * Device diffs are requested in pages of CONTROLLER_DIFF_PAGE devices.
  * @param[in]   h       Clixon handle
  * @param[in]   cvv     name: device pattern
  * @param[in]   argv    <format>        "text"|"xml"|"json"|"cli"|"netconf" (see format_enum)
  * @param[in]   dt1     First device config config
  * @param[in]   dt2     Second device config config
- * @param[out]  cbdiff  Diff string to show
+ * @param[out]  changed If given, only get summary: number of changed devices
  * @retval      0       OK
  * @retval     -1       Error
+ * Unless changed is given, diffs are shown as each page arrives
  */
 static int
 compare_device_config_type(clixon_handle      h,
@@ -1456,7 +1745,7 @@ compare_device_config_type(clixon_handle      h,
                            cvec              *argv,
                            device_config_type dt1,
                            device_config_type dt2,
-                           cbuf              *cbdiff)
+                           int               *changed)
 {
     int                retval = -1;
     enum format_enum   format;
@@ -1476,15 +1765,13 @@ compare_device_config_type(clixon_handle      h,
     cxobj            **vec = NULL;
     size_t             veclen;
     int                i;
+    char              *offset = NULL;
+    char              *str;
 
     if (cvec_len(argv) > 1){
         clixon_err(OE_PLUGIN, EINVAL, "Received %d arguments. Expected: <format>]", cvec_len(argv));
         goto done;
     }
-    if (cbdiff == NULL){
-        clixon_err(OE_PLUGIN, EINVAL, "cbdiff is NULL");
-        goto done;
-    }
     cv = cvec_i(argv, 0);
     formatstr = cv_string_get(cv);
     if ((int)(format = format_str2int(formatstr)) < 0){
@@ -1508,48 +1795,85 @@ compare_device_config_type(clixon_handle      h,
         clixon_err(OE_PLUGIN, errno, "cbuf_new");
         goto done;
     }
-    cprintf(cb, "<rpc xmlns=\"%s\" username=\"%s\" %s>",
-            NETCONF_BASE_NAMESPACE,
-            clicon_username_get(h),
-            NETCONF_MESSAGE_ID_ATTR);
-    cprintf(cb, "<datastore-diff xmlns=\"%s\">", CONTROLLER_NAMESPACE);
-    cprintf(cb, "<xpath>config</xpath>");
-    cprintf(cb, "<format>%s</format>", formatstr);
-    device_type = device_config_type_int2str(dt1);
-    cprintf(cb, "<devname>%s</devname>", pattern);
-    cprintf(cb, "<config-type1>%s</config-type1>", device_type);
-    device_type = device_config_type_int2str(dt2);
-    cprintf(cb, "<config-type2>%s</config-type2>", device_type);
-    cprintf(cb, "</datastore-diff>");
-    cprintf(cb, "</rpc>");
-    if (xtop){
-        xml_free(xtop);
-        xtop = NULL;
-    }
-    if (clixon_xml_parse_string(cbuf_get(cb), YB_NONE, NULL, &xtop, NULL) < 0)
-        goto done;
-    xrpc = xml_child_i(xtop, 0);
-    /* Send to backend */
-    if (clicon_rpc_netconf_xml(h, xrpc, &xret, NULL) < 0)
-        goto done;
-    if ((xreply = xpath_first(xret, NULL, "rpc-reply")) == NULL){
-        clixon_err(OE_CFG, 0, "Malformed rpc reply");
-        goto done;
-    }
-    if ((xerr = xpath_first(xreply, NULL, "rpc-error")) != NULL){
-        clixon_err_netconf(h, OE_XML, 0, xerr, "Get configuration");
-        goto done;
-    }
-    if (xpath_vec(xreply, NULL, "diff", &vec, &veclen) < 0)
-        goto done;
-    for (i=0; i<veclen; i++){
-        if ((xdiff = vec[i]) != NULL &&
-            xml_body(xdiff) != NULL){
-            cprintf(cbdiff, "%s", xml_body(xdiff));
+    if (changed)
+        *changed = 0;
+    do {
+        cbuf_reset(cb);
+        cprintf(cb, "<rpc xmlns=\"%s\" username=\"%s\" %s>",
+                NETCONF_BASE_NAMESPACE,
+                clicon_username_get(h),
+                NETCONF_MESSAGE_ID_ATTR);
+        cprintf(cb, "<datastore-diff xmlns=\"%s\">", CONTROLLER_NAMESPACE);
+        cprintf(cb, "<xpath>config</xpath>");
+        cprintf(cb, "<format>%s</format>", formatstr);
+        device_type = device_config_type_int2str(dt1);
+        cprintf(cb, "<devname>%s</devname>", pattern);
+        cprintf(cb, "<config-type1>%s</config-type1>", device_type);
+        device_type = device_config_type_int2str(dt2);
+        cprintf(cb, "<config-type2>%s</config-type2>", device_type);
+        if (changed)
+            cprintf(cb, "<summary>true</summary>");
+        if (offset)
+            cprintf(cb, "<offset>%s</offset>", offset);
+        cprintf(cb, "<limit>%d</limit>", CONTROLLER_DIFF_PAGE);
+        cprintf(cb, "</datastore-diff>");
+        cprintf(cb, "</rpc>");
+        if (xtop){
+            xml_free(xtop);
+            xtop = NULL;
         }
-    }
+        if (clixon_xml_parse_string(cbuf_get(cb), YB_NONE, NULL, &xtop, NULL) < 0)
+            goto done;
+        xrpc = xml_child_i(xtop, 0);
+        /* Send to backend */
+        if (xret){
+            xml_free(xret);
+            xret = NULL;
+        }
+        if (clicon_rpc_netconf_xml(h, xrpc, &xret, NULL) < 0)
+            goto done;
+        if ((xreply = xpath_first(xret, NULL, "rpc-reply")) == NULL){
+            clixon_err(OE_CFG, 0, "Malformed rpc reply");
+            goto done;
+        }
+        if ((xerr = xpath_first(xreply, NULL, "rpc-error")) != NULL){
+            clixon_err_netconf(h, OE_XML, 0, xerr, "Get configuration");
+            goto done;
+        }
+        if (vec){
+            free(vec);
+            vec = NULL;
+        }
+        if (changed){
+            if (xpath_vec(xreply, NULL, "device[changed='true']", &vec, &veclen) < 0)
+                goto done;
+            *changed += veclen;
+        }
+        else {
+            if (xpath_vec(xreply, NULL, "diff", &vec, &veclen) < 0)
+                goto done;
+            for (i=0; i<veclen; i++){
+                if ((xdiff = vec[i]) != NULL &&
+                    xml_body(xdiff) != NULL){
+                    cligen_output(stdout, "%s", xml_body(xdiff));
+                }
+            }
+        }
+        /* Next page */
+        if (offset){
+            free(offset);
+            offset = NULL;
+        }
+        if ((str = xml_find_body(xreply, "next-offset")) != NULL &&
+            (offset = strdup(str)) == NULL){
+            clixon_err(OE_UNIX, errno, "strdup");
+            goto done;
+        }
+    } while (offset != NULL);
     retval = 0;
  done:
+    if (offset)
+        free(offset);
     if (tidstr)
         free(tidstr);
     if (vec)
@@ -1669,21 +1993,12 @@ compare_device_db_sync(clixon_handle h,
                        cvec         *cvv,
                        cvec         *argv)
 {
-    int   retval = -1;
-    cbuf *cbdiff = NULL;
+    int retval = -1;
 
-    if ((cbdiff = cbuf_new()) == NULL){
-        clixon_err(OE_PLUGIN, errno, "cbuf_new");
+    if (compare_device_config_type(h, cvv, argv, DT_SYNCED, DT_RUNNING, NULL) < 0)
         goto done;
-    }
-    if (compare_device_config_type(h, cvv, argv, DT_SYNCED, DT_RUNNING, cbdiff) < 0)
-        goto done;
-    if (strlen(cbuf_get(cbdiff)))
-        cligen_output(stdout, "%s", cbuf_get(cbdiff));
     retval = 0;
  done:
-    if (cbdiff)
-        cbuf_free(cbdiff);
     return retval;
 }
 
@@ -1701,21 +2016,12 @@ compare_device_db_dev(clixon_handle h,
                       cvec         *cvv,
                       cvec         *argv)
 {
-    int   retval = -1;
-    cbuf *cbdiff = NULL;
+    int retval = -1;
 
-    if ((cbdiff = cbuf_new()) == NULL){
-        clixon_err(OE_PLUGIN, errno, "cbuf_new");
-        goto done;
-    }
-    if (compare_device_config_type(h, cvv, argv, DT_TRANSIENT, DT_RUNNING, cbdiff) < 0)
+    if (compare_device_config_type(h, cvv, argv, DT_TRANSIENT, DT_RUNNING, NULL) < 0)
         goto done;
-    if (strlen(cbuf_get(cbdiff)))
-        cligen_output(stdout, "%s", cbuf_get(cbdiff));
     retval = 0;
  done:
-    if (cbdiff)
-        cbuf_free(cbdiff);
     return retval;
 }
 
@@ -1733,33 +2039,70 @@ check_device_db(clixon_handle h,
                 cvec         *cvv,
                 cvec         *argv)
 {
-    int   retval = -1;
-    cbuf *cbdiff = NULL;
+    int retval = -1;
+    int changed = 0;
 
-    if ((cbdiff = cbuf_new()) == NULL){
-        clixon_err(OE_PLUGIN, errno, "cbuf_new");
+    if (compare_device_config_type(h, cvv, argv, DT_RUNNING, DT_TRANSIENT, &changed) < 0)
         goto done;
-    }
-    if (compare_device_config_type(h, cvv, argv, DT_RUNNING, DT_TRANSIENT, cbdiff) < 0)
-        goto done;
-    if (strlen(cbuf_get(cbdiff)))
+    if (changed)
         cligen_output(stdout, "device out-of-sync\n");
     else
         cligen_output(stdout, "OK\n");
     retval = 0;
  done:
-    if (cbdiff)
-        cbuf_free(cbdiff);
     return retval;
 }
 
-/*! Sub-routine for device dbxml: api-path to xml and send edit-config
+/*! Merge config tree of one device into config tree of all devices
+ *
+ * Device entries of different devices are distinct, so they are moved under the
+ * common devices container
+ * @param[in]  xtop   Config tree of all devices
+ * @param[in]  xtop1  Config tree of one device, children are moved to xtop
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+static int
+cli_dbxml_devs_merge(cxobj *xtop,
+                     cxobj *xtop1)
+{
+    int    retval = -1;
+    cxobj *x1;
+    cxobj *x;
+    cxobj *xc;
+
+    while ((x1 = xml_child_i_type(xtop1, 0, CX_ELMNT)) != NULL){
+        if (strcmp(xml_name(x1), "devices") == 0 &&
+            (x = xml_find_type(xtop, NULL, "devices", CX_ELMNT)) != NULL){
+            while ((xc = xml_child_i_type(x1, 0, CX_ELMNT)) != NULL){
+                if (xml_rm(xc) < 0)
+                    goto done;
+                if (xml_addsub(x, xc) < 0)
+                    goto done;
+            }
+            if (xml_purge(x1) < 0)
+                goto done;
+        }
+        else{
+            if (xml_rm(x1) < 0)
+                goto done;
+            if (xml_addsub(xtop, x1) < 0)
+                goto done;
+        }
+    }
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Sub-routine for device dbxml: api-path to xml and add it to edit-config tree
  *
  * @param[in]  h     Clixon handle
  * @param[in]  cvv   Vector of cli string and instantiated variables
  * @param[in]  op    Operation to perform on datastore
  * @param[in]  nsctx Namespace context for last value added
  * @param[in]  api_path
+ * @param[in]  xconfig  Config tree of edit-config, tree of api-path is merged into it
  * @retval     0     OK
  * @retval    -1     Error
  */
@@ -1769,7 +2112,8 @@ cli_dbxml_devs_sub(clixon_handle       h,
                    enum operation_type op,
                    cvec               *nsctx,
                    int                 cvvi,
-                   char               *api_path)
+                   char               *api_path,
+                   cxobj              *xconfig)
 {
     int        retval = -1;
     cxobj     *xtop = NULL;     /* xpath root */
@@ -1777,7 +2121,6 @@ cli_dbxml_devs_sub(clixon_handle       h,
     cxobj     *xerr = NULL;
     yang_stmt *yspec0;
     yang_stmt *yspec;
-    cbuf      *cb = NULL;
     yang_stmt *y = NULL;        /* yang spec of xpath */
     cg_var    *cv;
     int        ret;
@@ -1834,18 +2177,10 @@ cli_dbxml_devs_sub(clixon_handle       h,
         yspec = yspec0;
     if ((ret = xml_apply0(xbot, CX_ELMNT, identityref_add_ns, yspec)) < 0)
         goto done;
-    if ((cb = cbuf_new()) == NULL){
-        clixon_err(OE_XML, errno, "cbuf_new");
-        goto done;
-    }
-    if (clixon_xml2cbuf(cb, xtop, 0, 0, NULL, -1, 0) < 0)
-        goto done;
-    if (clicon_rpc_edit_config(h, "candidate", OP_NONE, cbuf_get(cb)) < 0)
+    if (cli_dbxml_devs_merge(xconfig, xtop) < 0)
         goto done;
     retval = 0;
  done:
-    if (cb)
-        cbuf_free(cb);
     if (xtop)
         xml_free(xtop);
     if (xerr)
@@ -1899,11 +2234,15 @@ cli_dbxml_devs(clixon_handle       h,
     char      *str;
     cbuf      *api_path_fmt_cb = NULL;    /* xml key format */
     int        i;
+    cxobj     *xconfig = NULL;  /* Config of all devices, sent in one edit-config */
+    cbuf      *cb = NULL;
 
     if (cvec_len(argv) < 1){
         clixon_err(OE_PLUGIN, EINVAL, "Requires first element to be xml key format string");
         goto done;
     }
+    if ((xconfig = xml_new(NETCONF_INPUT_CONFIG, NULL, CX_ELMNT)) == NULL)
+        goto done;
     if ((api_path_fmt_cb = cbuf_new()) == NULL){
         clixon_err(OE_UNIX, errno, "cbuf_new");
         goto done;
@@ -1941,7 +2280,7 @@ cli_dbxml_devs(clixon_handle       h,
         if (xdevs == NULL){
             if (cli_apipath(h, cvv, mtpoint, api_path_fmt, &cvvi, &api_path) < 0)
                 goto done;
-            if (cli_dbxml_devs_sub(h, cvv, op, nsctx, cvvi, api_path) < 0)
+            if (cli_dbxml_devs_sub(h, cvv, op, nsctx, cvvi, api_path, xconfig) < 0)
                 goto done;
         }
         else {
@@ -1952,7 +2291,7 @@ cli_dbxml_devs(clixon_handle       h,
                 cv_string_set(cv, devname); /* replace name */
                 if (cli_apipath(h, cvv, mtpoint, api_path_fmt, &cvvi, &api_path) < 0)
                     goto done;
-                if (cli_dbxml_devs_sub(h, cvv, op, nsctx, cvvi, api_path) < 0)
+                if (cli_dbxml_devs_sub(h, cvv, op, nsctx, cvvi, api_path, xconfig) < 0)
                     goto done;
                 if (api_path){
                     free(api_path);
@@ -1964,11 +2303,23 @@ cli_dbxml_devs(clixon_handle       h,
     else{
         if (cli_apipath(h, cvv, mtpoint, api_path_fmt, &cvvi, &api_path) < 0)
             goto done;
-        if (cli_dbxml_devs_sub(h, cvv, op, nsctx, cvvi, api_path) < 0)
+        if (cli_dbxml_devs_sub(h, cvv, op, nsctx, cvvi, api_path, xconfig) < 0)
             goto done;
     }
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_XML, errno, "cbuf_new");
+        goto done;
+    }
+    if (clixon_xml2cbuf(cb, xconfig, 0, 0, NULL, -1, 0) < 0)
+        goto done;
+    if (clicon_rpc_edit_config(h, "candidate", OP_NONE, cbuf_get(cb)) < 0)
+        goto done;
     retval = 0;
  done:
+    if (cb)
+        cbuf_free(cb);
+    if (xconfig)
+        xml_free(xconfig);
     if (api_path_fmt_cb)
         cbuf_free(api_path_fmt_cb);
     if (api_path_fmt01)
@@ -2055,8 +2406,482 @@ cli_auto_del_devs(clixon_handle h,
     return retval;
 }
 
+/* Stream load tag types */
+enum load_tag {
+    LT_START, /* <x> */
+    LT_END,   /* </x> */
+    LT_EMPTY, /* <x/> */
+    LT_OTHER  /* Comment, CDATA, processing instruction, etc */
+};
+
+/*! Stream load state
+ *
+ * The input is read in chunks and split at children of devices (the items), which are
+ * sent in batches, each within the root and devices start tags
+ */
+struct load_stream {
+    clixon_handle       ls_h;
+    FILE               *ls_fp;        /* Input file */
+    char                ls_buf[BUFSIZ]; /* Read buffer */
+    size_t              ls_pos;       /* Position of next unread byte in ls_buf */
+    size_t              ls_len;       /* Number of bytes in ls_buf */
+    enum operation_type ls_op;        /* Operation, replace only for first batch */
+    uint32_t            ls_batch;     /* Max items per batch */
+    cbuf               *ls_root;      /* Root start tag, eg <config> */
+    cbuf               *ls_rootname;  /* Root qname */
+    cbuf               *ls_devs;      /* Devices start tag */
+    cbuf               *ls_devsname;  /* Devices qname */
+    cbuf               *ls_items;     /* Items of pending batch */
+    int                 ls_nitems;    /* Number of items in pending batch */
+    cbuf               *ls_first;     /* Name of first item in pending batch */
+    cbuf               *ls_last;      /* Name of last item in pending batch */
+    int                 ls_sent;      /* Number of batches sent */
+    int                 ls_failed;    /* Number of failed batches */
+    int                 ls_total;     /* Total number of items */
+};
+
+/*! Read next chunk of stream load input if read buffer is empty
+ *
+ * @param[in]  ls    Stream load state
+ * @retval     1     OK, unread bytes in buffer
+ * @retval     0     End of file
+ * @retval    -1     Error
+ */
+static int
+load_stream_fill(struct load_stream *ls)
+{
+    if (ls->ls_pos < ls->ls_len)
+        return 1;
+    ls->ls_pos = 0;
+    if ((ls->ls_len = fread(ls->ls_buf, 1, sizeof(ls->ls_buf), ls->ls_fp)) == 0){
+        if (ferror(ls->ls_fp)){
+            clixon_err(OE_UNIX, errno, "fread");
+            return -1;
+        }
+        return 0;
+    }
+    return 1;
+}
+
+/*! Read one tag from stream, the initial '<' is already read
+ *
+ * Spans of the read buffer up to the terminating '>' are appended to the tag
+ * @param[in]  ls    Stream load state
+ * @param[out] cb    Tag including '<' and '>'
+ * @param[out] type  Tag type
+ * @retval     1     OK
+ * @retval     0     Unexpected end of file
+ * @retval    -1     Error
+ */
+static int
+load_stream_tag(struct load_stream *ls,
+                cbuf               *cb,
+                enum load_tag      *type)
+{
+    int    ret;
+    char  *buf;
+    size_t n;
+    size_t i;
+    int    quote = 0;
+    char  *str;
+    char  *start;
+    char  *end;
+
+    cbuf_reset(cb);
+    cprintf(cb, "<");
+    if ((ret = load_stream_fill(ls)) <= 0)
+        return ret;
+    switch (ls->ls_buf[ls->ls_pos]){
+    case '/':
+        *type = LT_END;
+        break;
+    case '?':
+    case '!':
+        *type = LT_OTHER;
+        break;
+    default:
+        *type = LT_START;
+        break;
+    }
+    while ((ret = load_stream_fill(ls)) > 0){
+        buf = ls->ls_buf + ls->ls_pos;
+        n = ls->ls_len - ls->ls_pos;
+        if (*type == LT_OTHER){
+            /* Terminators of comment, CDATA and PI all end with '>' */
+            if ((str = memchr(buf, '>', n)) != NULL)
+                n = str - buf + 1;
+        }
+        else {
+            for (i=0; i<n; i++){
+                if (quote){
+                    if (buf[i] == quote)
+                        quote = 0;
+                }
+                else if (buf[i] == '"' || buf[i] == '\'')
+                    quote = buf[i];
+                else if (buf[i] == '>')
+                    break;
+            }
+            str = i<n ? buf+i : NULL;
+            if (str)
+                n = i + 1;
+        }
+        if (cbuf_append_buf(cb, buf, n) < 0){
+            clixon_err(OE_UNIX, errno, "cbuf_append_buf");
+            return -1;
+        }
+        ls->ls_pos += n;
+        if (str == NULL)
+            continue;
+        str = cbuf_get(cb);
+        if (*type == LT_OTHER){
+            if (strncmp(str, "<!--", 4) == 0){
+                start = "<!--";
+                end = "-->";
+            }
+            else if (strncmp(str, "<![CDATA[", 9) == 0){
+                start = "<![CDATA[";
+                end = "]]>";
+            }
+            else if (str[1] == '?'){
+                start = "<?";
+                end = "?>";
+            }
+            else{
+                start = "<!";
+                end = ">";
+            }
+            if (cbuf_len(cb) >= strlen(start) + strlen(end) &&
+                strcmp(str + cbuf_len(cb) - strlen(end), end) == 0)
+                return 1;
+            continue;
+        }
+        if (*type == LT_START && str[cbuf_len(cb)-2] == '/')
+            *type = LT_EMPTY;
+        return 1;
+    }
+    return ret;
+}
+
+/*! Get qualified name of a start or end tag
+ *
+ * @param[in]  tag   Tag, eg <a:b x="y">
+ * @param[out] cb    Qualified name, eg a:b
+ */
+static void
+load_stream_qname(char *tag,
+                  cbuf *cb)
+{
+    char *str;
+
+    cbuf_reset(cb);
+    str = tag + 1;
+    if (*str == '/')
+        str++;
+    while (*str && !isspace(*str) && *str != '>' && *str != '/')
+        cprintf(cb, "%c", *str++);
+}
+
+/*! Get local name of a qualified name
+ */
+static char *
+load_stream_local(char *qname)
+{
+    char *str;
+
+    if ((str = strchr(qname, ':')) != NULL)
+        return str + 1;
+    return qname;
+}
+
+/*! Send pending batch of stream load as one edit-config
+ *
+ * A failed batch is reported and the load continues with the next batch, except if the
+ * first batch of a replace fails, since the candidate is then not replaced and merging
+ * the other batches would mix the old and new config.
+ * @param[in]  ls    Stream load state
+ * @param[in]  item  If set, a single root child that is not devices, else pending batch
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+load_stream_flush(struct load_stream *ls,
+                  cbuf               *item)
+{
+    int   retval = -1;
+    cbuf *cb = NULL;
+
+    if (item == NULL && ls->ls_nitems == 0)
+        goto ok;
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    cprintf(cb, "%s", cbuf_get(ls->ls_root));
+    if (item)
+        cprintf(cb, "%s", cbuf_get(item));
+    else
+        cprintf(cb, "%s%s</%s>", cbuf_get(ls->ls_devs), cbuf_get(ls->ls_items), cbuf_get(ls->ls_devsname));
+    cprintf(cb, "</%s>", cbuf_get(ls->ls_rootname));
+    ls->ls_sent++;
+    if (clicon_rpc_edit_config(ls->ls_h, "candidate", ls->ls_op, cbuf_get(cb)) < 0){
+        if (ls->ls_op == OP_REPLACE){
+            cligen_output(stderr, "Batch %d failed, load aborted\n", ls->ls_sent);
+            goto done;
+        }
+        ls->ls_failed++;
+        if (item)
+            cligen_output(stderr, "Batch %d failed: %s\n", ls->ls_sent, clixon_err_reason());
+        else
+            cligen_output(stderr, "Batch %d (%s..%s) failed: %s\n", ls->ls_sent,
+                          cbuf_get(ls->ls_first), cbuf_get(ls->ls_last), clixon_err_reason());
+        clixon_err_reset();
+    }
+    else if (item == NULL)
+        cligen_output(stdout, "Batch %d: %d devices (%s..%s)\n", ls->ls_sent, ls->ls_nitems,
+                      cbuf_get(ls->ls_first), cbuf_get(ls->ls_last));
+    /* Replace candidate only with first batch, then merge the rest */
+    if (ls->ls_op == OP_REPLACE)
+        ls->ls_op = OP_MERGE;
+    if (item == NULL){
+        ls->ls_total += ls->ls_nitems;
+        ls->ls_nitems = 0;
+        cbuf_reset(ls->ls_items);
+    }
+ ok:
+    retval = 0;
+ done:
+    if (cb)
+        cbuf_free(cb);
+    return retval;
+}
+
+/*! Add a complete item (child of devices) to pending batch, send it if full
+ *
+ * @param[in]  ls    Stream load state
+ * @param[in]  item  Item XML text
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+load_stream_item(struct load_stream *ls,
+                 cbuf               *item)
+{
+    char *name;
+    char *end;
+    cbuf *cbname;
+
+    cbname = ls->ls_nitems == 0 ? ls->ls_first : ls->ls_last;
+    cbuf_reset(cbname);
+    if ((name = strstr(cbuf_get(item), "<name>")) != NULL &&
+        (end = strstr(name, "</name>")) != NULL){
+        name += strlen("<name>");
+        cprintf(cbname, "%.*s", (int)(end - name), name);
+    }
+    if (ls->ls_nitems == 0){
+        cbuf_reset(ls->ls_last);
+        cprintf(ls->ls_last, "%s", cbuf_get(ls->ls_first));
+    }
+    cprintf(ls->ls_items, "%s", cbuf_get(item));
+    ls->ls_nitems++;
+    if (ls->ls_nitems >= ls->ls_batch ||
+        cbuf_len(ls->ls_items) >= CONTROLLER_LOAD_BATCH_BYTES)
+        if (load_stream_flush(ls, NULL) < 0)
+            return -1;
+    return 0;
+}
+
+/*! Stream load of XML config, split at devices/device boundaries
+ *
+ * The input is not parsed into a tree. Instead it is read in chunks and scanned for tags and the
+ * children of devices, such as device entries, are sent in edit-config batches of at
+ * most batch entries or CONTROLLER_LOAD_BATCH_BYTES bytes. Other children of the root
+ * are sent in separate edit-configs.
+ * @param[in]  h      Clixon handle
+ * @param[in]  fp     Input file
+ * @param[in]  op     Operation
+ * @param[in]  batch  Max devices per edit-config
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+static int
+cli_load_stream(clixon_handle       h,
+                FILE               *fp,
+                enum operation_type op,
+                uint32_t            batch)
+{
+    int                retval = -1;
+    struct load_stream ls = {0,};
+    cbuf              *cbtag = NULL;
+    cbuf              *cbname = NULL;
+    cbuf              *item = NULL;
+    enum load_tag      type;
+    int                depth = 0;
+    int                indevs = 0;
+    int                initem = 0;
+    int                ret;
+    char              *buf;
+    char              *str;
+    size_t             n;
+
+    ls.ls_h = h;
+    ls.ls_fp = fp;
+    ls.ls_op = op;
+    ls.ls_batch = batch;
+    if ((ls.ls_root = cbuf_new()) == NULL ||
+        (ls.ls_rootname = cbuf_new()) == NULL ||
+        (ls.ls_devs = cbuf_new()) == NULL ||
+        (ls.ls_devsname = cbuf_new()) == NULL ||
+        (ls.ls_items = cbuf_new()) == NULL ||
+        (ls.ls_first = cbuf_new()) == NULL ||
+        (ls.ls_last = cbuf_new()) == NULL ||
+        (cbtag = cbuf_new()) == NULL ||
+        (cbname = cbuf_new()) == NULL ||
+        (item = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    while ((ret = load_stream_fill(&ls)) > 0){
+        /* Text up to next tag */
+        buf = ls.ls_buf + ls.ls_pos;
+        n = ls.ls_len - ls.ls_pos;
+        if ((str = memchr(buf, '<', n)) != NULL)
+            n = str - buf;
+        if (initem && n && cbuf_append_buf(item, buf, n) < 0){
+            clixon_err(OE_UNIX, errno, "cbuf_append_buf");
+            goto done;
+        }
+        ls.ls_pos += n;
+        if (str == NULL)
+            continue;
+        ls.ls_pos++; /* '<' */
+        if ((ret = load_stream_tag(&ls, cbtag, &type)) < 0)
+            goto done;
+        if (ret == 0){
+            clixon_err(OE_XML, 0, "Unexpected end of file in tag");
+            goto done;
+        }
+        switch (type){
+        case LT_OTHER:
+            if (initem)
+                cprintf(item, "%s", cbuf_get(cbtag));
+            break;
+        case LT_START:
+        case LT_EMPTY:
+            if (depth == 0){
+                load_stream_qname(cbuf_get(cbtag), ls.ls_rootname);
+                cprintf(ls.ls_root, "%s", cbuf_get(cbtag));
+                if (type == LT_EMPTY)
+                    goto ok;
+            }
+            else if (depth == 1){
+                load_stream_qname(cbuf_get(cbtag), cbname);
+                if (strcmp(load_stream_local(cbuf_get(cbname)), "devices") == 0){
+                    if (type == LT_START){
+                        indevs = 1;
+                        cbuf_reset(ls.ls_devs);
+                        cprintf(ls.ls_devs, "%s", cbuf_get(cbtag));
+                        cbuf_reset(ls.ls_devsname);
+                        cprintf(ls.ls_devsname, "%s", cbuf_get(cbname));
+                    }
+                }
+                else{ /* Other root child: single item */
+                    cbuf_reset(item);
+                    cprintf(item, "%s", cbuf_get(cbtag));
+                    initem = 1;
+                    if (type == LT_EMPTY){
+                        if (load_stream_flush(&ls, item) < 0)
+                            goto done;
+                        initem = 0;
+                    }
+                }
+            }
+            else if (depth == 2 && indevs){
+                cbuf_reset(item);
+                cprintf(item, "%s", cbuf_get(cbtag));
+                initem = 1;
+                if (type == LT_EMPTY){
+                    if (load_stream_item(&ls, item) < 0)
+                        goto done;
+                    initem = 0;
+                }
+            }
+            else if (initem)
+                cprintf(item, "%s", cbuf_get(cbtag));
+            if (type == LT_START)
+                depth++;
+            break;
+        case LT_END:
+            if (depth == 0){
+                clixon_err(OE_XML, 0, "Unexpected end tag %s", cbuf_get(cbtag));
+                goto done;
+            }
+            depth--;
+            if (initem)
+                cprintf(item, "%s", cbuf_get(cbtag));
+            if (depth == 2 && indevs){
+                if (load_stream_item(&ls, item) < 0)
+                    goto done;
+                initem = 0;
+            }
+            else if (depth == 1){
+                if (indevs){
+                    if (load_stream_flush(&ls, NULL) < 0)
+                        goto done;
+                    indevs = 0;
+                }
+                else if (initem){
+                    if (load_stream_flush(&ls, item) < 0)
+                        goto done;
+                    initem = 0;
+                }
+            }
+            else if (depth == 0)
+                goto ok;
+            break;
+        }
+    }
+    if (ret < 0)
+        goto done;
+    if (depth != 0 || cbuf_len(ls.ls_rootname) == 0){
+        clixon_err(OE_XML, 0, "No complete XML in file");
+        goto done;
+    }
+ ok:
+    cligen_output(stdout, "Loaded %d devices in %d batches\n", ls.ls_total, ls.ls_sent);
+    if (ls.ls_failed){
+        clixon_err(OE_XML, 0, "%d of %d batches failed", ls.ls_failed, ls.ls_sent);
+        goto done;
+    }
+    retval = 0;
+ done:
+    if (ls.ls_root)
+        cbuf_free(ls.ls_root);
+    if (ls.ls_rootname)
+        cbuf_free(ls.ls_rootname);
+    if (ls.ls_devs)
+        cbuf_free(ls.ls_devs);
+    if (ls.ls_devsname)
+        cbuf_free(ls.ls_devsname);
+    if (ls.ls_items)
+        cbuf_free(ls.ls_items);
+    if (ls.ls_first)
+        cbuf_free(ls.ls_first);
+    if (ls.ls_last)
+        cbuf_free(ls.ls_last);
+    if (cbtag)
+        cbuf_free(cbtag);
+    if (cbname)
+        cbuf_free(cbname);
+    if (item)
+        cbuf_free(item);
+    return retval;
+}
+
 /*! Merge datastore xml entry, specialization for controller devices
  *
+ * If batch is given, the XML file is not parsed as a whole but streamed and sent in
+ * edit-configs of at most batch devices each, see cli_load_stream
  * @param[in]  h    Clixon handle
  * @param[in]  cvv0 Vector of cli string and instantiated variables
  * @param[in]  argv Vector. First element xml key format string, eg "/aaa/%s"
@@ -2078,6 +2903,7 @@ cli_auto_load_devs(clixon_handle h,
     cxobj              *xt = NULL;
     cxobj              *xerr = NULL;
     cbuf               *cb = NULL;
+    uint32_t            batch = 0;
     int                 ret;
 
     if ((cvv = cvec_append(clicon_data_cvec_get(h, "cli-edit-cvv"), cvv0)) == NULL)
@@ -2090,6 +2916,16 @@ cli_auto_load_devs(clixon_handle h,
         if ((format = format_str2int(cv_string_get(cv))) < 0)
             goto done;
     }
+    if ((cv = cvec_find(cvv, "batch")) != NULL){
+        if ((batch = cv_uint32_get(cv)) == 0){
+            clixon_err(OE_CFG, EINVAL, "batch must be greater than 0");
+            goto done;
+        }
+        if (format != FORMAT_XML){
+            clixon_err(OE_PLUGIN, 0, "batch load only implemented for xml");
+            goto done;
+        }
+    }
     if ((cv = cvec_find(cvv, "filename")) != NULL){
         filename = cv_string_get(cv);
         if (stat(filename, &st) < 0){
@@ -2102,6 +2938,11 @@ cli_auto_load_devs(clixon_handle h,
             goto done;
         }
     }
+    if (batch){
+        if (cli_load_stream(h, fp, op, batch) < 0)
+            goto done;
+        goto ok;
+    }
     /* XXX Do without YANG (for the time being) */
     switch (format){
     case FORMAT_XML:
@@ -2145,6 +2986,7 @@ cli_auto_load_devs(clixon_handle h,
                                op,
                                cbuf_get(cb)) < 0)
         goto done;
+ ok:
     retval = 0;
  done:
     if (cb)
@@ -2198,9 +3040,12 @@ cli_apply_device_template(clixon_handle h,
     cxobj  *xret = NULL;
     cxobj  *xreply;
     cxobj  *xerr;
+    cxobj  *x;
     char   *devs = "*";
     char   *templ;
     char   *var;
+    char   *devname;
+    char   *reason;
 
     if (argv != NULL){
         clixon_err(OE_PLUGIN, EINVAL, "requires expected NULL");
@@ -2255,6 +3100,16 @@ cli_apply_device_template(clixon_handle h,
         clixon_err_netconf(h, OE_XML, 0, xerr, "Get configuration");
         goto done;
     }
+    /* Devices where template was not applied */
+    x = NULL;
+    while ((x = xml_child_each(xreply, x, CX_ELMNT)) != NULL) {
+        if (strcmp(xml_name(x), "failed") != 0)
+            continue;
+        if ((devname = xml_find_body(x, "device")) == NULL)
+            continue;
+        reason = xml_find_body(x, "reason");
+        cligen_output(stderr, "Template not applied on %s: %s\n", devname, reason?reason:"");
+    }
     retval = 0;
  done:
     if (cb)
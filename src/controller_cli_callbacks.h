@@ -45,12 +45,16 @@ extern "C" {
 #endif
 
 int rpc_get_yanglib_mount_match(clixon_handle h, char *pattern, int single, int yanglib, cxobj **xdevsp);
+cxobj *device_yang_library_find(cxobj *xdevs, cxobj *xdev);
+int rpc_get_yanglib_mount_cached(clixon_handle h, int yanglib, cxobj **xdevsp);
+int rpc_get_yanglib_mount_cache_free(clixon_handle h);
 int cli_show_auto_devs(clixon_handle h, cvec *cvv, cvec *argv);
 int cli_rpc_pull(clixon_handle h, cvec *cvv, cvec *argv);
 int cli_rpc_controller_commit(clixon_handle h, cvec *cvv, cvec *argv);
 int cli_connection_change(clixon_handle h, cvec *cvv, cvec *argv);
 int cli_show_devices(clixon_handle h, cvec *cvv, cvec *argv);
 int cli_show_transactions(clixon_handle h, cvec *cvv, cvec *argv);
+int cli_show_transaction_trace(clixon_handle h, cvec *cvv, cvec *argv);
 int compare_device_db_sync(clixon_handle h, cvec *cvv, cvec *argv);
 int compare_device_db_dev(clixon_handle h, cvec *cvv, cvec *argv);
 int check_device_db(clixon_handle h, cvec *cvv, cvec *argv);
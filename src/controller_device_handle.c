@@ -38,12 +38,15 @@
 #endif
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <unistd.h>
+#include <inttypes.h>
 #include <syslog.h>
 #include <string.h>
 #include <errno.h>
 #include <assert.h>
 #include <sys/stat.h>
+#include <sys/time.h>
 #include <netinet/in.h>
 #include <signal.h>
 
@@ -66,6 +69,64 @@
 
 #define devhandle(dh) (assert(device_handle_check(dh)==0),(struct controller_device_handle *)(dh))
 
+/* Sub-buckets per power of two of latency histograms, ie max relative error 25% */
+#define DEVICE_HIST_SUB 4
+
+/* Number of latency histogram buckets, covering 0 - 2^32-1 us */
+#define DEVICE_HIST_NR  (31*DEVICE_HIST_SUB)
+
+/* Max number of outstanding requests of a device tracked for round-trip time */
+#define DEVICE_STATS_PENDING 8
+
+/*! Observed reply latency of one connection state
+ *
+ * @see device_handle_latency_add
+ */
+struct device_latency {
+    uint32_t           dl_samples;     /* Number of samples */
+    double             dl_ewma;        /* Exponentially weighted moving average in ms */
+    double             dl_p99;         /* Streaming estimate of 99th percentile in ms */
+};
+
+/*! HDR-style log-linear latency histogram in us
+ *
+ * Values below DEVICE_HIST_SUB have one bucket each, above that each power of two is split
+ * in DEVICE_HIST_SUB buckets.
+ * @see device_hist_add
+ */
+struct device_hist {
+    uint64_t           dhi_count;      /* Number of samples */
+    uint64_t           dhi_sum;        /* Sum of samples in us */
+    uint32_t           dhi_min;        /* Min sample in us */
+    uint32_t           dhi_max;        /* Max sample in us */
+    uint32_t          *dhi_bucket;     /* DEVICE_HIST_NR counters, allocated at first sample */
+};
+
+/*! Request sent to device waiting for reply
+ */
+struct device_request {
+    device_rpc         dr_rpc;         /* RPC type of request */
+    struct timeval     dr_time;        /* Time when request was sent */
+};
+
+/*! NETCONF message statistics of a device
+ *
+ * @see device_handle_stats2xml
+ */
+struct device_stats {
+    uint64_t           ds_in_bytes;    /* Bytes received */
+    uint64_t           ds_out_bytes;   /* Bytes sent */
+    uint64_t           ds_in_msgs;     /* Messages received */
+    uint64_t           ds_out_msgs;    /* Messages sent */
+    uint64_t           ds_requests[DEVICE_RPC_NR]; /* Requests sent per RPC type */
+    struct device_hist ds_parse;       /* Parse time of received messages */
+    struct device_hist ds_bind;        /* YANG bind time of received configs */
+    struct device_hist ds_rtt[DEVICE_RPC_NR]; /* Round-trip time per RPC type */
+    struct device_request ds_pending[DEVICE_STATS_PENDING]; /* Ring of requests waiting for reply */
+    int                ds_pending_first; /* First (oldest) request in ring */
+    int                ds_pending_nr;  /* Number of requests in ring */
+};
+
 /*! Internal structure of clixon controller device handle.
  */
 struct controller_device_handle{
@@ -88,12 +149,42 @@ struct controller_device_handle{
     netconf_framing_type cdh_framing_type; /* Netconf framing type of device */
     cxobj             *cdh_xcaps;      /* Capabilities as XML tree */
     cxobj             *cdh_yang_lib;   /* RFC 8525 yang-library module list */
+    char              *cdh_yang_lib_fp; /* Fingerprint of yang_lib, computed on demand */
     struct timeval     cdh_sync_time;  /* Time when last sync (0 if unsynched) */
     int                cdh_nr_schemas; /* How many schemas from this device */
     char              *cdh_schema_name; /* Pending schema name */
     char              *cdh_schema_rev;  /* Pending schema revision */
     char              *cdh_logmsg;      /* Error log message / reason of failed open */
     cbuf              *cdh_outmsg;      /* Pending outgoing netconf message for delayed output */
+    char              *cdh_conn_dest;   /* Connect destination, eg user@addr, set when pending */
+    int                cdh_stricthostkey; /* Connect with strict hostkey checking (ssh) */
+    struct timeval     cdh_request_time; /* Time when waiting for reply started */
+    struct device_latency cdh_latency[CONN_STATE_NR]; /* Observed reply latency per state */
+    uint32_t           cdh_reconnect_backoff;     /* Initial auto-reconnect backoff in s, 0: disabled */
+    uint32_t           cdh_reconnect_backoff_max; /* Max auto-reconnect backoff in s */
+    uint32_t           cdh_reconnect_attempts;    /* Auto-reconnect attempts since last open */
+    struct timeval     cdh_reconnect_next;        /* Time of next auto-reconnect attempt, 0 if none */
+    char              *cdh_warm_hash;   /* Persisted SYNCED hash, set while warm restart sync pending */
+    char              *cdh_content_id;  /* RFC 8525 content-id of yang_lib, if discovered */
+    char              *cdh_content_id_pending; /* Received content-id, pending schema discovery */
+    struct device_stats cdh_stats;      /* NETCONF message statistics */
+};
+
+/*! Mapping between enum device_rpc and yang statistics rpc name
+ *
+ * @see clixon-controller.yang statistics
+ */
+static const map_str2int drmap[] = {
+    {"get-config",      DR_GET_CONFIG},
+    {"get-schema",      DR_GET_SCHEMA},
+    {"get",             DR_GET},
+    {"lock",            DR_LOCK},
+    {"unlock",          DR_UNLOCK},
+    {"edit-config",     DR_EDIT_CONFIG},
+    {"validate",        DR_VALIDATE},
+    {"commit",          DR_COMMIT},
+    {"discard-changes", DR_DISCARD_CHANGES},
+    {NULL,              -1}
 };
 
 /*! Check struct magic number for sanity checks
@@ -111,6 +202,43 @@ device_handle_check(device_handle dh)
     return cdh->cdh_magic == CLIXON_CLIENT_MAGIC ? 0 : -1;
 }
 
+/*! Send device-change notification
+ *
+ * Sent when a device handle is added or removed, or when a device is opened, since its
+ * yang-library may then have changed. Used by clients to invalidate device caches.
+ * @param[in]  h       Clixon handle
+ * @param[in]  name    Device name
+ * @param[in]  change  ADDED, REMOVED or OPEN
+ * @retval     0       OK
+ * @retval    -1       Error
+ */
+static int
+device_handle_change_notify(clixon_handle h,
+                            char         *name,
+                            char         *change)
+{
+    int   retval = -1;
+    cbuf *cb = NULL;
+
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    cprintf(cb, "<device-change xmlns=\"%s\">", CONTROLLER_NAMESPACE);
+    cprintf(cb, "<name>");
+    xml_chardata_cbuf_append(cb, name);
+    cprintf(cb, "</name>");
+    cprintf(cb, "<change>%s</change>", change);
+    cprintf(cb, "</device-change>");
+    if (stream_notify(h, "controller-device-change", "%s", cbuf_get(cb)) < 0)
+        goto done;
+    retval = 0;
+ done:
+    if (cb)
+        cbuf_free(cb);
+    return retval;
+}
+
 /*! Create new controller device handle given clixon handle and add it to global list
  *
  * A new device handle is created when a connection is made, also passively in
@@ -124,6 +252,7 @@ device_handle_new(clixon_handle h,
 {
     struct controller_device_handle *cdh = NULL;
     struct controller_device_handle *cdh_list = NULL;
+    clicon_hash_t                   *index = NULL;
     size_t                           sz;
 
     clixon_debug(1, "%s", __FUNCTION__);
@@ -149,6 +278,20 @@ device_handle_new(clixon_handle h,
     (void)clicon_ptr_get(h, "client-list", (void**)&cdh_list);
     ADDQ(cdh, cdh_list);
     clicon_ptr_set(h, "client-list", (void*)cdh_list);
+    /* Add to name index */
+    if (clicon_ptr_get(h, "client-index", (void**)&index) < 0 || index == NULL){
+        if ((index = clicon_hash_init()) == NULL)
+            return NULL;
+        clicon_ptr_set(h, "client-index", (void*)index);
+    }
+    if (clicon_hash_add(index, cdh->cdh_name, &cdh, sizeof(cdh)) == NULL)
+        return NULL;
+    /* The handle is already added, a failed notification is not a device error */
+    if (device_handle_change_notify(h, cdh->cdh_name, "ADDED") < 0){
+        clixon_log(h, LOG_WARNING, "%s: device-change notification of %s failed: %s",
+                   __FUNCTION__, cdh->cdh_name, clixon_err_reason());
+        clixon_err_reset();
+    }
     return cdh;
 }
 
@@ -157,6 +300,8 @@ device_handle_new(clixon_handle h,
 static int
 device_handle_free1(struct controller_device_handle *cdh)
 {
+    int i;
+
     if (cdh->cdh_name)
         free(cdh->cdh_name);
     if (cdh->cdh_frame_buf)
@@ -165,6 +310,8 @@ device_handle_free1(struct controller_device_handle *cdh)
         xml_free(cdh->cdh_xcaps);
     if (cdh->cdh_yang_lib)
         xml_free(cdh->cdh_yang_lib);
+    if (cdh->cdh_yang_lib_fp)
+        free(cdh->cdh_yang_lib_fp);
     if (cdh->cdh_logmsg)
         free(cdh->cdh_logmsg);
     if (cdh->cdh_schema_name)
@@ -173,6 +320,21 @@ device_handle_free1(struct controller_device_handle *cdh)
         free(cdh->cdh_schema_rev);
     if (cdh->cdh_outmsg)
         cbuf_free(cdh->cdh_outmsg);
+    if (cdh->cdh_conn_dest)
+        free(cdh->cdh_conn_dest);
+    if (cdh->cdh_warm_hash)
+        free(cdh->cdh_warm_hash);
+    if (cdh->cdh_content_id)
+        free(cdh->cdh_content_id);
+    if (cdh->cdh_content_id_pending)
+        free(cdh->cdh_content_id_pending);
+    if (cdh->cdh_stats.ds_parse.dhi_bucket)
+        free(cdh->cdh_stats.ds_parse.dhi_bucket);
+    if (cdh->cdh_stats.ds_bind.dhi_bucket)
+        free(cdh->cdh_stats.ds_bind.dhi_bucket);
+    for (i=0; i<DEVICE_RPC_NR; i++)
+        if (cdh->cdh_stats.ds_rtt[i].dhi_bucket)
+            free(cdh->cdh_stats.ds_rtt[i].dhi_bucket);
     free(cdh);
     return 0;
 }
@@ -189,8 +351,12 @@ device_handle_free(device_handle dh)
     struct controller_device_handle *cdh_list = NULL;
     struct controller_device_handle *c;
     clixon_handle                    h;
+    clicon_hash_t                   *index = NULL;
 
     h = (clixon_handle)cdh->cdh_h;
+    if (clicon_ptr_get(h, "client-index", (void**)&index) == 0 && index != NULL)
+        clicon_hash_del(index, cdh->cdh_name);
+    device_handle_change_notify(h, cdh->cdh_name, "REMOVED");
     clicon_ptr_get(h, "client-list", (void**)&cdh_list);
     if ((c = cdh_list) != NULL) {
         do {
@@ -215,6 +381,7 @@ device_handle_free_all(clixon_handle h)
 {
     struct controller_device_handle *cdh_list = NULL;
     struct controller_device_handle *c;
+    clicon_hash_t                   *index = NULL;
 
     clicon_ptr_get(h, "client-list", (void**)&cdh_list);
     while ((c = cdh_list) != NULL) {
@@ -222,11 +389,16 @@ device_handle_free_all(clixon_handle h)
         device_handle_free1(c);
     }
     clicon_ptr_set(h, "client-list", (void*)cdh_list);
+    if (clicon_ptr_get(h, "client-index", (void**)&index) == 0 && index != NULL){
+        clicon_hash_free(index);
+        clicon_ptr_del(h, "client-index");
+    }
     return 0;
 }
 
 /*! Find clixon-client given name
  *
+ * Uses the name index of device handles, see device_handle_new
  * @param[in]  h     Clixon  handle
  * @param[in]  name  Client name
  * @retval     dh    Device handle
@@ -237,7 +409,16 @@ device_handle_find(clixon_handle h,
 {
     struct controller_device_handle *cdh_list = NULL;
     struct controller_device_handle *c = NULL;
-
+    clicon_hash_t                   *index = NULL;
+    void                            *p;
+    size_t                           vlen;
+
+    /* Name index */
+    if (clicon_ptr_get(h, "client-index", (void**)&index) == 0 && index != NULL){
+        if ((p = clicon_hash_value(index, (char*)name, &vlen)) != NULL)
+            return *(struct controller_device_handle **)p;
+        return NULL;
+    }
     if (clicon_ptr_get(h, "client-list", (void**)&cdh_list) == 0 &&
         (c = cdh_list) != NULL) {
         do {
@@ -369,6 +550,8 @@ device_handle_disconnect(device_handle dh)
         cdh->cdh_socket = -1;
         break;
     }
+    /* Replies of outstanding requests will not arrive */
+    cdh->cdh_stats.ds_pending_nr = 0;
     retval = 0;
  done:
     clixon_debug(1, "%s retval:%d", __FUNCTION__, retval);
@@ -535,6 +718,8 @@ device_handle_conn_state_set(device_handle dh,
         free(cdh->cdh_logmsg);
         cdh->cdh_logmsg = NULL;
     }
+    if (state == CS_OPEN && cdh->cdh_conn_state != CS_OPEN)
+        device_handle_change_notify(cdh->cdh_h, cdh->cdh_name, "OPEN");
     cdh->cdh_conn_state = state;
     device_handle_conn_time_set(dh, NULL);
     return 0;
@@ -724,6 +909,29 @@ device_handle_capabilities_find(clixon_handle dh,
     return x?1:0;
 }
 
+/*! Find first capability with a prefix, eg with parameters
+ *
+ * @param[in]  dh     Device handle
+ * @param[in]  prefix Capability prefix, eg urn:ietf:params:netconf:capability:yang-library:1.1
+ * @retval     cap    Capability string including parameters
+ * @retval     NULL   Not found
+ */
+char *
+device_handle_capabilities_prefix(device_handle dh,
+                                  const char   *prefix)
+{
+    struct controller_device_handle *cdh = devhandle(dh);
+    cxobj                           *x = NULL;
+    char                            *body;
+
+    while ((x = xml_child_each(cdh->cdh_xcaps, x, -1)) != NULL) {
+        if ((body = xml_body(x)) != NULL &&
+            strncmp(prefix, body, strlen(prefix)) == 0)
+            return body;
+    }
+    return NULL;
+}
+
 /*! Get RFC 8525 yang-lib as xml tree
  *
  * @param[in]  dh     Device handle
@@ -757,6 +965,10 @@ device_handle_yang_lib_set(device_handle dh,
     if (cdh->cdh_yang_lib != NULL)
         xml_free(cdh->cdh_yang_lib);
     cdh->cdh_yang_lib = xylib;
+    if (cdh->cdh_yang_lib_fp){
+        free(cdh->cdh_yang_lib_fp);
+        cdh->cdh_yang_lib_fp = NULL;
+    }
     return 0;
 }
 
@@ -806,6 +1018,10 @@ device_handle_yang_lib_append(device_handle dh,
         cdh->cdh_yang_lib = xylib;
         xylib = NULL;
     }
+    if (cdh->cdh_yang_lib_fp){
+        free(cdh->cdh_yang_lib_fp);
+        cdh->cdh_yang_lib_fp = NULL;
+    }
     retval = 0;
  done:
     if (xylib)
@@ -813,6 +1029,47 @@ device_handle_yang_lib_append(device_handle dh,
     return retval;
 }
 
+/*! Get fingerprint of RFC 8525 yang library
+ *
+ * 64-bit FNV-1a over the non-pretty XML of the yang library. Devices with equal
+ * yang libraries have equal fingerprints.
+ * Computed on first call and kept until yang library is changed.
+ * @param[in]  dh     Device handle
+ * @retval     fp     Fingerprint as hex string
+ * @retval     NULL   No yang library, or error
+ */
+char *
+device_handle_yang_lib_fingerprint(device_handle dh)
+{
+    struct controller_device_handle *cdh = devhandle(dh);
+    cbuf                            *cb = NULL;
+    char                            *str;
+    uint64_t                         fnv = 0xcbf29ce484222325ULL;
+    char                             fp[32];
+
+    if (cdh->cdh_yang_lib_fp != NULL || cdh->cdh_yang_lib == NULL)
+        goto done;
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    if (clixon_xml2cbuf(cb, cdh->cdh_yang_lib, 0, 0, NULL, -1, 0) < 0)
+        goto done;
+    for (str = cbuf_get(cb); *str; str++){
+        fnv ^= (unsigned char)*str;
+        fnv *= 0x100000001b3ULL;
+    }
+    snprintf(fp, sizeof(fp), "%016" PRIx64, fnv);
+    if ((cdh->cdh_yang_lib_fp = strdup(fp)) == NULL){
+        clixon_err(OE_UNIX, errno, "strdup");
+        goto done;
+    }
+ done:
+    if (cb)
+        cbuf_free(cb);
+    return cdh->cdh_yang_lib_fp;
+}
+
 /*! Get sync timestamp
  *
  * @param[in]  dh     Device handle
@@ -1000,4 +1257,666 @@ device_handle_outmsg_set(device_handle dh,
     return 0;
 }
 
+/*! Get connect destination
+ *
+ * @param[in]  dh     Device handle
+ * @retval     dest   Destination, eg user@addr
+ * @retval     NULL
+ */
+char*
+device_handle_conn_dest_get(device_handle dh)
+{
+    struct controller_device_handle *cdh = devhandle(dh);
+
+    return cdh->cdh_conn_dest;
+}
+
+/*! Set connect destination and hostkey checking, used when connect is scheduled
+ *
+ * @param[in]  dh            Device handle
+ * @param[in]  dest          Destination, eg user@addr (is copied)
+ * @param[in]  stricthostkey If set ensure strict hostkey checking
+ * @retval     0             OK
+ * @retval    -1             Error
+ */
+int
+device_handle_conn_dest_set(device_handle dh,
+                            const char   *dest,
+                            int           stricthostkey)
+{
+    struct controller_device_handle *cdh = devhandle(dh);
+
+    if (cdh->cdh_conn_dest){
+        free(cdh->cdh_conn_dest);
+        cdh->cdh_conn_dest = NULL;
+    }
+    if (dest && (cdh->cdh_conn_dest = strdup(dest)) == NULL){
+        clixon_err(OE_UNIX, errno, "strdup");
+        return -1;
+    }
+    cdh->cdh_stricthostkey = stricthostkey;
+    return 0;
+}
+
+/*! Get strict hostkey checking of connect destination
+ *
+ * @param[in]  dh     Device handle
+ * @retval     stricthostkey
+ */
+int
+device_handle_stricthostkey_get(device_handle dh)
+{
+    struct controller_device_handle *cdh = devhandle(dh);
+
+    return cdh->cdh_stricthostkey;
+}
+
+/*! Get time when waiting for reply in current state started
+ *
+ * @param[in]  dh     Device handle
+ * @param[out] t      Request timestamp
+ */
+int
+device_handle_request_time_get(device_handle   dh,
+                               struct timeval *t)
+{
+    struct controller_device_handle *cdh = devhandle(dh);
+
+    *t = cdh->cdh_request_time;
+    return 0;
+}
+
+/*! Set time when waiting for reply in current state started
+ *
+ * @param[in]  dh     Device handle
+ * @param[in]  t      Timestamp, if NULL set w gettimeofday
+ */
+int
+device_handle_request_time_set(device_handle   dh,
+                               struct timeval *t)
+{
+    struct controller_device_handle *cdh = devhandle(dh);
+
+    if (t == NULL)
+        gettimeofday(&cdh->cdh_request_time, NULL);
+    else
+        cdh->cdh_request_time = *t;
+    return 0;
+}
+
+/*! Add latency sample of a connection state
+ *
+ * The average is an EWMA with gain 1/8 as TCP SRTT (RFC 6298).
+ * The 99th percentile is estimated by stochastic approximation: it is moved up by 0.99 steps
+ * if the sample is above, and down by 0.01 steps otherwise. The step is proportional to the
+ * average which makes the estimate independent of device speed.
+ * @param[in]  dh     Device handle
+ * @param[in]  state  Connection state the reply was received in
+ * @param[in]  ms     Latency in ms
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+int
+device_handle_latency_add(device_handle dh,
+                          conn_state    state,
+                          uint32_t      ms)
+{
+    struct controller_device_handle *cdh = devhandle(dh);
+    struct device_latency           *dl;
+    double                           step;
+
+    if (state < 0 || state >= CONN_STATE_NR){
+        clixon_err(OE_UNIX, EINVAL, "state %d out of range", state);
+        return -1;
+    }
+    dl = &cdh->cdh_latency[state];
+    if (dl->dl_samples++ == 0){
+        dl->dl_ewma = ms;
+        dl->dl_p99 = ms;
+        return 0;
+    }
+    dl->dl_ewma += (ms - dl->dl_ewma) / 8;
+    step = (dl->dl_ewma > 1 ? dl->dl_ewma : 1) / 4;
+    if (ms > dl->dl_p99)
+        dl->dl_p99 += step * 0.99;
+    else
+        dl->dl_p99 -= step * 0.01;
+    if (dl->dl_p99 < dl->dl_ewma)
+        dl->dl_p99 = dl->dl_ewma;
+    return 0;
+}
+
+/*! Get latency statistics of a connection state
+ *
+ * @param[in]  dh      Device handle
+ * @param[in]  state   Connection state
+ * @param[out] samples Number of samples, 0 if no samples
+ * @param[out] ewma    Average latency in ms
+ * @param[out] p99     99th percentile latency estimate in ms
+ * @retval     0       OK
+ * @retval    -1       Error
+ */
+int
+device_handle_latency_get(device_handle dh,
+                          conn_state    state,
+                          uint32_t     *samples,
+                          uint32_t     *ewma,
+                          uint32_t     *p99)
+{
+    struct controller_device_handle *cdh = devhandle(dh);
+    struct device_latency           *dl;
+
+    if (state < 0 || state >= CONN_STATE_NR){
+        clixon_err(OE_UNIX, EINVAL, "state %d out of range", state);
+        return -1;
+    }
+    dl = &cdh->cdh_latency[state];
+    if (samples)
+        *samples = dl->dl_samples;
+    if (ewma)
+        *ewma = (uint32_t)(dl->dl_ewma + 0.5);
+    if (p99)
+        *p99 = (uint32_t)(dl->dl_p99 + 0.5);
+    return 0;
+}
+
+/*! Set auto-reconnect policy
+ *
+ * @param[in]  dh      Device handle
+ * @param[in]  backoff Initial backoff in s, 0: auto-reconnect disabled
+ * @param[in]  max     Max backoff in s
+ * @retval     0       OK
+ */
+int
+device_handle_reconnect_set(device_handle dh,
+                            uint32_t      backoff,
+                            uint32_t      max)
+{
+    struct controller_device_handle *cdh = devhandle(dh);
+
+    cdh->cdh_reconnect_backoff = backoff;
+    cdh->cdh_reconnect_backoff_max = max;
+    return 0;
+}
+
+/*! Get auto-reconnect policy
+ *
+ * @param[in]  dh      Device handle
+ * @param[out] backoff Initial backoff in s, 0: auto-reconnect disabled
+ * @param[out] max     Max backoff in s
+ * @retval     0       OK
+ */
+int
+device_handle_reconnect_get(device_handle dh,
+                            uint32_t     *backoff,
+                            uint32_t     *max)
+{
+    struct controller_device_handle *cdh = devhandle(dh);
+
+    if (backoff)
+        *backoff = cdh->cdh_reconnect_backoff;
+    if (max)
+        *max = cdh->cdh_reconnect_backoff_max;
+    return 0;
+}
+
+/*! Get number of auto-reconnect attempts since device was last open
+ *
+ * @param[in]  dh     Device handle
+ * @retval     attempts
+ */
+uint32_t
+device_handle_reconnect_attempts_get(device_handle dh)
+{
+    struct controller_device_handle *cdh = devhandle(dh);
+
+    return cdh->cdh_reconnect_attempts;
+}
+
+/*! Set number of auto-reconnect attempts
+ *
+ * @param[in]  dh       Device handle
+ * @param[in]  attempts Number of attempts
+ * @retval     0        OK
+ */
+int
+device_handle_reconnect_attempts_set(device_handle dh,
+                                     uint32_t      attempts)
+{
+    struct controller_device_handle *cdh = devhandle(dh);
+
+    cdh->cdh_reconnect_attempts = attempts;
+    return 0;
+}
+
+/*! Get time of next auto-reconnect attempt
+ *
+ * @param[in]  dh     Device handle
+ * @param[out] t      Time of next attempt, 0 if none scheduled
+ * @retval     0      OK
+ */
+int
+device_handle_reconnect_next_get(device_handle   dh,
+                                 struct timeval *t)
+{
+    struct controller_device_handle *cdh = devhandle(dh);
+
+    *t = cdh->cdh_reconnect_next;
+    return 0;
+}
+
+/*! Set time of next auto-reconnect attempt
+ *
+ * @param[in]  dh     Device handle
+ * @param[in]  t      Time of next attempt, if NULL clear
+ * @retval     0      OK
+ */
+int
+device_handle_reconnect_next_set(device_handle   dh,
+                                 struct timeval *t)
+{
+    struct controller_device_handle *cdh = devhandle(dh);
+
+    if (t == NULL)
+        timerclear(&cdh->cdh_reconnect_next);
+    else
+        cdh->cdh_reconnect_next = *t;
+    return 0;
+}
+
+/*! Get persisted SYNCED hash of a pending warm restart sync
+ *
+ * @param[in]  dh     Device handle
+ * @retval     hash   Hash as hex string
+ * @retval     NULL   No warm restart sync pending
+ */
+char *
+device_handle_warm_hash_get(device_handle dh)
+{
+    struct controller_device_handle *cdh = devhandle(dh);
+
+    return cdh->cdh_warm_hash;
+}
+
+/*! Set persisted SYNCED hash of a pending warm restart sync
+ *
+ * @param[in]  dh     Device handle
+ * @param[in]  hash   Hash as hex string (is copied), or NULL to clear
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+int
+device_handle_warm_hash_set(device_handle dh,
+                            const char   *hash)
+{
+    struct controller_device_handle *cdh = devhandle(dh);
+
+    if (cdh->cdh_warm_hash){
+        free(cdh->cdh_warm_hash);
+        cdh->cdh_warm_hash = NULL;
+    }
+    if (hash && (cdh->cdh_warm_hash = strdup(hash)) == NULL){
+        clixon_err(OE_UNIX, errno, "strdup");
+        return -1;
+    }
+    return 0;
+}
+
+/*! Get RFC 8525 content-id of the yang-library of the device
+ *
+ * @param[in]  dh      Device handle
+ * @param[in]  pending If set, get received content-id pending schema discovery
+ * @retval     cid     Content-id
+ * @retval     NULL    Not known
+ */
+char *
+device_handle_content_id_get(device_handle dh,
+                             int           pending)
+{
+    struct controller_device_handle *cdh = devhandle(dh);
+
+    return pending ? cdh->cdh_content_id_pending : cdh->cdh_content_id;
+}
+
+/*! Set RFC 8525 content-id of the yang-library of the device
+ *
+ * @param[in]  dh      Device handle
+ * @param[in]  pending If set, set received content-id pending schema discovery
+ * @param[in]  cid     Content-id (is copied), or NULL to clear
+ * @retval     0       OK
+ * @retval    -1       Error
+ */
+int
+device_handle_content_id_set(device_handle dh,
+                             int           pending,
+                             const char   *cid)
+{
+    struct controller_device_handle *cdh = devhandle(dh);
+    char                           **cidp;
+
+    cidp = pending ? &cdh->cdh_content_id_pending : &cdh->cdh_content_id;
+    if (*cidp){
+        free(*cidp);
+        *cidp = NULL;
+    }
+    if (cid && (*cidp = strdup(cid)) == NULL){
+        clixon_err(OE_UNIX, errno, "strdup");
+        return -1;
+    }
+    return 0;
+}
+
+/*! Get histogram bucket of a value
+ *
+ * @param[in]  us     Value in us
+ * @retval     i      Bucket index, 0 - DEVICE_HIST_NR-1
+ */
+static int
+device_hist_index(uint32_t us)
+{
+    uint32_t v = us;
+    int      e = 0;
+
+    if (us < DEVICE_HIST_SUB)
+        return us;
+    while (v >>= 1)
+        e++;
+    /* Leading bit is e, the two bits below it select the sub-bucket */
+    return DEVICE_HIST_SUB*(e-1) + ((us >> (e-2)) & (DEVICE_HIST_SUB-1));
+}
+
+/*! Get largest value of a histogram bucket
+ *
+ * @param[in]  i      Bucket index
+ * @retval     us     Largest value in us of the bucket
+ */
+static uint32_t
+device_hist_upper(int i)
+{
+    int e;
+    int m;
+
+    if (i < DEVICE_HIST_SUB)
+        return i;
+    e = i/DEVICE_HIST_SUB + 1;
+    m = i%DEVICE_HIST_SUB;
+    return (uint32_t)((((uint64_t)(DEVICE_HIST_SUB + m + 1)) << (e-2)) - 1);
+}
+
+/*! Add sample to histogram
+ *
+ * @param[in]  dhi    Histogram
+ * @param[in]  us     Sample in us
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+static int
+device_hist_add(struct device_hist *dhi,
+                uint32_t            us)
+{
+    if (dhi->dhi_bucket == NULL &&
+        (dhi->dhi_bucket = calloc(DEVICE_HIST_NR, sizeof(uint32_t))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        return -1;
+    }
+    dhi->dhi_bucket[device_hist_index(us)]++;
+    if (dhi->dhi_count++ == 0 || us < dhi->dhi_min)
+        dhi->dhi_min = us;
+    if (us > dhi->dhi_max)
+        dhi->dhi_max = us;
+    dhi->dhi_sum += us;
+    return 0;
+}
+
+/*! Get quantile of histogram
+ *
+ * The value is the upper bound of the bucket of the quantile, clamped to min and max
+ * @param[in]  dhi      Histogram with at least one sample
+ * @param[in]  permille Quantile in 1/1000, eg 990 for 99th percentile
+ * @retval     us       Quantile in us
+ */
+static uint32_t
+device_hist_quantile(struct device_hist *dhi,
+                     uint32_t            permille)
+{
+    uint64_t rank;
+    uint64_t sum = 0;
+    uint32_t us;
+    int      i;
+
+    rank = (dhi->dhi_count * permille + 999) / 1000;
+    if (rank == 0)
+        rank = 1;
+    for (i=0; i<DEVICE_HIST_NR-1; i++){
+        sum += dhi->dhi_bucket[i];
+        if (sum >= rank)
+            break;
+    }
+    us = device_hist_upper(i);
+    if (us > dhi->dhi_max)
+        us = dhi->dhi_max;
+    if (us < dhi->dhi_min)
+        us = dhi->dhi_min;
+    return us;
+}
 
+/*! Add unsigned integer leaf as XML
+ *
+ * @param[in]  xp     XML parent
+ * @param[in]  name   Leaf name
+ * @param[in]  val    Value
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+static int
+device_stats_body(cxobj      *xp,
+                  const char *name,
+                  uint64_t    val)
+{
+    char nr[24];
+
+    snprintf(nr, sizeof(nr), "%" PRIu64, val);
+    if (xml_new_body(name, xp, nr) == NULL)
+        return -1;
+    return 0;
+}
+
+/*! Add histogram as XML
+ *
+ * Only non-empty buckets are added
+ * @param[in]  dhi    Histogram
+ * @param[in]  xp     XML parent
+ * @param[in]  name   Name of histogram container
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+static int
+device_hist2xml(struct device_hist *dhi,
+                cxobj              *xp,
+                const char         *name)
+{
+    int    retval = -1;
+    cxobj *xh;
+    cxobj *xb;
+    int    i;
+
+    if ((xh = xml_new(name, xp, CX_ELMNT)) == NULL)
+        goto done;
+    if (device_stats_body(xh, "count", dhi->dhi_count) < 0)
+        goto done;
+    if (dhi->dhi_count == 0)
+        goto ok;
+    if (device_stats_body(xh, "min", dhi->dhi_min) < 0 ||
+        device_stats_body(xh, "max", dhi->dhi_max) < 0 ||
+        device_stats_body(xh, "mean", dhi->dhi_sum / dhi->dhi_count) < 0 ||
+        device_stats_body(xh, "p50", device_hist_quantile(dhi, 500)) < 0 ||
+        device_stats_body(xh, "p90", device_hist_quantile(dhi, 900)) < 0 ||
+        device_stats_body(xh, "p99", device_hist_quantile(dhi, 990)) < 0 ||
+        device_stats_body(xh, "p999", device_hist_quantile(dhi, 999)) < 0)
+        goto done;
+    for (i=0; i<DEVICE_HIST_NR; i++){
+        if (dhi->dhi_bucket[i] == 0)
+            continue;
+        if ((xb = xml_new("bucket", xh, CX_ELMNT)) == NULL)
+            goto done;
+        if (device_stats_body(xb, "le", device_hist_upper(i)) < 0 ||
+            device_stats_body(xb, "count", dhi->dhi_bucket[i]) < 0)
+            goto done;
+    }
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Register NETCONF request sent to device
+ *
+ * The request is kept until its reply is received, see device_handle_stats_msg
+ * @param[in]  dh     Device handle
+ * @param[in]  rpc    RPC type of request
+ * @param[in]  len    Length of message in bytes
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+int
+device_handle_stats_send(device_handle dh,
+                         device_rpc    rpc,
+                         size_t        len)
+{
+    struct controller_device_handle *cdh = devhandle(dh);
+    struct device_stats             *ds = &cdh->cdh_stats;
+    struct device_request           *dr;
+
+    if (rpc < 0 || rpc >= DEVICE_RPC_NR){
+        clixon_err(OE_UNIX, EINVAL, "rpc %d out of range", rpc);
+        return -1;
+    }
+    ds->ds_out_msgs++;
+    ds->ds_out_bytes += len;
+    ds->ds_requests[rpc]++;
+    if (ds->ds_pending_nr == DEVICE_STATS_PENDING){ /* Forget oldest */
+        ds->ds_pending_first = (ds->ds_pending_first + 1) % DEVICE_STATS_PENDING;
+        ds->ds_pending_nr--;
+    }
+    dr = &ds->ds_pending[(ds->ds_pending_first + ds->ds_pending_nr) % DEVICE_STATS_PENDING];
+    dr->dr_rpc = rpc;
+    gettimeofday(&dr->dr_time, NULL);
+    ds->ds_pending_nr++;
+    return 0;
+}
+
+/*! Register data received from device
+ *
+ * @param[in]  dh     Device handle
+ * @param[in]  len    Number of bytes read
+ * @retval     0      OK
+ */
+int
+device_handle_stats_recv(device_handle dh,
+                         size_t        len)
+{
+    struct controller_device_handle *cdh = devhandle(dh);
+
+    cdh->cdh_stats.ds_in_bytes += len;
+    return 0;
+}
+
+/*! Register NETCONF message received from device
+ *
+ * A reply is matched with the oldest outstanding request, since a NETCONF server replies
+ * in request order (RFC 6241 Sec 4.2), and its round-trip time is added.
+ * @param[in]  dh       Device handle
+ * @param[in]  parse_us Time in us to parse the message
+ * @param[in]  reply    If set, message is a rpc-reply
+ * @retval     0        OK
+ * @retval    -1        Error
+ */
+int
+device_handle_stats_msg(device_handle dh,
+                        uint32_t      parse_us,
+                        int           reply)
+{
+    struct controller_device_handle *cdh = devhandle(dh);
+    struct device_stats             *ds = &cdh->cdh_stats;
+    struct device_request           *dr;
+    struct timeval                   t;
+    uint64_t                         us;
+
+    ds->ds_in_msgs++;
+    if (device_hist_add(&ds->ds_parse, parse_us) < 0)
+        return -1;
+    if (reply && ds->ds_pending_nr > 0){
+        dr = &ds->ds_pending[ds->ds_pending_first];
+        ds->ds_pending_first = (ds->ds_pending_first + 1) % DEVICE_STATS_PENDING;
+        ds->ds_pending_nr--;
+        gettimeofday(&t, NULL);
+        timersub(&t, &dr->dr_time, &t);
+        us = (uint64_t)t.tv_sec*1000000 + t.tv_usec;
+        if (device_hist_add(&ds->ds_rtt[dr->dr_rpc], us > UINT32_MAX ? UINT32_MAX : us) < 0)
+            return -1;
+    }
+    return 0;
+}
+
+/*! Register YANG bind time of config received from device
+ *
+ * @param[in]  dh      Device handle
+ * @param[in]  bind_us Time in us to bind the config to YANG
+ * @retval     0       OK
+ * @retval    -1       Error
+ */
+int
+device_handle_stats_bind(device_handle dh,
+                         uint32_t      bind_us)
+{
+    struct controller_device_handle *cdh = devhandle(dh);
+
+    return device_hist_add(&cdh->cdh_stats.ds_bind, bind_us);
+}
+
+/*! Add NETCONF message statistics of device as XML
+ *
+ * @param[in]  dh     Device handle
+ * @param[in]  xp     XML parent, ie device
+ * @retval     0      OK
+ * @retval    -1      Error
+ * @see clixon-controller.yang statistics
+ */
+int
+device_handle_stats2xml(device_handle dh,
+                        cxobj        *xp)
+{
+    struct controller_device_handle *cdh = devhandle(dh);
+    struct device_stats             *ds = &cdh->cdh_stats;
+    int                              retval = -1;
+    cxobj                           *xs;
+    cxobj                           *xr;
+    device_rpc                       rpc;
+
+    if ((xs = xml_new("statistics", xp, CX_ELMNT)) == NULL)
+        goto done;
+    if (device_stats_body(xs, "in-bytes", ds->ds_in_bytes) < 0 ||
+        device_stats_body(xs, "out-bytes", ds->ds_out_bytes) < 0 ||
+        device_stats_body(xs, "in-messages", ds->ds_in_msgs) < 0 ||
+        device_stats_body(xs, "out-messages", ds->ds_out_msgs) < 0)
+        goto done;
+    if (device_hist2xml(&ds->ds_parse, xs, "parse-time") < 0)
+        goto done;
+    if (device_hist2xml(&ds->ds_bind, xs, "bind-time") < 0)
+        goto done;
+    for (rpc = 0; rpc < DEVICE_RPC_NR; rpc++){
+        if (ds->ds_requests[rpc] == 0)
+            continue;
+        if ((xr = xml_new("rpc", xs, CX_ELMNT)) == NULL)
+            goto done;
+        if (xml_new_body("name", xr, clicon_int2str(drmap, rpc)) == NULL)
+            goto done;
+        if (device_stats_body(xr, "requests", ds->ds_requests[rpc]) < 0)
+            goto done;
+        if (device_hist2xml(&ds->ds_rtt[rpc], xr, "round-trip-time") < 0)
+            goto done;
+    }
+    retval = 0;
+ done:
+    return retval;
+}
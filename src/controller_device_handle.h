@@ -43,6 +43,27 @@
 /* Abstract device handle, see struct controller_device_handle for concrete struct */
 typedef void *device_handle;
 
+/*! NETCONF RPC types of device statistics
+ *
+ * @see drmap translation table
+ * @see clixon-controller.yang statistics
+ */
+enum device_rpc_t {
+    DR_GET_CONFIG = 0,
+    DR_GET_SCHEMA,
+    DR_GET,
+    DR_LOCK,
+    DR_UNLOCK,
+    DR_EDIT_CONFIG,
+    DR_VALIDATE,
+    DR_COMMIT,
+    DR_DISCARD_CHANGES,
+};
+typedef enum device_rpc_t device_rpc;
+
+/* Number of device RPC types, DR_DISCARD_CHANGES is last */
+#define DEVICE_RPC_NR (DR_DISCARD_CHANGES+1)
+
 /*
  * Prototypes
  */
@@ -84,9 +105,11 @@ int    device_handle_framing_type_set(device_handle dh, netconf_framing_type ft)
 cxobj *device_handle_capabilities_get(device_handle dh);
 int    device_handle_capabilities_set(device_handle dh, cxobj *xcaps);
 int    device_handle_capabilities_find(clixon_handle ch, const char *name);
+char  *device_handle_capabilities_prefix(device_handle dh, const char *prefix);
 cxobj *device_handle_yang_lib_get(device_handle dh);
 int    device_handle_yang_lib_set(device_handle dh, cxobj *xylib);
 int    device_handle_yang_lib_append(device_handle dh, cxobj *xylib);
+char  *device_handle_yang_lib_fingerprint(device_handle dh);
 int    device_handle_sync_time_get(device_handle dh, struct timeval *t);
 int    device_handle_sync_time_set(device_handle dh, struct timeval *t);
 int    device_handle_nr_schemas_get(device_handle dh);
@@ -99,6 +122,29 @@ char  *device_handle_logmsg_get(device_handle dh);
 int    device_handle_logmsg_set(device_handle dh, char *logmsg);
 cbuf  *device_handle_outmsg_get(device_handle dh);
 int    device_handle_outmsg_set(device_handle dh, cbuf *cb);
+char  *device_handle_conn_dest_get(device_handle dh);
+int    device_handle_conn_dest_set(device_handle dh, const char *dest, int stricthostkey);
+int    device_handle_stricthostkey_get(device_handle dh);
+int    device_handle_request_time_get(device_handle dh, struct timeval *t);
+int    device_handle_request_time_set(device_handle dh, struct timeval *t);
+int    device_handle_latency_add(device_handle dh, conn_state state, uint32_t ms);
+int    device_handle_latency_get(device_handle dh, conn_state state,
+                                 uint32_t *samples, uint32_t *ewma, uint32_t *p99);
+int    device_handle_reconnect_set(device_handle dh, uint32_t backoff, uint32_t max);
+int    device_handle_reconnect_get(device_handle dh, uint32_t *backoff, uint32_t *max);
+uint32_t device_handle_reconnect_attempts_get(device_handle dh);
+int    device_handle_reconnect_attempts_set(device_handle dh, uint32_t attempts);
+int    device_handle_reconnect_next_get(device_handle dh, struct timeval *t);
+int    device_handle_reconnect_next_set(device_handle dh, struct timeval *t);
+char  *device_handle_warm_hash_get(device_handle dh);
+int    device_handle_warm_hash_set(device_handle dh, const char *hash);
+char  *device_handle_content_id_get(device_handle dh, int pending);
+int    device_handle_content_id_set(device_handle dh, int pending, const char *cid);
+int    device_handle_stats_send(device_handle dh, device_rpc rpc, size_t len);
+int    device_handle_stats_recv(device_handle dh, size_t len);
+int    device_handle_stats_msg(device_handle dh, uint32_t parse_us, int reply);
+int    device_handle_stats_bind(device_handle dh, uint32_t bind_us);
+int    device_handle_stats2xml(device_handle dh, cxobj *xp);
 
 #ifdef __cplusplus
 }
@@ -219,6 +219,13 @@ device_state_recv_config(clixon_handle h,
     controller_transaction *ct;
     int                     merge = 0;
     int                     transient = 0;
+    char                   *warmhash;
+    char                    hash[32];
+    int                     unchanged;
+    int                     modified;
+    int                     restore = 0;  /* Restore candidate from running on failure */
+    struct timeval          t0;
+    struct timeval          t;
 
     clixon_debug(CLIXON_DBG_DETAIL, "%s", __FUNCTION__);
     if ((ret = rpc_reply_sanity(dh, xmsg, rpcname, conn_state)) < 0)
@@ -261,8 +268,13 @@ device_state_recv_config(clixon_handle h,
      * <data>  ietf-netconf:data (dont bother to bind this node, its just a placeholder)
      * <x>     bind to yspec1
      */
+    gettimeofday(&t0, NULL);
     if ((ret = xml_bind_yang(h, xdata, YB_MODULE, yspec1, &xerr)) < 0)
         goto done;
+    gettimeofday(&t, NULL);
+    timersub(&t, &t0, &t);
+    if (device_handle_stats_bind(dh, t.tv_sec*1000000 + t.tv_usec) < 0)
+        goto done;
     if (ret == 0){
         if ((cberr = cbuf_new()) == NULL){
             clixon_err(OE_UNIX, errno, "cbuf_new");
@@ -304,6 +316,39 @@ device_state_recv_config(clixon_handle h,
         transient = 1;
     if (force_merge)
         merge = 1;
+    /* Warm restart: drift check against persisted SYNCED hash instead of sync commit.
+     * The sync commit is only skipped if the device config, and the local SYNCED and
+     * running device config, all have the persisted hash. Otherwise make a full sync */
+    if ((warmhash = device_handle_warm_hash_get(dh)) != NULL && !transient && !merge){
+        /* Must make a copy: xmldb_put strips attributes */
+        if ((xt1 = xml_dup(xt)) == NULL)
+            goto done;
+        ret = device_config_write(h, name, "TRANSIENT", xt1, cbret);
+        xml_free(xt1);
+        xt1 = NULL;
+        if (ret < 0)
+            goto done;
+        if (ret == 1 &&
+            (ret = device_config_hash(h, name, "TRANSIENT", hash, sizeof(hash))) < 0)
+            goto done;
+        unchanged = (ret == 1 && strcmp(hash, warmhash) == 0);
+        if (unchanged &&
+            (ret = device_config_hash(h, name, "SYNCED", hash, sizeof(hash))) < 0)
+            goto done;
+        unchanged = unchanged && ret == 1 && strcmp(hash, warmhash) == 0;
+        if (unchanged &&
+            (ret = device_config_hash(h, name, "RUNNING", hash, sizeof(hash))) < 0)
+            goto done;
+        unchanged = unchanged && ret == 1 && strcmp(hash, warmhash) == 0;
+        if (device_handle_warm_hash_set(dh, NULL) < 0)
+            goto done;
+        if (unchanged){
+            clixon_debug(CLIXON_DBG_DEFAULT, "%s %s: Warm restart, config unchanged", __FUNCTION__, name);
+            goto ok;
+        }
+        clixon_debug(CLIXON_DBG_DEFAULT, "%s %s: Warm restart, config changed, full sync", __FUNCTION__, name);
+        cbuf_reset(cbret);
+    }
     if (merge){
         if (xml_value_set(xa, xml_operation2str(OP_MERGE)) < 0)
             goto done;
@@ -325,19 +370,28 @@ device_state_recv_config(clixon_handle h,
     /*
      * Write changed device to tmp-db, make a regular commit from tmp-db
      * If not revert, write changed device to candidate
+     * If candidate is not modified, ie equal to running, the changed device is written directly
+     * to candidate and committed from there, without copying all of running to tmp-db.
+     * If that commit fails, candidate is restored from running.
      * XXX: Actually this should be changed to make all proper commits when transaction ends, not
      * in intermediate steps as done here. This is troublesome in mid-tramsaction abort.
      */
-    if (xmldb_copy(h, "running", "tmp") < 0)
-        goto done;
-    /* Must make a copy: xmldb_put strips attributes */
-    if ((xt1 = xml_dup(xt)) == NULL)
-        goto done;
-    /* 1. Why not just to candidate? */
-    if ((ret = xmldb_put(h, "tmp", OP_NONE, xt, NULL, cbret)) < 0)
+    if ((modified = xmldb_modified_get(h, "candidate")) != 0){
+        if (xmldb_copy(h, "running", "tmp") < 0)
+            goto done;
+        /* tmp is deleted after commit, do not write it to file */
+        xmldb_volatile_set(h, "tmp", 1);
+        /* Must make a copy: xmldb_put strips attributes */
+        if ((xt1 = xml_dup(xt)) == NULL)
+            goto done;
+    }
+    /* 1. Why not just to candidate? Only if candidate is not modified */
+    if (!modified)
+        restore = 1;
+    if ((ret = xmldb_put(h, modified?"tmp":"candidate", OP_NONE, xt, NULL, cbret)) < 0)
         goto done;
     if (ret == 1){
-        if ((ret = candidate_commit(h, NULL, "tmp", 0, 0, cbret)) < 0){
+        if ((ret = candidate_commit(h, NULL, modified?"tmp":"candidate", 0, 0, cbret)) < 0){
             /* Handle that candidate_commit can return < 0 if transaction ongoing */
             cprintf(cbret, "%s", clixon_err_reason());
             ret = 0;
@@ -350,12 +404,15 @@ device_state_recv_config(clixon_handle h,
         goto closed;
     }
     else {
+        restore = 0;
         device_handle_sync_time_set(dh, NULL);
     }
     /* 2. Why not just cp? */
-    if ((ret = xmldb_put(h, "candidate", OP_NONE, xt1, NULL, cbret)) < 0)
-        goto done;
-    xmldb_delete(h, "tmp");
+    if (modified){
+        if ((ret = xmldb_put(h, "candidate", OP_NONE, xt1, NULL, cbret)) < 0)
+            goto done;
+        xmldb_delete(h, "tmp");
+    }
     if ((ret = device_config_write(h, name, "SYNCED", xt, cbret)) < 0)
         goto done;
     if (ret == 0){
@@ -363,9 +420,15 @@ device_state_recv_config(clixon_handle h,
             goto done;
         goto closed;
     }
+    if (device_state_persist(h, dh) < 0)
+        goto done;
  ok:
     retval = 1;
  done:
+    /* Device config not committed: do not leave it in candidate */
+    if (restore &&
+        xmldb_copy(h, "running", "candidate") == 0)
+        xmldb_modified_set(h, "candidate", 0);
     if (xt)
         xml_free(xt);
     if (xt1)
@@ -382,6 +445,50 @@ device_state_recv_config(clixon_handle h,
     goto done;
 }
 
+/*! Receive RFC 8525 yang-library content-id from device
+ *
+ * An rpc-error or missing content-id is not an error, the device is then discovered using
+ * the schema list
+ * @param[in]  dh         Clixon client handle.
+ * @param[in]  xmsg       XML tree of incoming message
+ * @param[in]  rpcname    Name of RPC, only "rpc-reply" expected here
+ * @param[in]  conn_state Device connection state
+ * @param[out] cid        Content-id, or NULL if not found. Pointer into xmsg
+ * @retval     1          OK
+ * @retval     0          Closed
+ * @retval    -1          Error
+ * @see device_send_get_content_id  where the request is sent
+ */
+int
+device_state_recv_content_id(device_handle dh,
+                             cxobj        *xmsg,
+                             char         *rpcname,
+                             conn_state    conn_state,
+                             char        **cid)
+{
+    int    retval = -1;
+    cxobj *x;
+    cxobj *x1;
+    int    ret;
+
+    clixon_debug(CLIXON_DBG_DETAIL, "%s", __FUNCTION__);
+    if ((ret = rpc_reply_sanity(dh, xmsg, rpcname, conn_state)) < 0)
+        goto done;
+    if (ret == 0)
+        goto closed;
+    *cid = NULL;
+    /* Difficult to use xpath here since prefixes are not known */
+    if ((x = xml_find_type(xmsg, NULL, "data", CX_ELMNT)) != NULL &&
+        (x1 = xml_find_type(x, NULL, "yang-library", CX_ELMNT)) != NULL)
+        *cid = xml_find_body(x1, "content-id");
+    retval = 1;
+ done:
+    return retval;
+ closed:
+    retval = 0;
+    goto done;
+}
+
 /*! Receive netconf-state schema list from device using RFC 6022 state
  *
  * @param[in] h          Clixon handle.
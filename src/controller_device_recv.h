@@ -49,6 +49,8 @@ int device_state_recv_hello(clixon_handle h, device_handle dh, int s, cxobj *xms
 int device_state_recv_config(clixon_handle h, device_handle dh, cxobj *xmsg,
                              yang_stmt *yspec0, char *rpcname, conn_state conn_state,
                              int force_transient, int force_merge);
+int device_state_recv_content_id(device_handle dh, cxobj *xmsg, char *rpcname,
+                                 conn_state conn_state, char **cid);
 int device_state_recv_schema_list(device_handle dh, cxobj *xmsg, char *rpcname,
                                   conn_state conn_state);
 int device_state_recv_get_schema(device_handle dh, cxobj *xmsg, char *rpcname,
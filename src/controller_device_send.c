@@ -92,6 +92,8 @@ device_send_lock(clixon_handle h,
         goto done;
     if (clicon_msg_send1(s, device_handle_name_get(dh), cb) < 0)
         goto done;
+    if (device_handle_stats_send(dh, lock==0?DR_UNLOCK:DR_LOCK, cbuf_len(cb)) < 0)
+        goto done;
     retval = 0;
  done:
     if (cb)
@@ -139,6 +141,8 @@ device_send_get_config(clixon_handle h,
     s = device_handle_socket_get(dh);
     if (clicon_msg_send1(s, device_handle_name_get(dh), cb) < 0)
         goto done;
+    if (device_handle_stats_send(dh, DR_GET_CONFIG, cbuf_len(cb)) < 0)
+        goto done;
     retval = 0;
  done:
     if (cb)
@@ -188,6 +192,8 @@ device_get_schema_sendit(clixon_handle h,
         goto done;
     if (clicon_msg_send1(s, device_handle_name_get(dh), cb) < 0)
         goto done;
+    if (device_handle_stats_send(dh, DR_GET_SCHEMA, cbuf_len(cb)) < 0)
+        goto done;
     clixon_debug(1, "%s %s: sent get-schema(%s@%s) seq:%" PRIu64, __FUNCTION__, name, identifier, version, seq);
     retval = 0;
  done:
@@ -310,6 +316,56 @@ device_send_get_schema_list(clixon_handle h,
         goto done;
     if (clicon_msg_send1(s, device_handle_name_get(dh), cb) < 0)
         goto done;
+    if (device_handle_stats_send(dh, DR_GET, cbuf_len(cb)) < 0)
+        goto done;
+    retval = 0;
+ done:
+    if (cb)
+        cbuf_free(cb);
+    return retval;
+}
+
+/*! Send RFC 8525 yang-library content-id get request
+ *
+ * @param[in]  h      Clixon handle.
+ * @param[in]  dh     Clixon client handle.
+ * @param[in]  s      Socket
+ * @retval     0      OK
+ * @retval    -1      Error
+ * @see device_state_recv_content_id  where the reply is received
+ */
+int
+device_send_get_content_id(clixon_handle h,
+                           device_handle dh,
+                           int           s)
+{
+    int   retval = -1;
+    cbuf *cb = NULL;
+    int   encap;
+
+    clixon_debug(1, "%s", __FUNCTION__);
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_PLUGIN, errno, "cbuf_new");
+        goto done;
+    }
+    cprintf(cb, "<rpc xmlns=\"%s\" message-id=\"%" PRIu64 "\">",
+            NETCONF_BASE_NAMESPACE,
+            device_handle_msg_id_getinc(dh));
+    cprintf(cb, "<get>");
+    cprintf(cb, "<filter type=\"subtree\">");
+    cprintf(cb, "<yang-library xmlns=\"%s\">", YANG_LIBRARY_NAMESPACE);
+    cprintf(cb, "<content-id/>");
+    cprintf(cb, "</yang-library>");
+    cprintf(cb, "</filter>");
+    cprintf(cb, "</get>");
+    cprintf(cb, "</rpc>");
+    encap = device_handle_framing_type_get(dh);
+    if (netconf_output_encap(encap, cb) < 0)
+        goto done;
+    if (clicon_msg_send1(s, device_handle_name_get(dh), cb) < 0)
+        goto done;
+    if (device_handle_stats_send(dh, DR_GET, cbuf_len(cb)) < 0)
+        goto done;
     retval = 0;
  done:
     if (cb)
@@ -494,7 +550,7 @@ device_create_edit_config_diff(clixon_handle h,
  *
  * @param[in]  h       Clixon handle.
  * @param[in]  dh      Clixon client handle.
- * @param[in]  s       Netconf socket
+ * @param[in]  rpc     RPC type, for statistics
  * @param[in]  msgbody NETCONF RPC message fields (not including header)
  * @retval     0       OK
  * @retval    -1       Error
@@ -502,6 +558,7 @@ device_create_edit_config_diff(clixon_handle h,
 static int
 device_send_rpc(clixon_handle h,
                 device_handle dh,
+                device_rpc    rpc,
                 char         *msgbody)
 {
     int   retval = -1;
@@ -525,6 +582,8 @@ device_send_rpc(clixon_handle h,
         goto done;
     if (clicon_msg_send1(s, device_handle_name_get(dh), cb) < 0)
         goto done;
+    if (device_handle_stats_send(dh, rpc, cbuf_len(cb)) < 0)
+        goto done;
     retval = 0;
  done:
     if (cb)
@@ -538,7 +597,7 @@ int
 device_send_validate(clixon_handle h,
                      device_handle dh)
 {
-    return device_send_rpc(h, dh, "<validate><source><candidate/></source></validate>");
+    return device_send_rpc(h, dh, DR_VALIDATE, "<validate><source><candidate/></source></validate>");
 }
 
 /*! Send commit to device
@@ -547,7 +606,7 @@ int
 device_send_commit(clixon_handle h,
                    device_handle dh)
 {
-    return device_send_rpc(h, dh, "<commit/>");
+    return device_send_rpc(h, dh, DR_COMMIT, "<commit/>");
 }
 
 /*! Send discard-changes to device
@@ -556,5 +615,5 @@ int
 device_send_discard_changes(clixon_handle h,
                             device_handle dh)
 {
-    return device_send_rpc(h, dh, "<discard-changes/>");
+    return device_send_rpc(h, dh, DR_DISCARD_CHANGES, "<discard-changes/>");
 }
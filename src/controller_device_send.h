@@ -48,6 +48,7 @@ int device_send_lock(clixon_handle h, device_handle dh, int lock);
 int device_send_get_config(clixon_handle h, device_handle ch, int s);
 int device_send_get_schema_next(clixon_handle h, device_handle dh, int s, int *nr);
 int device_send_get_schema_list(clixon_handle h, device_handle dh, int s);
+int device_send_get_content_id(clixon_handle h, device_handle dh, int s);
 int device_create_edit_config_diff(clixon_handle h, device_handle dh,
                                    cxobj *x0, cxobj *x1, yang_stmt *yspec,
                                    cxobj **dvec, int dlen,
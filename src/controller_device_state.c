@@ -24,17 +24,21 @@
 
  CS_CLOSED \
      ^      \ connect
-     |       v        send get
-     |<-- CS_CONNECTING
-     |       |
      |       v
-     |<-- CS_SCHEMA_LIST
+     |<-- CS_CONNECT_PENDING
+     |       | connect slot
+     |       v        send get
+     |<-- CS_CONNECTING --------+
+     |       |                  v
+     |       |<-------- CS_SCHEMA_CONTENT_ID
+     |       v                  | content-id cached
+     |<-- CS_SCHEMA_LIST        |
      |       |       \
      |       |        v
      |<-------- CS_SCHEMA_ONE(n) ---+
      |       |       /           <--+
-     |       v      v
-     |<-- CS_DEVICE_SYNC
+     |       v      v           |
+     |<-- CS_DEVICE_SYNC <------+
      |      /
      |     /
  CS_OPEN <+
@@ -46,6 +50,7 @@
 #include <stdint.h>
 #include <inttypes.h>
 #include <string.h>
+#include <ctype.h>
 #include <errno.h>
 #include <signal.h>
 #include <unistd.h>
@@ -73,6 +78,7 @@
 #include "controller_device_send.h"
 #include "controller_device_recv.h"
 #include "controller_transaction.h"
+#include "controller_rpc.h"
 
 /*! Mapping between enum conn_state and yang connection-state
  *
@@ -80,11 +86,14 @@
  */
 static const map_str2int csmap[] = {
     {"CLOSED",           CS_CLOSED},
+    {"CONNECT-PENDING",  CS_CONNECT_PENDING},
     {"CONNECTING",       CS_CONNECTING},
+    {"SCHEMA-CONTENT-ID",CS_SCHEMA_CONTENT_ID},
     {"SCHEMA-LIST",      CS_SCHEMA_LIST},
     {"SCHEMA-ONE",       CS_SCHEMA_ONE}, /* substate is schema-nr */
     {"DEVICE-SYNC",      CS_DEVICE_SYNC},
     {"OPEN",             CS_OPEN},
+    {"PUSH-QUEUE",       CS_PUSH_QUEUE},
     {"PUSH_LOCK",        CS_PUSH_LOCK},
     {"PUSH-CHECK",       CS_PUSH_CHECK},
     {"PUSH-EDIT",        CS_PUSH_EDIT},
@@ -143,6 +152,175 @@ yang_config_str2int(char *str)
     return clicon_str2int(yfmap, str);
 }
 
+/* Forward */
+static int device_reconnect_timeout(int s, void *arg);
+
+/*! Register auto-reconnect timeout at earliest next attempt of all closed devices
+ *
+ * A single timeout is used for all devices, an earlier registration is replaced.
+ * @param[in] h    Clixon handle
+ * @retval    0    OK
+ * @retval   -1    Error
+ */
+static int
+device_reconnect_register(clixon_handle h)
+{
+    int            retval = -1;
+    device_handle  dh;
+    struct timeval t;
+    struct timeval first = {0,};
+
+    dh = NULL;
+    while ((dh = device_handle_each(h, dh)) != NULL){
+        if (device_handle_conn_state_get(dh) != CS_CLOSED)
+            continue;
+        device_handle_reconnect_next_get(dh, &t);
+        if (!timerisset(&t))
+            continue;
+        if (!timerisset(&first) || timercmp(&t, &first, <))
+            first = t;
+    }
+    (void)clixon_event_unreg_timeout(device_reconnect_timeout, h);
+    if (timerisset(&first) &&
+        clixon_event_reg_timeout(first, device_reconnect_timeout, h, "Device auto-reconnect") < 0)
+        goto done;
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Schedule next auto-reconnect attempt of a closed device with jittered exponential backoff
+ *
+ * The backoff starts at reconnect-backoff and is doubled for each attempt up to
+ * reconnect-backoff-max. The actual delay is drawn uniformly from the upper half of the backoff
+ * ("equal jitter") so that devices closed at the same time do not reconnect at the same time.
+ * No-op if auto-reconnect is disabled for the device.
+ * @param[in] dh   Device handle
+ * @retval    0    OK
+ * @retval   -1    Error
+ * @see device_reconnect_cancel
+ */
+static int
+device_reconnect_backoff(device_handle dh)
+{
+    uint32_t       backoff;
+    uint32_t       max;
+    uint32_t       attempts;
+    uint32_t       i;
+    uint64_t       ms;
+    struct timeval t;
+    struct timeval tdelay;
+
+    device_handle_reconnect_get(dh, &backoff, &max);
+    if (backoff == 0)
+        return 0;
+    if (max < backoff)
+        max = backoff;
+    attempts = device_handle_reconnect_attempts_get(dh);
+    ms = backoff*1000;
+    for (i=0; i<attempts && ms < max*1000; i++)
+        ms *= 2;
+    if (ms > max*1000)
+        ms = max*1000;
+    ms = ms/2 + random()%(ms/2 + 1);
+    device_handle_reconnect_attempts_set(dh, attempts+1);
+    gettimeofday(&t, NULL);
+    tdelay.tv_sec = ms/1000;
+    tdelay.tv_usec = (ms%1000)*1000;
+    timeradd(&t, &tdelay, &t);
+    device_handle_reconnect_next_set(dh, &t);
+    clixon_debug(CLIXON_DBG_DEFAULT, "%s %s in %" PRIu64 "ms", __FUNCTION__,
+                 device_handle_name_get(dh), ms);
+    return device_reconnect_register(device_handle_handle_get(dh));
+}
+
+/*! Auto-reconnect timeout: reconnect closed devices whose backoff has expired
+ *
+ * All expired devices are reconnected in one transaction, so that they are connected in
+ * parallel by the connect scheduler.
+ * @param[in] s    Socket (not used)
+ * @param[in] arg  Clixon handle
+ * @retval    0    OK
+ * @retval   -1    Error
+ */
+static int
+device_reconnect_timeout(int   s,
+                         void *arg)
+{
+    int            retval = -1;
+    clixon_handle  h = (clixon_handle)arg;
+    device_handle  dh;
+    struct timeval now;
+    struct timeval t;
+    cvec          *devnames = NULL;
+    cg_var        *cv;
+    int            ret;
+
+    if ((devnames = cvec_new(0)) == NULL){
+        clixon_err(OE_UNIX, errno, "cvec_new");
+        goto done;
+    }
+    gettimeofday(&now, NULL);
+    dh = NULL;
+    while ((dh = device_handle_each(h, dh)) != NULL){
+        if (device_handle_conn_state_get(dh) != CS_CLOSED)
+            continue;
+        device_handle_reconnect_next_get(dh, &t);
+        if (!timerisset(&t) || timercmp(&now, &t, <))
+            continue;
+        device_handle_reconnect_next_set(dh, NULL);
+        clixon_debug(CLIXON_DBG_DEFAULT, "%s %s attempt %u", __FUNCTION__,
+                     device_handle_name_get(dh), device_handle_reconnect_attempts_get(dh));
+        if (cvec_add_string(devnames, device_handle_name_get(dh), NULL) < 0){
+            clixon_err(OE_UNIX, errno, "cvec_add_string");
+            goto done;
+        }
+    }
+    if (cvec_len(devnames)){
+        if ((ret = controller_device_reconnect(h, devnames)) < 0)
+            goto done;
+        /* Not started, eg commit queue full: back off further */
+        if (ret == 0){
+            cv = NULL;
+            while ((cv = cvec_each(devnames, cv)) != NULL){
+                if ((dh = device_handle_find(h, cv_name_get(cv))) != NULL &&
+                    device_handle_conn_state_get(dh) == CS_CLOSED &&
+                    device_reconnect_backoff(dh) < 0)
+                    goto done;
+            }
+        }
+    }
+    if (device_reconnect_register(h) < 0)
+        goto done;
+    retval = 0;
+ done:
+    if (devnames)
+        cvec_free(devnames);
+    return retval;
+}
+
+/*! Cancel auto-reconnect of a device, eg on user request
+ *
+ * Any pending attempt is removed, the backoff is restarted, and auto-reconnect is disabled
+ * until the device is connected again with its configured reconnect-backoff.
+ * Call before an expected close, such as user close or device disabled or removed, since
+ * device_close_connection otherwise schedules a reconnect.
+ * @param[in] dh   Device handle
+ * @retval    0    OK
+ * @retval   -1    Error
+ */
+int
+device_reconnect_cancel(device_handle dh)
+{
+    uint32_t max;
+
+    device_handle_reconnect_get(dh, NULL, &max);
+    device_handle_reconnect_set(dh, 0, max);
+    device_handle_reconnect_next_set(dh, NULL);
+    device_handle_reconnect_attempts_set(dh, 0);
+    return device_reconnect_register(device_handle_handle_get(dh));
+}
+
 /*! Close connection, unregister events and timers
  *
  * @param[in]  dh      Clixon device handle.
@@ -166,16 +344,21 @@ device_close_connection(device_handle dh,
 
     name = device_handle_name_get(dh);
     clixon_debug(CLIXON_DBG_DETAIL, "%s %s", __FUNCTION__, name);
-    if ((s = device_handle_socket_get(dh)) == -1){
-        clixon_err(OE_UNIX, errno, "%s: socket is -1", device_handle_name_get(dh));
-        goto done;
+    /* Pending connect has no socket */
+    if (device_handle_conn_state_get(dh) != CS_CONNECT_PENDING){
+        if ((s = device_handle_socket_get(dh)) == -1){
+            clixon_err(OE_UNIX, errno, "%s: socket is -1", device_handle_name_get(dh));
+            goto done;
+        }
+        clixon_event_unreg_fd(s, device_input_cb); /* deregister events */
+        if (device_handle_disconnect(dh) < 0) /* close socket, reap sub-processes */
+            goto done;
     }
-    clixon_event_unreg_fd(s, device_input_cb); /* deregister events */
-    if (device_handle_disconnect(dh) < 0) /* close socket, reap sub-processes */
-        goto done;
     //    device_handle_yang_lib_set(dh, NULL); XXX mem-error: caller using xylib
     if (device_state_set(dh, CS_CLOSED) < 0)
         goto done;
+    if (device_reconnect_backoff(dh) < 0)
+        goto done;
     device_handle_outmsg_set(dh, NULL);
     if (format == NULL)
         device_handle_logmsg_set(dh, NULL);
@@ -242,6 +425,8 @@ device_input_cb(int   s,
     controller_transaction *ct = NULL;
     int                     ret;
     int                     sockerr;
+    struct timeval          t0;
+    struct timeval          t;
 
     clixon_debug(CLIXON_DBG_DETAIL, "%s", __FUNCTION__);
     h = device_handle_handle_get(dh);
@@ -254,6 +439,7 @@ device_input_cb(int   s,
     /* Read input data from socket and append to cbbuf */
     if ((len = netconf_input_read2(s, buf, buflen, &eof)) < 0)
         goto done;
+    device_handle_stats_recv(dh, len);
     if (eof){
         if ((sockerr = device_handle_sockerr_get(dh)) != -1){
             if ((buferr = malloc(buferrlen)) == NULL){
@@ -298,8 +484,11 @@ device_input_cb(int   s,
             break;
         }
         clixon_debug(CLIXON_DBG_MSG, "Recv [%s]: %s", name, cbuf_get(cbmsg));
+        gettimeofday(&t0, NULL);
         if ((ret = netconf_input_frame2(cbmsg, YB_NONE, NULL, &xtop, &xerr)) < 0)
             goto done;
+        gettimeofday(&t, NULL);
+        timersub(&t, &t0, &t);
         cbuf_reset(cbmsg);
         if (ret == 0){
             if ((cberr = cbuf_new()) == NULL){
@@ -318,6 +507,9 @@ device_input_cb(int   s,
             goto ok;
         }
         xmsg = xml_child_i_type(xtop, 0, CX_ELMNT);
+        if (device_handle_stats_msg(dh, t.tv_sec*1000000 + t.tv_usec,
+                                    xmsg && strcmp(xml_name(xmsg), "rpc-reply") == 0) < 0)
+            goto done;
         if (xmsg && device_state_handler(h, dh, s, xmsg) < 0)
             goto done;
     } /* while */
@@ -486,6 +678,84 @@ device_schemas_local_check(clixon_handle h,
     goto done;
 }
 
+/*! Add latency sample of the request of a transient state
+ *
+ * The sample is the time since the state timeout was registered, ie since the request was sent
+ * @param[in] dh     Device handle
+ * @param[in] state  Connection state
+ * @retval    0      OK
+ * @retval   -1      Error
+ * @see device_state_timeout_register  where request time is set
+ */
+static int
+device_state_latency_sample(device_handle dh,
+                            conn_state    state)
+{
+    struct timeval t0;
+    struct timeval t;
+
+    /* Push-wait does not wait for the device but for other devices */
+    if (state == CS_CLOSED || state == CS_OPEN || state == CS_CONNECT_PENDING ||
+        state == CS_PUSH_QUEUE || state == CS_PUSH_WAIT)
+        return 0;
+    device_handle_request_time_get(dh, &t0);
+    if (t0.tv_sec == 0)
+        return 0;
+    gettimeofday(&t, NULL);
+    timersub(&t, &t0, &t);
+    return device_handle_latency_add(dh, state, t.tv_sec*1000 + t.tv_usec/1000);
+}
+
+/*! Get timeout of a transient device state
+ *
+ * If device-timeout-max is 0, device-timeout is used for all states.
+ * Otherwise the timeout is adapted to the observed reply latency of the device in that state:
+ * the largest of 2 * p99 and 4 * average, bounded by device-timeout-min and device-timeout-max.
+ * Until DEVICE_LATENCY_SAMPLES_MIN samples are observed, device-timeout within the bounds is used.
+ * @param[in]  dh     Device handle
+ * @param[in]  state  Connection state
+ * @param[out] ms     Timeout in ms
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+static int
+device_state_timeout_get(device_handle dh,
+                         conn_state    state,
+                         uint32_t     *ms)
+{
+    int           retval = -1;
+    clixon_handle h;
+    int           d;
+    int           min;
+    int           max;
+    uint32_t      samples;
+    uint32_t      ewma;
+    uint32_t      p99;
+    uint32_t      t;
+
+    h = device_handle_handle_get(dh);
+    if ((d = clicon_data_int_get(h, "controller-device-timeout")) == -1)
+        d = 60;
+    t = d*1000;
+    max = clicon_data_int_get(h, "controller-device-timeout-max");
+    if (max > 0 && state != CS_PUSH_WAIT){
+        if ((min = clicon_data_int_get(h, "controller-device-timeout-min")) == -1)
+            min = CONTROLLER_DEVICE_TIMEOUT_MIN_DEFAULT;
+        if (device_handle_latency_get(dh, state, &samples, &ewma, &p99) < 0)
+            goto done;
+        if (samples >= DEVICE_LATENCY_SAMPLES_MIN)
+            t = 2*p99 > 4*ewma ? 2*p99 : 4*ewma;
+        if (t < (uint32_t)min*1000)
+            t = (uint32_t)min*1000;
+        if (t > (uint32_t)max*1000)
+            t = (uint32_t)max*1000;
+    }
+    *ms = t;
+    retval = 0;
+ done:
+    return retval;
+}
+
 /*! Timeout callback of transient states, close connection
  *
  * @param[in] arg    In effect client handle
@@ -506,7 +776,9 @@ device_state_timeout(int   s,
     name = device_handle_name_get(dh);
     clixon_debug(CLIXON_DBG_DEFAULT, "%s %s", __FUNCTION__, name);
     h = device_handle_handle_get(dh);
-
+    /* Timeout is a lower bound of latency, makes adaptive timeout grow for slow devices */
+    if (device_state_latency_sample(dh, device_handle_conn_state_get(dh)) < 0)
+        goto done;
     if ((tid = device_handle_tid_get(dh)) != 0)
         ct = controller_transaction_find(h, tid);
     if (ct){
@@ -532,21 +804,18 @@ device_state_timeout_register(device_handle dh)
     int            retval = -1;
     struct timeval t;
     struct timeval t1;
-    int            d;
-    clixon_handle  h;
+    uint32_t       ms;
     cbuf          *cb = NULL;
-    char                   *name;
+    char          *name;
 
     name = device_handle_name_get(dh);
     gettimeofday(&t, NULL);
-    h = device_handle_handle_get(dh);
-    d = clicon_data_int_get(h, "controller-device-timeout");
-    if (d != -1)
-        t1.tv_sec = d;
-    else
-        t1.tv_sec = 60;
-    t1.tv_usec = 0;
-    clixon_debug(CLIXON_DBG_DETAIL, "%s timeout:%ld s", __FUNCTION__, t1.tv_sec);
+    device_handle_request_time_set(dh, &t);
+    if (device_state_timeout_get(dh, device_handle_conn_state_get(dh), &ms) < 0)
+        goto done;
+    t1.tv_sec = ms/1000;
+    t1.tv_usec = (ms%1000)*1000;
+    clixon_debug(CLIXON_DBG_DETAIL, "%s timeout:%u ms", __FUNCTION__, ms);
     timeradd(&t, &t1, &t);
     if ((cb = cbuf_new()) == NULL){
         clixon_err(OE_UNIX, errno, "cbuf_new");
@@ -589,6 +858,8 @@ device_state_timeout_restart(device_handle dh)
 {
     int retval = -1;
 
+    if (device_state_latency_sample(dh, device_handle_conn_state_get(dh)) < 0)
+        goto done;
     if (device_state_timeout_unregister(dh) < 0)
         goto done;
     if (device_state_timeout_register(dh) < 0)
@@ -598,9 +869,208 @@ device_state_timeout_restart(device_handle dh)
     return retval;
 }
 
+/*! Check if connection state is part of connect handshake, ie counts as in-flight connect
+ *
+ * @param[in] state  Connection state
+ * @retval    1      Handshake state
+ * @retval    0      Not handshake state
+ * @see connect-max-inflight
+ */
+static int
+device_state_handshake(conn_state state)
+{
+    return state == CS_CONNECTING || state == CS_SCHEMA_CONTENT_ID ||
+        state == CS_SCHEMA_LIST || state == CS_SCHEMA_ONE;
+}
+
+/* Earliest time of next connect, if connect-rate is set */
+static struct timeval connect_next = {0,};
+
+/*! Timeout callback of connect scheduler
+ *
+ * @param[in] s    Socket (not used)
+ * @param[in] arg  Clixon handle
+ * @retval    0    OK
+ * @retval   -1    Error
+ */
+static int
+device_connect_schedule_timeout(int   s,
+                                void *arg)
+{
+    return device_connect_schedule((clixon_handle)arg);
+}
+
+/*! Register connect scheduler to run from event loop
+ *
+ * Only if there are devices pending connect. An earlier registration is replaced.
+ * @param[in] h    Clixon handle
+ * @param[in] t    Absolute time to run, or NULL for immediately
+ * @retval    0    OK
+ * @retval   -1    Error
+ */
+static int
+device_connect_schedule_register(clixon_handle   h,
+                                 struct timeval *t)
+{
+    int            retval = -1;
+    device_handle  dh;
+    struct timeval now;
+
+    dh = NULL;
+    while ((dh = device_handle_each(h, dh)) != NULL){
+        if (device_handle_conn_state_get(dh) == CS_CONNECT_PENDING)
+            break;
+    }
+    if (dh == NULL)
+        goto ok;
+    if (t == NULL){
+        gettimeofday(&now, NULL);
+        t = &now;
+    }
+    (void)clixon_event_unreg_timeout(device_connect_schedule_timeout, h);
+    if (clixon_event_reg_timeout(*t, device_connect_schedule_timeout, h, "Controller connect scheduler") < 0)
+        goto done;
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Connect device in CONNECT-PENDING state via Netconf SSH
+ *
+ * Called from the connect scheduler timeout, a failed connect therefore closes the device
+ * and fails its transaction instead of returning an error.
+ * @param[in]  h   Clixon handle
+ * @param[in]  dh  Device handle
+ * @retval     1   OK
+ * @retval     0   Connect failed, device closed with reason in logmsg
+ * @retval    -1   Error
+ */
+static int
+device_state_connect(clixon_handle h,
+                     device_handle dh)
+{
+    int                     retval = -1;
+    cbuf                   *cb = NULL;
+    char                   *dest;
+    int                     s;
+    char                   *reason = NULL;
+    uint64_t                tid;
+    controller_transaction *ct;
+
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    if ((dest = device_handle_conn_dest_get(dh)) == NULL){
+        clixon_err(OE_PLUGIN, EINVAL, "%s: No connect destination", device_handle_name_get(dh));
+        goto failed;
+    }
+    if (device_handle_connect(dh, CLIXON_CLIENT_SSH, dest, device_handle_stricthostkey_get(dh)) < 0)
+        goto failed;
+    if (device_state_set(dh, CS_CONNECTING) < 0)
+        goto done;
+    s = device_handle_socket_get(dh);
+    device_handle_framing_type_set(dh, NETCONF_SSH_EOM);
+    cprintf(cb, "Netconf ssh %s", dest);
+    if (clixon_event_reg_fd(s, device_input_cb, dh, cbuf_get(cb)) < 0)
+        goto failed;
+    retval = 1;
+ done:
+    if (reason)
+        free(reason);
+    if (cb)
+        cbuf_free(cb);
+    return retval;
+ failed:
+    if ((reason = strdup(clixon_err_reason())) == NULL){
+        clixon_err(OE_UNIX, errno, "strdup");
+        goto done;
+    }
+    clixon_err_reset();
+    if ((tid = device_handle_tid_get(dh)) != 0 &&
+        (ct = controller_transaction_find(h, tid)) != NULL){
+        if (controller_transaction_failed(h, tid, ct, dh, TR_FAILED_DEV_CLOSE,
+                                          device_handle_name_get(dh), reason) < 0)
+            goto done;
+    }
+    else if (device_close_connection(dh, "%s", reason) < 0)
+        goto done;
+    retval = 0;
+    goto done;
+}
+
+/*! Connect scheduler: connect pending devices within in-flight window and connect rate
+ *
+ * Devices are connected in CONNECT-PENDING order as long as less than connect-max-inflight devices
+ * are in a handshake state, and no faster than connect-rate connects per second.
+ * Called after connects are requested, when a device leaves a handshake state, and by timeout
+ * when rate limited.
+ * @param[in] h    Clixon handle
+ * @retval    0    OK
+ * @retval   -1    Error
+ */
+int
+device_connect_schedule(clixon_handle h)
+{
+    int            retval = -1;
+    device_handle  dh;
+    int            max;
+    int            rate;
+    int            inflight = 0;
+    int            pending = 0;
+    struct timeval now;
+    struct timeval interval;
+    int            ret;
+
+    if ((max = clicon_data_int_get(h, "controller-connect-max-inflight")) == -1)
+        max = CONTROLLER_CONNECT_MAX_INFLIGHT_DEFAULT;
+    if ((rate = clicon_data_int_get(h, "controller-connect-rate")) == -1)
+        rate = 0;
+    dh = NULL;
+    while ((dh = device_handle_each(h, dh)) != NULL){
+        if (device_state_handshake(device_handle_conn_state_get(dh)))
+            inflight++;
+        else if (device_handle_conn_state_get(dh) == CS_CONNECT_PENDING)
+            pending++;
+    }
+    clixon_debug(CLIXON_DBG_DEFAULT, "%s inflight:%d pending:%d", __FUNCTION__, inflight, pending);
+    if (pending == 0)
+        goto ok;
+    gettimeofday(&now, NULL);
+    dh = NULL;
+    while ((dh = device_handle_each(h, dh)) != NULL){
+        if (device_handle_conn_state_get(dh) != CS_CONNECT_PENDING)
+            continue;
+        if (max && inflight >= max)
+            break;  /* Promoted when a handshake completes */
+        if (rate){
+            if (timercmp(&now, &connect_next, <)){
+                if (device_connect_schedule_register(h, &connect_next) < 0)
+                    goto done;
+                break;
+            }
+            interval.tv_sec = 0;
+            interval.tv_usec = 1000000/rate;
+            if (timercmp(&connect_next, &now, <))
+                connect_next = now;
+            timeradd(&connect_next, &interval, &connect_next);
+        }
+        if ((ret = device_state_connect(h, dh)) < 0)
+            goto done;
+        if (ret == 1)
+            inflight++;
+    }
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
 /*! Combined function to both change device state and set/reset/unregister timeout
  *
  * And possibly other "high-level" action associated with state change
+ * If the device is in a transaction, the state left is added to the transaction trace
  * @param[in]   dh     Device handle
  * @param[in]   state  State
  * @retval      0      OK
@@ -610,21 +1080,53 @@ int
 device_state_set(device_handle dh,
                  conn_state    state)
 {
-    int        retval = -1;
-    conn_state state0;
+    int                     retval = -1;
+    conn_state              state0;
+    clixon_handle           h;
+    uint64_t                tid;
+    controller_transaction *ct;
+    struct timeval          tv;
 
     /* From state handling */
     state0 = device_handle_conn_state_get(dh);
-    if (state0 != CS_CLOSED && state0 != CS_OPEN){
+    /* Trace span of state left, from request sent until reply received */
+    h = device_handle_handle_get(dh);
+    if ((tid = device_handle_tid_get(dh)) != 0 &&
+        state0 != CS_OPEN &&
+        (ct = controller_transaction_find(h, tid)) != NULL){
+        device_handle_conn_time_get(dh, &tv);
+        if (controller_transaction_trace(ct, device_handle_name_get(dh),
+                                         device_state_int2str(state0), &tv, NULL) < 0)
+            goto done;
+    }
+    /* Leaving closed, eg user connect, any pending auto-reconnect is obsolete */
+    if (state0 == CS_CLOSED && state != CS_CLOSED)
+        device_handle_reconnect_next_set(dh, NULL);
+    /* Connected, restart auto-reconnect backoff */
+    if (state == CS_OPEN)
+        device_handle_reconnect_attempts_set(dh, 0);
+    if (state0 != CS_CLOSED && state0 != CS_OPEN &&
+        state0 != CS_CONNECT_PENDING && state0 != CS_PUSH_QUEUE){
+        /* Reply received, unless closed on error */
+        if (state != CS_CLOSED &&
+            device_state_latency_sample(dh, state0) < 0)
+            goto done;
         if (device_state_timeout_unregister(dh) < 0)
             goto done;
     }
     /* To state handling */
     device_handle_conn_state_set(dh, state);
-    if (state != CS_CLOSED && state != CS_OPEN){
+    /* Connect pending and push queue wait for other devices which have their own timeouts */
+    if (state != CS_CLOSED && state != CS_OPEN &&
+        state != CS_CONNECT_PENDING && state != CS_PUSH_QUEUE){
         if (device_state_timeout_register(dh) < 0)
             goto done;
     }
+    /* Handshake slot freed, schedule pending connects */
+    if (device_state_handshake(state0) && !device_state_handshake(state)){
+        if (device_connect_schedule_register(device_handle_handle_get(dh), NULL) < 0)
+            goto done;
+    }
     retval = 0;
  done:
     return retval;
@@ -759,21 +1261,367 @@ device_config_copy(clixon_handle h,
         clixon_err(OE_UNIX, errno, "cbuf_new");
         goto done;
     }
-    if ((db1 = cbuf_new()) == NULL){
-        clixon_err(OE_UNIX, errno, "cbuf_new");
+    if ((db1 = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    cprintf(db0, "device-%s-%s", devname, from);
+    cprintf(db1, "device-%s-%s", devname, to);
+    if (xmldb_copy(h, cbuf_get(db0), cbuf_get(db1)) < 0)
+        goto done;
+    retval = 0;
+ done:
+    if (db0)
+        cbuf_free(db0);
+    if (db1)
+        cbuf_free(db1);
+    return retval;
+}
+
+/*! Compute content hash of local (cached) device datastore
+ *
+ * 64-bit FNV-1a over the canonical (sorted, non-pretty) XML of the device config
+ * @param[in]  h           Clixon handle
+ * @param[in]  devname     Device name
+ * @param[in]  config_type Device config type, eg SYNCED, or RUNNING for the device config
+ *                         in the running datastore
+ * @param[out] hash        Hash as hex string
+ * @param[in]  len         Length of hash buffer, at least 17
+ * @retval     1           OK
+ * @retval     0           No such device tree
+ * @retval    -1           Error
+ */
+int
+device_config_hash(clixon_handle h,
+                   char         *devname,
+                   char         *config_type,
+                   char         *hash,
+                   size_t        len)
+{
+    int      retval = -1;
+    cxobj   *xroot = NULL;
+    cbuf    *cberr = NULL;
+    cbuf    *cb = NULL;
+    char    *str;
+    uint64_t fnv = 0xcbf29ce484222325ULL;
+    cxobj   *xt = NULL;
+    cxobj   *x;
+    char     q;
+    int      ret;
+
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    if (strcmp(config_type, "RUNNING") == 0){
+        q = strchr(devname, '\'') ? '"' : '\'';
+        cprintf(cb, "devices/device[name=%c%s%c]/config", q, devname, q);
+        if (xmldb_get0(h, "running", YB_MODULE, NULL, cbuf_get(cb), 1, WITHDEFAULTS_EXPLICIT, &xt, NULL, NULL) < 0)
+            goto done;
+        if ((x = xpath_first(xt, NULL, "%s", cbuf_get(cb))) == NULL)
+            goto fail;
+        xml_rm(x);
+        xroot = x;
+        cbuf_reset(cb);
+    }
+    else {
+        if ((ret = device_config_read(h, devname, config_type, &xroot, &cberr)) < 0)
+            goto done;
+        if (ret == 0)
+            goto fail;
+    }
+    if (xml_sort_recurse(xroot) < 0)
+        goto done;
+    if (clixon_xml2cbuf(cb, xroot, 0, 0, NULL, -1, 1) < 0)
+        goto done;
+    for (str = cbuf_get(cb); *str; str++){
+        fnv ^= (unsigned char)*str;
+        fnv *= 0x100000001b3ULL;
+    }
+    snprintf(hash, len, "%016" PRIx64, fnv);
+    retval = 1;
+ done:
+    if (cb)
+        cbuf_free(cb);
+    if (cberr)
+        cbuf_free(cberr);
+    if (xroot)
+        xml_free(xroot);
+    if (xt)
+        xml_free(xt);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Get filename of persisted device handle state
+ *
+ * @param[in]  h        Clixon handle
+ * @param[in]  devname  Device name
+ * @param[out] cb       Filename
+ * @retval     0        OK
+ * @retval    -1        Error
+ */
+static int
+device_state_persist_file(clixon_handle h,
+                          char         *devname,
+                          cbuf         *cb)
+{
+    char *dir;
+
+    if ((dir = clicon_option_str(h, "CLICON_XMLDB_DIR")) == NULL){
+        clixon_err(OE_CFG, ENOENT, "CLICON_XMLDB_DIR not set");
+        return -1;
+    }
+    cprintf(cb, "%s/device-%s-STATE.xml", dir, devname);
+    return 0;
+}
+
+/*! Persist device handle state for warm restart
+ *
+ * Saves capabilities, yang-library, sync time and SYNCED hash of a device, so that a
+ * restarted backend can skip schema discovery and the sync commit if nothing changed.
+ * Called after the SYNCED datastore of the device is written. No-op unless warm-restart is set.
+ * The file is written to a temporary file which is renamed, so that it is never partial.
+ * @param[in]  h        Clixon handle
+ * @param[in]  dh       Device handle
+ * @retval     0        OK
+ * @retval    -1        Error
+ * @see device_state_warm_check
+ */
+int
+device_state_persist(clixon_handle h,
+                     device_handle dh)
+{
+    int            retval = -1;
+    char          *name;
+    cbuf          *cb = NULL;
+    cxobj         *xt = NULL;
+    cxobj         *x;
+    cxobj         *xylib;
+    FILE          *f = NULL;
+    cbuf          *cbtmp = NULL;
+    struct timeval tv;
+    char           hash[32];
+    int            ret;
+
+    if (clicon_data_int_get(h, "controller-warm-restart") != 1)
+        goto ok;
+    name = device_handle_name_get(dh);
+    if ((cb = cbuf_new()) == NULL ||
+        (cbtmp = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    if ((ret = device_config_hash(h, name, "SYNCED", hash, sizeof(hash))) < 0)
+        goto done;
+    if (ret == 0)
+        goto ok;
+    device_handle_sync_time_get(dh, &tv);
+    cprintf(cb, "<device-state><name>%s</name><sync-time>%ld.%06ld</sync-time><synced-hash>%s</synced-hash>",
+            name, (long)tv.tv_sec, (long)tv.tv_usec, hash);
+    cprintf(cb, "<yang-lib/></device-state>");
+    if (clixon_xml_parse_string(cbuf_get(cb), YB_NONE, NULL, &xt, NULL) < 0)
+        goto done;
+    if ((x = device_handle_capabilities_get(dh)) != NULL){
+        if ((x = xml_dup(x)) == NULL)
+            goto done;
+        if (xml_addsub(xml_find_type(xt, NULL, "device-state", CX_ELMNT), x) < 0)
+            goto done;
+    }
+    if ((xylib = device_handle_yang_lib_get(dh)) != NULL){
+        if ((x = xml_dup(xylib)) == NULL)
+            goto done;
+        if (xml_addsub(xpath_first(xt, NULL, "device-state/yang-lib"), x) < 0)
+            goto done;
+    }
+    cbuf_reset(cb);
+    if (device_state_persist_file(h, name, cb) < 0)
+        goto done;
+    cprintf(cbtmp, "%s.%u", cbuf_get(cb), getpid());
+    if ((f = fopen(cbuf_get(cbtmp), "w")) == NULL){
+        clixon_err(OE_UNIX, errno, "fopen(%s)", cbuf_get(cbtmp));
+        goto done;
+    }
+    if (clixon_xml2file(f, xml_find_type(xt, NULL, "device-state", CX_ELMNT), 0, 0, NULL, fprintf, 0, 0) < 0)
+        goto done;
+    if (fflush(f) != 0 || fsync(fileno(f)) < 0){
+        clixon_err(OE_UNIX, errno, "fsync(%s)", cbuf_get(cbtmp));
+        goto done;
+    }
+    fclose(f);
+    f = NULL;
+    if (rename(cbuf_get(cbtmp), cbuf_get(cb)) < 0){
+        clixon_err(OE_UNIX, errno, "rename(%s)", cbuf_get(cb));
+        unlink(cbuf_get(cbtmp));
+        goto done;
+    }
+ ok:
+    retval = 0;
+ done:
+    if (f){
+        fclose(f);
+        unlink(cbuf_get(cbtmp));
+    }
+    if (xt)
+        xml_free(xt);
+    if (cb)
+        cbuf_free(cb);
+    if (cbtmp)
+        cbuf_free(cbtmp);
+    return retval;
+}
+
+/*! Remove persisted device handle state, eg when device is removed
+ *
+ * @param[in]  h        Clixon handle
+ * @param[in]  devname  Device name
+ * @retval     0        OK, also if not persisted
+ * @retval    -1        Error
+ * @see device_state_persist
+ */
+int
+device_state_persist_remove(clixon_handle h,
+                            char         *devname)
+{
+    int   retval = -1;
+    cbuf *cb = NULL;
+
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    if (device_state_persist_file(h, devname, cb) < 0)
+        goto done;
+    if (unlink(cbuf_get(cb)) < 0 && errno != ENOENT){
+        clixon_err(OE_UNIX, errno, "unlink(%s)", cbuf_get(cb));
+        goto done;
+    }
+    retval = 0;
+ done:
+    if (cb)
+        cbuf_free(cb);
+    return retval;
+}
+
+/*! Check if device can be warm restarted from persisted handle state
+ *
+ * Called after hello. The capabilities of the device must be equal to the persisted, and if
+ * the device has a configured module-set, it must be equal to the persisted yang-library.
+ * All persisted YANGs must also exist locally.
+ * If so, the yang-library and sync time are restored and the persisted SYNCED hash is set as
+ * pending warm sync, see device_state_recv_config.
+ * A persisted file that cannot be parsed is ignored, ie a full connect is made.
+ * @param[in]  h        Clixon handle
+ * @param[in]  dh       Device handle
+ * @retval     1        Warm restart, skip schema discovery
+ * @retval     0        No persisted state or mismatch, make full connect
+ * @retval    -1        Error
+ * @see device_state_persist
+ */
+static int
+device_state_warm_check(clixon_handle h,
+                        device_handle dh)
+{
+    int            retval = -1;
+    char          *name;
+    cbuf          *cb = NULL;
+    FILE          *f = NULL;
+    cxobj         *xt = NULL;
+    cxobj         *xs;
+    cxobj         *xcaps;
+    cxobj         *xylib;
+    cxobj         *xylib0;
+    cxobj        **vec = NULL;
+    size_t         veclen;
+    char          *hash;
+    char          *str;
+    char          *mod;
+    int            i;
+    long           sec = 0;
+    long           usec = 0;
+    struct timeval tv;
+    int            ret;
+
+    if (device_handle_warm_hash_set(dh, NULL) < 0)
+        goto done;
+    if (clicon_data_int_get(h, "controller-warm-restart") != 1)
+        goto fail;
+    name = device_handle_name_get(dh);
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    if (device_state_persist_file(h, name, cb) < 0)
+        goto done;
+    if ((f = fopen(cbuf_get(cb), "r")) == NULL)
+        goto fail; /* Not persisted */
+    if ((ret = clixon_xml_parse_file(f, YB_NONE, NULL, &xt, NULL)) < 1){
+        clixon_log(h, LOG_WARNING, "%s: Invalid persisted state %s, cold start: %s",
+                   name, cbuf_get(cb), clixon_err_reason());
+        clixon_err_reset();
+        goto fail;
+    }
+    if ((xs = xml_find_type(xt, NULL, "device-state", CX_ELMNT)) == NULL ||
+        (hash = xml_find_body(xs, "synced-hash")) == NULL)
+        goto fail;
+    /* Capabilities of hello must be unchanged */
+    if ((xcaps = xml_find_type(xs, NULL, "capabilities", CX_ELMNT)) == NULL ||
+        device_handle_capabilities_get(dh) == NULL ||
+        xml_tree_equal(xcaps, device_handle_capabilities_get(dh)) != 0){
+        clixon_debug(CLIXON_DBG_DEFAULT, "%s %s: capabilities changed", __FUNCTION__, name);
+        goto fail;
+    }
+    if ((xylib = xpath_first(xs, NULL, "yang-lib/*")) == NULL)
+        goto fail;
+    /* Configured module-set must be unchanged */
+    if ((xylib0 = device_handle_yang_lib_get(dh)) != NULL &&
+        xml_tree_equal(xylib0, xylib) != 0){
+        clixon_debug(CLIXON_DBG_DEFAULT, "%s %s: module-set changed", __FUNCTION__, name);
+        goto fail;
+    }
+    /* All YANGs must exist locally, without them schema discovery is necessary */
+    if (xpath_vec(xylib, NULL, "module-set/module", &vec, &veclen) < 0)
         goto done;
+    if (veclen == 0)
+        goto fail;
+    for (i=0; i<veclen; i++){
+        if ((mod = xml_find_body(vec[i], "name")) == NULL)
+            continue;
+        if ((ret = yang_file_find_match(h, mod, xml_find_body(vec[i], "revision"), NULL)) < 0)
+            goto done;
+        if (ret == 0)
+            goto fail;
     }
-    cprintf(db0, "device-%s-%s", devname, from);
-    cprintf(db1, "device-%s-%s", devname, to);
-    if (xmldb_copy(h, cbuf_get(db0), cbuf_get(db1)) < 0)
+    if (xylib0 == NULL){
+        if (xml_rm(xylib) < 0)
+            goto done;
+        if (device_handle_yang_lib_set(dh, xylib) < 0)
+            goto done;
+    }
+    if ((str = xml_find_body(xs, "sync-time")) != NULL &&
+        sscanf(str, "%ld.%ld", &sec, &usec) == 2){
+        tv.tv_sec = sec;
+        tv.tv_usec = usec;
+        device_handle_sync_time_set(dh, &tv);
+    }
+    if (device_handle_warm_hash_set(dh, hash) < 0)
         goto done;
-    retval = 0;
+    retval = 1;
  done:
-    if (db0)
-        cbuf_free(db0);
-    if (db1)
-        cbuf_free(db1);
+    if (vec)
+        free(vec);
+    if (xt)
+        xml_free(xt);
+    if (f)
+        fclose(f);
+    if (cb)
+        cbuf_free(cb);
     return retval;
+ fail:
+    retval = 0;
+    goto done;
 }
 
 /*! Compare transient and last synced
@@ -947,6 +1795,7 @@ device_state_check_fail(clixon_handle           h,
  * If no other devices are left in the transaction, then as last device resolve transaction:
  * - To failed if already resolved
  * - To success if not failures yet
+ * Otherwise, if the device was the last of a push wave, start the next wave
  * @param[in]  h     Clixon handle
  * @param[in]  dh    Device handle.
  * @param[in]  ct    Controller transaction
@@ -977,6 +1826,9 @@ device_state_check_ok(clixon_handle           h,
         if (controller_transaction_done(h, ct, -1) < 0)
             goto done;
     }
+    /* 2.2.2.3 If last device of push wave, start next wave */
+    else if (controller_transaction_push_wave(h, ct) < 0)
+        goto done;
     retval = 0;
  done:
     return retval;
@@ -1014,6 +1866,128 @@ device_state_check_sanity(device_handle           dh,
     return 1;
 }
 
+/*! Get RFC 8526 content-id from yang-library capability of hello and set it as pending
+ *
+ * The capability is on the form:
+ *   urn:ietf:params:netconf:capability:yang-library:1.1?revision=<date>&content-id=<content-id>
+ * @param[in]  dh   Device handle
+ * @retval     1    Content-id found and set as pending
+ * @retval     0    Not found, pending content-id cleared
+ * @retval    -1    Error
+ */
+static int
+device_state_content_id_hello(device_handle dh)
+{
+    int   retval = -1;
+    char *cap;
+    char *p;
+    char *cid = NULL;
+    int   len;
+
+    if (device_handle_content_id_set(dh, 1, NULL) < 0)
+        goto done;
+    if ((cap = device_handle_capabilities_prefix(dh, YANG_LIBRARY_CAPABILITY "?")) == NULL)
+        goto fail;
+    if ((p = strstr(cap, "content-id=")) == NULL)
+        goto fail;
+    p += strlen("content-id=");
+    len = strcspn(p, "&");
+    if (len == 0)
+        goto fail;
+    if ((cid = strndup(p, len)) == NULL){
+        clixon_err(OE_UNIX, errno, "strndup");
+        goto done;
+    }
+    if (device_handle_content_id_set(dh, 1, cid) < 0)
+        goto done;
+    retval = 1;
+ done:
+    if (cid)
+        free(cid);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Set pending content-id as content-id of yang-library when schema discovery is done
+ *
+ * @param[in]  dh   Device handle
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+device_state_content_id_commit(device_handle dh)
+{
+    char *cid;
+
+    if ((cid = device_handle_content_id_get(dh, 1)) == NULL)
+        return 0;
+    if (device_handle_content_id_set(dh, 0, cid) < 0)
+        return -1;
+    return device_handle_content_id_set(dh, 1, NULL);
+}
+
+/*! Look up module-set of pending content-id among devices with known yang-library
+ *
+ * A device matches if it has the same content-id and the same capabilities, or if it is the
+ * device itself from an earlier connect. Devices in schema discovery are skipped.
+ * On match, the yang-library is copied to the device and no schema discovery is necessary.
+ * @param[in]  h    Clixon handle
+ * @param[in]  dh   Device handle with pending content-id
+ * @retval     1    Found, yang-library of device set
+ * @retval     0    Not found, make schema discovery
+ * @retval    -1    Error
+ * @see device_state_content_id_commit  Content-id is set when schema discovery is done
+ */
+static int
+device_state_content_id_lookup(clixon_handle h,
+                               device_handle dh)
+{
+    int           retval = -1;
+    device_handle dh1;
+    char         *cid;
+    char         *cid1;
+    cxobj        *xylib;
+
+    if ((cid = device_handle_content_id_get(dh, 1)) == NULL)
+        goto fail;
+    dh1 = NULL;
+    while ((dh1 = device_handle_each(h, dh1)) != NULL){
+        if (dh1 != dh && device_state_handshake(device_handle_conn_state_get(dh1)))
+            continue;
+        if ((cid1 = device_handle_content_id_get(dh1, 0)) == NULL ||
+            strcmp(cid, cid1) != 0)
+            continue;
+        if ((xylib = device_handle_yang_lib_get(dh1)) == NULL)
+            continue;
+        if (dh1 == dh ||
+            xml_tree_equal(device_handle_capabilities_get(dh), device_handle_capabilities_get(dh1)) == 0)
+            break;
+    }
+    if (dh1 == NULL){
+        if (device_handle_content_id_set(dh, 0, NULL) < 0)
+            goto done;
+        goto fail;
+    }
+    clixon_debug(CLIXON_DBG_DEFAULT, "%s %s: content-id %s cached by %s", __FUNCTION__,
+                 device_handle_name_get(dh), cid, device_handle_name_get(dh1));
+    if (dh1 != dh){
+        if ((xylib = xml_dup(xylib)) == NULL)
+            goto done;
+        if (device_handle_yang_lib_append(dh, xylib) < 0) /* xylib consumed */
+            goto done;
+    }
+    if (device_state_content_id_commit(dh) < 0)
+        goto done;
+    retval = 1;
+ done:
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
 /*! Main state machine for controller transactions+devices
  *
  * @param[in]  h     Clixon handle
@@ -1042,6 +2016,9 @@ device_state_handler(clixon_handle h,
     cbuf       *cberr = NULL;
     cbuf       *cbmsg;
     cxobj      *xyanglib;
+    int         warm;
+    int         cached;
+    char       *cid;
 
     rpcname = xml_name(xmsg);
     conn_state = device_handle_conn_state_get(dh);
@@ -1080,8 +2057,29 @@ device_state_handler(clixon_handle h,
                 break;
             }
         }
-        if (!device_handle_capabilities_find(dh, "urn:ietf:params:xml:ns:yang:ietf-netconf-monitoring")){
-            clixon_debug(CLIXON_DBG_DEFAULT, "%s Device %s: Netconf monitoring capability not announced", __FUNCTION__, name);
+        /* Warm restart from persisted state: skip schema discovery as if local YANGs */
+        if ((warm = device_state_warm_check(h, dh)) < 0)
+            goto done;
+        /* RFC 8526 content-id in hello: reuse module-set of same content-id */
+        cached = 0;
+        if (!warm &&
+            device_handle_capabilities_find(dh, "urn:ietf:params:xml:ns:yang:ietf-netconf-monitoring")){
+            if ((ret = device_state_content_id_hello(dh)) < 0)
+                goto done;
+            if (ret == 1 &&
+                (cached = device_state_content_id_lookup(h, dh)) < 0)
+                goto done;
+        }
+        if (warm || cached)
+            xyanglib = device_handle_yang_lib_get(dh);
+        if (warm || cached ||
+            !device_handle_capabilities_find(dh, "urn:ietf:params:xml:ns:yang:ietf-netconf-monitoring")){
+            if (warm)
+                clixon_debug(CLIXON_DBG_DEFAULT, "%s Device %s: Warm restart, schema discovery skipped", __FUNCTION__, name);
+            else if (cached)
+                clixon_debug(CLIXON_DBG_DEFAULT, "%s Device %s: Content-id cached, schema discovery skipped", __FUNCTION__, name);
+            else
+                clixon_debug(CLIXON_DBG_DEFAULT, "%s Device %s: Netconf monitoring capability not announced", __FUNCTION__, name);
             if (xyanglib == NULL){
                 if (controller_transaction_failed(h, tid, ct, dh, TR_FAILED_DEV_CLOSE, name, "No YANG device lib") < 0)
                     goto done;
@@ -1120,11 +2118,72 @@ device_state_handler(clixon_handle h,
         }
         else
             clixon_debug(CLIXON_DBG_DEFAULT, "%s Device %s: Netconf monitoring capability announced", __FUNCTION__, name);
+        /* ietf-yang-library without content-id in hello: get content-id first */
+        if (device_handle_content_id_get(dh, 1) == NULL &&
+            device_handle_capabilities_prefix(dh, YANG_LIBRARY_NAMESPACE "?") != NULL){
+            if (device_send_get_content_id(h, dh, s) < 0)
+                goto done;
+            if (device_state_set(dh, CS_SCHEMA_CONTENT_ID) < 0)
+                goto done;
+            break;
+        }
         if ((ret = device_send_get_schema_list(h, dh, s)) < 0)
             goto done;
         if (device_state_set(dh, CS_SCHEMA_LIST) < 0)
             goto done;
         break;
+    case CS_SCHEMA_CONTENT_ID:
+        if (device_state_check_sanity(dh, tid, ct, name, conn_state, rpcname) == 0)
+            break;
+        /* Receive yang-library content-id from device */
+        if ((ret = device_state_recv_content_id(dh, xmsg, rpcname, conn_state, &cid)) < 0)
+            goto done;
+        if (ret == 0){ /* closed */
+            if (controller_transaction_failed(h, tid, ct, dh, TR_FAILED_DEV_LEAVE, name, device_handle_logmsg_get(dh)) < 0)
+                goto done;
+            break;
+        }
+        /* The device is OK */
+        if (ct->ct_state == TS_RESOLVED && ct->ct_result == TR_SUCCESS){
+            clixon_err(OE_XML, 0, "Transaction unexpected SUCCESS state");
+            goto done;
+        }
+        if (device_handle_content_id_set(dh, 1, cid) < 0)
+            goto done;
+        if ((ret = device_state_content_id_lookup(h, dh)) < 0)
+            goto done;
+        if (ret == 0){ /* Not cached, get schema list */
+            if ((ret = device_send_get_schema_list(h, dh, s)) < 0)
+                goto done;
+            if (device_state_set(dh, CS_SCHEMA_LIST) < 0)
+                goto done;
+            break;
+        }
+        clixon_debug(CLIXON_DBG_DEFAULT, "%s Device %s: Content-id cached, schema discovery skipped", __FUNCTION__, name);
+        xyanglib = device_handle_yang_lib_get(dh);
+        yspec1 = NULL;
+        if (controller_mount_yspec_get(h, name, &yspec1) < 0)
+            goto done;
+        if (yspec1 == NULL){
+            if (device_shared_yspec(h, dh, xyanglib, &yspec1) < 0)
+                goto done;
+            if (controller_mount_yspec_set(h, name, yspec1) < 0)
+                goto done;
+        }
+        /* All schemas ready, parse them */
+        if ((ret = device_schemas_mount_parse(h, dh, xyanglib)) < 0)
+            goto done;
+        if (ret == 0){
+            if (controller_transaction_failed(h, tid, ct, dh, TR_FAILED_DEV_LEAVE, name, device_handle_logmsg_get(dh)) < 0)
+                goto done;
+            break;
+        }
+        /* Unconditionally sync */
+        if (device_send_get_config(h, dh, s) < 0)
+            goto done;
+        if (device_state_set(dh, CS_DEVICE_SYNC) < 0)
+            goto done;
+        break;
     case CS_SCHEMA_LIST:
         if (device_state_check_sanity(dh, tid, ct, name, conn_state, rpcname) == 0)
             break;
@@ -1169,6 +2228,9 @@ device_state_handler(clixon_handle h,
                     goto done;
                 break;
             }
+            /* Module-set of content-id is now known */
+            if (device_state_content_id_commit(dh) < 0)
+                goto done;
             /* Unconditionally sync */
             if (device_send_get_config(h, dh, s) < 0)
                 goto done;
@@ -1214,6 +2276,9 @@ device_state_handler(clixon_handle h,
                     goto done;
                 break;
             }
+            /* Module-set of content-id is now known */
+            if (device_state_content_id_commit(dh) < 0)
+                goto done;
             /* Unconditionally sync */
             if (device_send_get_config(h, dh, s) < 0)
                 goto done;
@@ -1312,6 +2377,8 @@ device_state_handler(clixon_handle h,
         }
         if (clicon_msg_send1(s, device_handle_name_get(dh), cbmsg) < 0)
             goto done;
+        if (device_handle_stats_send(dh, DR_EDIT_CONFIG, cbuf_len(cbmsg)) < 0)
+            goto done;
         if (device_state_set(dh, CS_PUSH_EDIT) < 0)
             goto done;
         break;
@@ -1395,8 +2462,10 @@ device_state_handler(clixon_handle h,
                2.2.1.1 Trigger COMMIT of all devices and set this device into CS_PUSH_COMMIT */
             if (controller_transaction_wait_trigger(h, tid, 1) < 0)
                 goto done;
-            /* Not running */
-            if (ct->ct_actions_type != AT_NONE && strcmp(ct->ct_sourcedb, "candidate")==0){
+            /* Not running. Local commit is made once, in the last push wave, so that a
+             * failed earlier wave leaves running unchanged */
+            if (ct->ct_actions_type != AT_NONE && strcmp(ct->ct_sourcedb, "candidate")==0 &&
+                controller_transaction_push_queued(h, tid) == 0){
                 if ((cberr = cbuf_new()) == NULL){
                     clixon_err(OE_UNIX, errno, "cbuf_new");
                     goto done;
@@ -1501,6 +2570,8 @@ device_state_handler(clixon_handle h,
                     clixon_err(OE_XML, 0, "%s", cbuf_get(cberr));
                     goto done;
                 }
+                if (device_state_persist(h, dh) < 0)
+                    goto done;
             }
             if (cb)
                 cbuf_free(cb);
@@ -1588,6 +2659,7 @@ device_state_handler(clixon_handle h,
         if (device_state_check_ok(h, dh, ct) < 0)
             goto done;
         break;
+    case CS_PUSH_QUEUE:
     case CS_PUSH_WAIT:
     case CS_CLOSED:
     case CS_OPEN:
@@ -1610,8 +2682,248 @@ device_state_handler(clixon_handle h,
     return retval;
 }
 
+/*! Get local name of first or last step of an xpath, without prefix and predicates
+ *
+ * @param[in]  xpath  XPath
+ * @param[in]  last   If set get last step, else first step
+ * @param[out] cb     Name of step, empty if step is not a name, eg "/", "." or "*"
+ * @retval     0      OK
+ */
+int
+statedata_xpath_step(char *xpath,
+                     int   last,
+                     cbuf *cb)
+{
+    char *step;
+    char *s;
+    char *p;
+    int   depth = 0;
+
+    step = xpath;
+    if (last){
+        for (s = xpath; *s != '\0'; s++){
+            if (*s == '[')
+                depth++;
+            else if (*s == ']')
+                depth--;
+            else if (*s == '/' && depth == 0)
+                step = s+1;
+        }
+    }
+    else if (*step == '/')
+        step++;
+    for (s = step; *s != '\0' && *s != '/' && *s != '['; s++)
+        if (*s == ':')
+            step = s+1;
+    if (!isalpha(*step))
+        return 0;
+    for (p = step; p < s; p++)
+        cprintf(cb, "%c", *p);
+    return 0;
+}
+
+/*! Check if an xpath refers to a node name in any step, also in predicates
+ *
+ * Names are compared without prefix, and quoted literals are skipped.
+ * @param[in]  xpath  XPath
+ * @param[in]  name   Node name
+ * @retval     1      Name found
+ * @retval     0      Not found
+ */
+static int
+statedata_xpath_name(char *xpath,
+                     char *name)
+{
+    char  *s;
+    char  *t;
+    char   q;
+    size_t len;
+
+    len = strlen(name);
+    s = xpath;
+    while (*s != '\0'){
+        if (*s == '\'' || *s == '"'){ /* Skip literal */
+            q = *s++;
+            while (*s != '\0' && *s != q)
+                s++;
+            if (*s != '\0')
+                s++;
+        }
+        else if (isalpha(*s) || *s == '_'){
+            for (t = s; isalnum(*t) || *t == '_' || *t == '-' || *t == '.'; t++);
+            if (*t != ':' && t-s == len && strncmp(s, name, len) == 0)
+                return 1;
+            s = t;
+        }
+        else
+            s++;
+    }
+    return 0;
+}
+
+/*! Get device name if xpath selects a single device
+ *
+ * Accepts xpaths on the form: /devices/device[name='x']... with optional prefixes,
+ * where the name predicate is the whole predicate, eg not [name='x' or name='y']
+ * @param[in]  xpath  XPath
+ * @param[out] cb     Device name, empty if xpath does not select a single device
+ * @retval     0      OK
+ */
+static int
+statedata_xpath_device(char *xpath,
+                       cbuf *cb)
+{
+    char *s;
+    char *p;
+    char  q;
+
+    if (strchr(xpath, '|') != NULL || strstr(xpath, "//") != NULL)
+        return 0;
+    if ((s = strstr(xpath, "device[")) == NULL)
+        return 0;
+    if (s != xpath && *(s-1) != '/' && *(s-1) != ':')
+        return 0;
+    s += strlen("device[");
+    if ((p = strchr(s, ':')) != NULL && p < strchr(s, '='))
+        s = p+1;
+    if (strncmp(s, "name", strlen("name")) != 0)
+        return 0;
+    s += strlen("name");
+    while (isspace(*s))
+        s++;
+    if (*s++ != '=')
+        return 0;
+    while (isspace(*s))
+        s++;
+    if ((q = *s++) != '\'' && q != '"')
+        return 0;
+    if ((p = strchr(s, q)) == NULL || *(p+1) != ']')
+        return 0;
+    while (s < p)
+        cprintf(cb, "%c", *s++);
+    return 0;
+}
+
+/*! Add state data of one device as XML
+ *
+ * @param[in]  dh     Device handle
+ * @param[in]  caps   If set, add capabilities
+ * @param[in]  stats  If set, add statistics
+ * @param[in]  xdevs  XML devices container
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+static int
+device_statedata(device_handle dh,
+                 int           caps,
+                 int           stats,
+                 cxobj        *xdevs)
+{
+    int            retval = -1;
+    cxobj         *xd;
+    cxobj         *xc;
+    cxobj         *xl;
+    cxobj         *xcaps;
+    cxobj         *x;
+    char          *xb;
+    char          *logmsg;
+    char          *cid;
+    struct timeval tv;
+    char           timestr[28];
+    char           nr[16];
+    conn_state     cs;
+    uint32_t       samples;
+    uint32_t       ewma;
+    uint32_t       p99;
+    uint32_t       ms;
+    uint32_t       attempts;
+
+    if ((xd = xml_new("device", xdevs, CX_ELMNT)) == NULL)
+        goto done;
+    if (xml_new_body("name", xd, device_handle_name_get(dh)) == NULL)
+        goto done;
+    if (xml_new_body("conn-state", xd, device_state_int2str(device_handle_conn_state_get(dh))) == NULL)
+        goto done;
+    if (caps && (xcaps = device_handle_capabilities_get(dh)) != NULL){
+        if ((xc = xml_new("capabilities", xd, CX_ELMNT)) == NULL)
+            goto done;
+        x = NULL;
+        while ((x = xml_child_each(xcaps, x, -1)) != NULL) {
+            if ((xb = xml_body(x)) == NULL)
+                continue;
+            if (xml_new_body("capability", xc, xb) == NULL)
+                goto done;
+        }
+    }
+    device_handle_conn_time_get(dh, &tv);
+    if (tv.tv_sec != 0){
+        if (time2str(&tv, timestr, sizeof(timestr)) < 0)
+            goto done;
+        if (xml_new_body("conn-state-timestamp", xd, timestr) == NULL)
+            goto done;
+    }
+    device_handle_sync_time_get(dh, &tv);
+    if (tv.tv_sec != 0){
+        if (time2str(&tv, timestr, sizeof(timestr)) < 0)
+            goto done;
+        if (xml_new_body("sync-timestamp", xd, timestr) == NULL)
+            goto done;
+    }
+    if ((logmsg = device_handle_logmsg_get(dh)) != NULL){
+        if (xml_new_body("logmsg", xd, logmsg) == NULL)
+            goto done;
+    }
+    if ((cid = device_handle_content_id_get(dh, 0)) != NULL){
+        if (xml_new_body("content-id", xd, cid) == NULL)
+            goto done;
+    }
+    if ((attempts = device_handle_reconnect_attempts_get(dh)) != 0){
+        snprintf(nr, sizeof(nr), "%u", attempts);
+        if (xml_new_body("reconnect-attempts", xd, nr) == NULL)
+            goto done;
+    }
+    device_handle_reconnect_next_get(dh, &tv);
+    if (tv.tv_sec != 0){
+        if (time2str(&tv, timestr, sizeof(timestr)) < 0)
+            goto done;
+        if (xml_new_body("reconnect-next", xd, timestr) == NULL)
+            goto done;
+    }
+    for (cs = 0; cs < CONN_STATE_NR; cs++){
+        if (device_handle_latency_get(dh, cs, &samples, &ewma, &p99) < 0)
+            goto done;
+        if (samples == 0)
+            continue;
+        if (device_state_timeout_get(dh, cs, &ms) < 0)
+            goto done;
+        if ((xl = xml_new("latency", xd, CX_ELMNT)) == NULL)
+            goto done;
+        if (xml_new_body("state", xl, device_state_int2str(cs)) == NULL)
+            goto done;
+        snprintf(nr, sizeof(nr), "%u", samples);
+        if (xml_new_body("samples", xl, nr) == NULL)
+            goto done;
+        snprintf(nr, sizeof(nr), "%u", ewma);
+        if (xml_new_body("ewma", xl, nr) == NULL)
+            goto done;
+        snprintf(nr, sizeof(nr), "%u", p99);
+        if (xml_new_body("p99", xl, nr) == NULL)
+            goto done;
+        snprintf(nr, sizeof(nr), "%u", ms);
+        if (xml_new_body("timeout", xl, nr) == NULL)
+            goto done;
+    }
+    if (stats && device_handle_stats2xml(dh, xd) < 0)
+        goto done;
+    retval = 0;
+ done:
+    return retval;
+}
+
 /*! Get netconf device statedata
  *
+ * State is only generated for the devices selected by xpath, and capabilities and
+ * statistics only if the xpath may select them.
  * @param[in]    h        Clixon handle
  * @param[in]    nsc      External XML namespace context, or NULL
  * @param[in]    xpath    String with XPath syntax. or NULL for all
@@ -1626,69 +2938,67 @@ devices_statedata(clixon_handle   h,
                   cxobj          *xstate)
 {
     int            retval = -1;
-    cxobj         *xret = NULL;
-    char          *name;
     device_handle  dh;
     cbuf          *cb = NULL;
-    conn_state     state;
-    char          *logmsg;
-    struct timeval tv;
-    cxobj         *xcaps;
-    cxobj         *x;
-    char          *xb;
-    char           timestr[28];
+    cxobj         *xdevs = NULL;
+    int            caps = 1;
+    int            stats = 1;
+    char          *step;
 
     if ((cb = cbuf_new()) == NULL){
         clixon_err(OE_UNIX, errno, "cbuf_new");
         goto done;
     }
-    dh = NULL;
-    while ((dh = device_handle_each(h, dh)) != NULL){
-        name = device_handle_name_get(dh);
-        cprintf(cb, "<devices xmlns=\"%s\"><device><name>%s</name>",
-                CONTROLLER_NAMESPACE,
-                name);
-        state = device_handle_conn_state_get(dh);
-        cprintf(cb, "<conn-state>%s</conn-state>", device_state_int2str(state));
-        if ((xcaps = device_handle_capabilities_get(dh)) != NULL){
-            cprintf(cb, "<capabilities>");
-            x = NULL;
-            while ((x = xml_child_each(xcaps, x, -1)) != NULL) {
-                if ((xb = xml_body(x)) == NULL)
-                    continue;
-                cprintf(cb, "<capability>");
-                xml_chardata_cbuf_append(cb, xb);
-                cprintf(cb, "</capability>");
-            }
-            cprintf(cb, "</capabilities>");
-        }
-        device_handle_conn_time_get(dh, &tv);
-        if (tv.tv_sec != 0){
-            if (time2str(&tv, timestr, sizeof(timestr)) < 0)
-                goto done;
-            cprintf(cb, "<conn-state-timestamp>%s</conn-state-timestamp>", timestr);
+    if (xpath && strchr(xpath, '|') == NULL){
+        /* Skip if xpath selects other top-level node */
+        if (statedata_xpath_step(xpath, 0, cb) < 0)
+            goto done;
+        if (cbuf_len(cb) && strcmp(cbuf_get(cb), "devices") != 0)
+            goto ok;
+        /* Skip capabilities and statistics if xpath selects other node below device */
+        cbuf_reset(cb);
+        if (statedata_xpath_step(xpath, 1, cb) < 0)
+            goto done;
+        step = cbuf_get(cb);
+        if (cbuf_len(cb) &&
+            strcmp(step, "devices") != 0 &&
+            strcmp(step, "device") != 0 &&
+            strstr(xpath, "//") == NULL){
+            caps = statedata_xpath_name(xpath, "capabilities") ||
+                statedata_xpath_name(xpath, "capability");
+            stats = statedata_xpath_name(xpath, "statistics");
         }
-        device_handle_sync_time_get(dh, &tv);
-        if (tv.tv_sec != 0){
-            if (time2str(&tv, timestr, sizeof(timestr)) < 0)
+    }
+    if ((xdevs = xml_new("devices", NULL, CX_ELMNT)) == NULL)
+        goto done;
+    if (xmlns_set(xdevs, NULL, CONTROLLER_NAMESPACE) < 0)
+        goto done;
+    cbuf_reset(cb);
+    if (xpath && statedata_xpath_device(xpath, cb) < 0)
+        goto done;
+    if (cbuf_len(cb)){ /* Single device */
+        if ((dh = device_handle_find(h, cbuf_get(cb))) != NULL &&
+            device_statedata(dh, caps, stats, xdevs) < 0)
+            goto done;
+    }
+    else {
+        dh = NULL;
+        while ((dh = device_handle_each(h, dh)) != NULL){
+            if (device_statedata(dh, caps, stats, xdevs) < 0)
                 goto done;
-            cprintf(cb, "<sync-timestamp>%s</sync-timestamp>", timestr);
-        }
-        if ((logmsg = device_handle_logmsg_get(dh)) != NULL){
-            cprintf(cb, "<logmsg>");
-            xml_chardata_cbuf_append(cb, logmsg);
-            cprintf(cb, "</logmsg>");
         }
-        cprintf(cb, "</device></devices>");
-        if (clixon_xml_parse_string(cbuf_get(cb), YB_NONE, NULL, &xstate, NULL) < 0)
-            goto done;
-        cbuf_reset(cb);
-    } /* devices */
+    }
+    if (xml_child_nr_type(xdevs, CX_ELMNT) == 0)
+        goto ok;
+    if (xml_addsub(xstate, xdevs) < 0)
+        goto done;
+    xdevs = NULL;
+ ok:
     retval = 0;
  done:
+    if (xdevs)
+        xml_free(xdevs);
     if (cb)
         cbuf_free(cb);
-    if (xret)
-        xml_free(xret);
     return retval;
 }
@@ -37,17 +37,21 @@
 
   CS_CLOSED
      ^      \ connect
-     |       v        send get
-     |<-- CS_CONNECTING
-     |       |
      |       v
-     |<-- CS_SCHEMA_LIST
+     |<-- CS_CONNECT_PENDING
+     |       | connect slot
+     |       v        send get
+     |<-- CS_CONNECTING --------+
+     |       |                  v
+     |       |<-------- CS_SCHEMA_CONTENT_ID
+     |       v                  | content-id cached
+     |<-- CS_SCHEMA_LIST        |
      |       |       \
      |       |        v
      |<-------- CS_SCHEMA_ONE(n) ---+
      |       |       /           <--+
-     |       v      v
-     |<-- CS_DEVICE_SYNC
+     |       v      v           |
+     |<-- CS_DEVICE_SYNC <------+
      |       |
      |       v
   CS_OPEN <-+
@@ -69,12 +73,15 @@ typedef void *device_handle; // duplicated from controller_device_handle.h
  */
 enum conn_state_t {
     CS_CLOSED = 0,    /* Closed, also "closed" if handle non-existent but then no state */
+    CS_CONNECT_PENDING, /* Waiting for connect slot, see connect-max-inflight (no timeout) */
     CS_CONNECTING,    /* Connect() called, expect to receive hello from device
                          May fail due to (1) connect fails or (2) hello not receivd */
+    CS_SCHEMA_CONTENT_ID, /* Get RFC 8525 yang-library content-id */
     CS_SCHEMA_LIST,   /* Get ietf-netconf-monitor schema state */
     CS_SCHEMA_ONE,    /* Connection established and Hello sent to device (nr substate) */
     CS_DEVICE_SYNC,   /* Get all config (transient+merge are sub-state parameters) */
     CS_OPEN,          /* Connection established and Hello sent to device. */
+    CS_PUSH_QUEUE,    /* Edit-msg prepared, waiting for push wave to start (no timeout) */
     CS_PUSH_LOCK,     /* Lock device candidate */
     CS_PUSH_CHECK,    /* sync device transient to check if device is unchanged */
     CS_PUSH_EDIT,     /* edit-config sent, waiting for reply */
@@ -88,6 +95,27 @@ enum conn_state_t {
 };
 typedef enum conn_state_t conn_state;
 
+/* Number of connection states, CS_PUSH_UNLOCK is last */
+#define CONN_STATE_NR (CS_PUSH_UNLOCK+1)
+
+/* Default lower bound of adaptive device timeout in seconds
+ * @see clixon-controller.yang device-timeout-min
+ */
+#define CONTROLLER_DEVICE_TIMEOUT_MIN_DEFAULT 2
+
+/* Number of latency samples of a state before its timeout is adapted */
+#define DEVICE_LATENCY_SAMPLES_MIN 4
+
+/* Default max number of devices in connect handshake, 0 is unlimited
+ * @see clixon-controller.yang connect-max-inflight
+ */
+#define CONTROLLER_CONNECT_MAX_INFLIGHT_DEFAULT 64
+
+/* Default max auto-reconnect backoff in s
+ * @see clixon-controller.yang reconnect-backoff-max
+ */
+#define CONTROLLER_RECONNECT_BACKOFF_MAX_DEFAULT 300
+
 /*! How to bind device configuration to YANG
  *
  * @see clixon-controller@2023-01-01.yang yang-config
@@ -120,9 +148,15 @@ int          device_state_mount_point_get(char *devicename, yang_stmt *yspec,
 int          device_state_timeout_register(device_handle ch);
 int          device_state_timeout_unregister(device_handle ch);
 int          device_state_set(device_handle dh, conn_state state);
+int          device_connect_schedule(clixon_handle h);
+int          device_reconnect_cancel(device_handle dh);
 int          device_config_read(clixon_handle h, char *devname, char *config_type, cxobj **xrootp, cbuf **cberr);
 int          device_config_write(clixon_handle h, char *name, char *config_type, cxobj *xdata, cbuf *cbret);
+int          device_config_hash(clixon_handle h, char *devname, char *config_type, char *hash, size_t len);
+int          device_state_persist(clixon_handle h, device_handle dh);
+int          device_state_persist_remove(clixon_handle h, char *devname);
 int          device_state_handler(clixon_handle h, device_handle ch, int s, cxobj *xmsg);
+int          statedata_xpath_step(char *xpath, int last, cbuf *cb);
 int          devices_statedata(clixon_handle h, cvec *nsc, char *xpath, cxobj *xstate);
 
 #ifdef __cplusplus
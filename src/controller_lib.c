@@ -55,6 +55,7 @@ static const map_str2int tsmap[] = {
     {"ACTIONS",   TS_ACTIONS},
     {"RESOLVED",  TS_RESOLVED},
     {"DONE",      TS_DONE},
+    {"QUEUED",    TS_QUEUED},
     {NULL,        -1}
 };
 
@@ -47,6 +47,7 @@ enum transaction_state_t{
     TS_ACTIONS,   /* Notified and waiting for actions */
     TS_RESOLVED,  /* The result of the transaction is set (if result == 0, this is same as CLOSED) */
     TS_DONE,      /* Terminated, inactive transaction */
+    TS_QUEUED,    /* Waiting in commit queue for ongoing transaction to terminate */
 };
 typedef enum transaction_state_t transaction_state;
 
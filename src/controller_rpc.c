@@ -57,6 +57,7 @@
 
 /*! Connect to device via Netconf SSH
  *
+ * The device is put in connect-pending state and is connected by the connect scheduler
  * @param[in]  h             Clixon handle
  * @param[in]  dh            Device handle, either NULL or in closed state
  * @param[in]  user          Username for ssh login
@@ -64,6 +65,7 @@
  * @param[in]  stricthostkey If set ensure strict hostkey checking. Only for ssh
  * @retval     0    OK
  * @retval    -1    Error
+ * @see device_connect_schedule
  */
 static int
 connect_netconf_ssh(clixon_handle h,
@@ -74,7 +76,6 @@ connect_netconf_ssh(clixon_handle h,
 {
     int   retval = -1;
     cbuf *cb = NULL;
-    int   s;
 
     if (addr == NULL || dh == NULL){
         clixon_err(OE_PLUGIN, EINVAL, "xn, addr or dh is NULL");
@@ -91,15 +92,9 @@ connect_netconf_ssh(clixon_handle h,
     if (user)
         cprintf(cb, "%s@", user);
     cprintf(cb, "%s", addr);
-    if (device_handle_connect(dh, CLIXON_CLIENT_SSH, cbuf_get(cb), stricthostkey) < 0)
+    if (device_handle_conn_dest_set(dh, cbuf_get(cb), stricthostkey) < 0)
         goto done;
-    if (device_state_set(dh, CS_CONNECTING) < 0)
-        goto done;
-    s = device_handle_socket_get(dh);
-    device_handle_framing_type_set(dh, NETCONF_SSH_EOM);
-    cbuf_reset(cb); /* reuse cb for event dbg str */
-    cprintf(cb, "Netconf ssh %s", addr);
-    if (clixon_event_reg_fd(s, device_input_cb, dh, cbuf_get(cb)) < 0)
+    if (device_state_set(dh, CS_CONNECT_PENDING) < 0)
         goto done;
     retval = 0;
  done:
@@ -140,6 +135,8 @@ controller_connect(clixon_handle           h,
     cxobj        *xmod = NULL;
     cxobj        *xyanglib = NULL;
     int           ssh_stricthostkey = 1;
+    uint32_t      backoff = 0;
+    uint32_t      backoff_max = CONTROLLER_RECONNECT_BACKOFF_MAX_DEFAULT;
 
     clixon_debug(CLIXON_DBG_DEFAULT, "%s", __FUNCTION__);
     if ((name = xml_find_body(xn, "name")) == NULL)
@@ -191,12 +188,30 @@ controller_connect(clixon_handle           h,
     }
     if (xb && (str = xml_body(xb)) != NULL)
         ssh_stricthostkey = strcmp(str, "true") == 0;
+    /* Auto-reconnect policy, device-profile used if not set on device */
+    if ((xb = xml_find_type(xn, NULL, "reconnect-backoff", CX_ELMNT)) == NULL ||
+        xml_flag(xb, XML_FLAG_DEFAULT)){
+        if (xdevprofile)
+            xb = xml_find_type(xdevprofile, NULL, "reconnect-backoff", CX_ELMNT);
+    }
+    if (xb && (str = xml_body(xb)) != NULL &&
+        parse_uint32(str, &backoff, NULL) < 1)
+        backoff = 0;
+    if ((xb = xml_find_type(xn, NULL, "reconnect-backoff-max", CX_ELMNT)) == NULL ||
+        xml_flag(xb, XML_FLAG_DEFAULT)){
+        if (xdevprofile)
+            xb = xml_find_type(xdevprofile, NULL, "reconnect-backoff-max", CX_ELMNT);
+    }
+    if (xb && (str = xml_body(xb)) != NULL &&
+        parse_uint32(str, &backoff_max, NULL) < 1)
+        backoff_max = CONTROLLER_RECONNECT_BACKOFF_MAX_DEFAULT;
     /* Now dh is either NULL or in closed state and with correct type
      * First create it if still NULL
      */
     if (dh == NULL &&
         (dh = device_handle_new(h, name)) == NULL)
         goto done;
+    device_handle_reconnect_set(dh, backoff, backoff_max);
     if ((xb = xml_find_type(xn, NULL, "yang-config", CX_ELMNT)) == NULL)
         goto ok;
     if (xml_flag(xb, XML_FLAG_DEFAULT) &&
@@ -241,8 +256,8 @@ controller_connect(clixon_handle           h,
  *
  * 1) get previous device synced xml
  * 2) get current and compute diff with previous
- * 3) construct an edit-config, send it and validate it
- * 4) phase 2 commit
+ * 3) construct an edit-config and put device in push queue
+ * 4) lock, edit, validate and phase 2 commit when push wave starts
  * @param[in]  h       Clixon handle
  * @param[in]  xe      Request: <rpc><xn></rpc>
  * @param[in]  ct      Transaction
@@ -277,7 +292,9 @@ push_device_one(clixon_handle           h,
     cbuf      *cbmsg = NULL;
     int        ret;
     cvec      *nsc = NULL;
+    struct timeval t0;
 
+    gettimeofday(&t0, NULL);
     /* 1) get previous device synced xml */
     name = device_handle_name_get(dh);
     if ((ret = device_config_read(h, name, "SYNCED", &x0, cberr)) < 0)
@@ -331,16 +348,16 @@ push_device_one(clixon_handle           h,
                                            &cbmsg) < 0)
             goto done;
         device_handle_outmsg_set(dh, cbmsg);
-        if (device_send_lock(h, dh, 1) < 0)
-            goto done;
+        /* Lock is sent when the push wave of the device starts */
         device_handle_tid_set(dh, ct->ct_id);
-        if (device_state_set(dh, CS_PUSH_LOCK) < 0)
+        if (device_state_set(dh, CS_PUSH_QUEUE) < 0)
             goto done;
-
     }
     else{
         device_handle_tid_set(dh, 0);
     }
+    if (controller_transaction_trace(ct, name, "diff", &t0, NULL) < 0)
+        goto done;
     retval = 1;
  done:
     if (dvec)
@@ -394,24 +411,84 @@ pull_device_one(clixon_handle h,
     return retval;
 }
 
+/*! Begin transaction of an incoming rpc: create new, activate queued or put in commit queue
+ *
+ * @param[in]  h           Clixon handle
+ * @param[in]  description Description of transaction
+ * @param[in]  xe          Request: <rpc><xn></rpc>
+ * @param[in]  client_id   Client id of originator
+ * @param[in]  fn          Start function called with xe if transaction is queued
+ * @param[in]  ctq         Dequeued transaction to activate, or NULL
+ * @param[out] ctp         Active transaction (if retval = 1)
+ * @param[out] cbret       Return xml tree, <rpc-reply> with queued tid, or <rpc-error> (if retval = 0)
+ * @retval     1           OK, transaction is active
+ * @retval     0           Transaction is queued or failed, cbret set
+ * @retval    -1           Error
+ * @see controller_transaction_new_queue
+ */
+static int
+rpc_transaction_begin(clixon_handle                    h,
+                      char                            *description,
+                      cxobj                           *xe,
+                      uint32_t                         client_id,
+                      controller_transaction_start_fn *fn,
+                      controller_transaction          *ctq,
+                      controller_transaction         **ctp,
+                      cbuf                            *cbret)
+{
+    int                     retval = -1;
+    controller_transaction *ct = NULL;
+    cbuf                   *cberr = NULL;
+    int                     ret;
+
+    if (ctq != NULL){
+        ct = ctq;
+        if ((ret = controller_transaction_activate(h, ct, &cberr)) < 0)
+            goto done;
+    }
+    else if ((ret = controller_transaction_new_queue(h, description, xe, client_id, fn,
+                                                     &ct, &cberr)) < 0)
+        goto done;
+    if (ret == 0){
+        if (netconf_operation_failed(cbret, "application", cbuf_get(cberr))< 0)
+            goto done;
+        goto failed;
+    }
+    if (ret == 2){ /* Queued: reply with tid, started later by fn */
+        cprintf(cbret, "<rpc-reply xmlns=\"%s\">", NETCONF_BASE_NAMESPACE);
+        cprintf(cbret, "<tid xmlns=\"%s\">%" PRIu64"</tid>", CONTROLLER_NAMESPACE, ct->ct_id);
+        cprintf(cbret, "</rpc-reply>");
+        goto failed;
+    }
+    ct->ct_client_id = client_id;
+    *ctp = ct;
+    retval = 1;
+ done:
+    if (cberr)
+        cbuf_free(cberr);
+    return retval;
+ failed:
+    retval = 0;
+    goto done;
+}
+
 /*! Read the config of one or several remote devices
  *
- * @param[in]  h       Clixon handle
- * @param[in]  xe      Request: <rpc><xn></rpc>
- * @param[out] cbret   Return xml tree, eg <rpc-reply>..., <rpc-error..
- * @param[in]  arg     Domain specific arg, ec client-entry or FCGX_Request
- * @param[in]  regarg  User argument given at rpc_callback_register()
- * @retval     0       OK
- * @retval    -1       Error
+ * @param[in]  h         Clixon handle
+ * @param[in]  xe        Request: <rpc><xn></rpc>
+ * @param[out] cbret     Return xml tree, eg <rpc-reply>..., <rpc-error..
+ * @param[in]  client_id Client id of originator
+ * @param[in]  ctq       Dequeued transaction, or NULL if direct rpc
+ * @retval     0         OK
+ * @retval    -1         Error
  */
 static int
-rpc_config_pull(clixon_handle h,
-                cxobj        *xe,
-                cbuf         *cbret,
-                void         *arg,
-                void         *regarg)
+rpc_config_pull1(clixon_handle           h,
+                 cxobj                  *xe,
+                 cbuf                   *cbret,
+                 uint32_t                client_id,
+                 controller_transaction *ctq)
 {
-    client_entry           *ce = (client_entry *)arg;
     int                     retval = -1;
     char                   *pattern = NULL;
     cxobj                  *xret = NULL;
@@ -425,19 +502,15 @@ rpc_config_pull(clixon_handle h,
     int                     ret;
     controller_transaction *ct = NULL;
     char                   *str;
-    cbuf                   *cberr = NULL;
     int                     transient = 0;
 
     clixon_debug(CLIXON_DBG_DEFAULT, "%s", __FUNCTION__);
     /* Initiate new transaction */
-    if ((ret = controller_transaction_new(h, "pull", &ct, &cberr)) < 0)
+    if ((ret = rpc_transaction_begin(h, "pull", xe, client_id, rpc_config_pull1, ctq,
+                                     &ct, cbret)) < 0)
         goto done;
-    if (ret == 0){
-        if (netconf_operation_failed(cbret, "application", cbuf_get(cberr))< 0)
-            goto done;
+    if (ret == 0)
         goto ok;
-    }
-    ct->ct_client_id = ce->ce_id;
     pattern = xml_find_body(xe, "devname");
     if ((str = xml_find_body(xe, "transient")) != NULL)
         transient = strcmp(str, "true") == 0;
@@ -474,8 +547,6 @@ rpc_config_pull(clixon_handle h,
  ok:
     retval = 0;
  done:
-    if (cberr)
-        cbuf_free(cberr);
     if (vec)
         free(vec);
     if (xret)
@@ -483,6 +554,28 @@ rpc_config_pull(clixon_handle h,
     return retval;
 }
 
+/*! Read the config of one or several remote devices
+ *
+ * @param[in]  h       Clixon handle
+ * @param[in]  xe      Request: <rpc><xn></rpc>
+ * @param[out] cbret   Return xml tree, eg <rpc-reply>..., <rpc-error..
+ * @param[in]  arg     Domain specific arg, ec client-entry or FCGX_Request
+ * @param[in]  regarg  User argument given at rpc_callback_register()
+ * @retval     0       OK
+ * @retval    -1       Error
+ */
+static int
+rpc_config_pull(clixon_handle h,
+                cxobj        *xe,
+                cbuf         *cbret,
+                void         *arg,
+                void         *regarg)
+{
+    client_entry *ce = (client_entry *)arg;
+
+    return rpc_config_pull1(h, xe, cbret, ce->ce_id, NULL);
+}
+
 /*! Timeout callback of service actions
  *
  * @param[in] s     Socket
@@ -549,9 +642,10 @@ actions_timeout_register(controller_transaction *ct)
 
 /*! Cancel timeout
  *
- * @param[in] h   Clixon handle
+ * Also called when the transaction terminates, since it may be freed thereafter
+ * @param[in] ct  Transaction
  */
-static int
+int
 actions_timeout_unregister(controller_transaction *ct)
 {
     (void)clixon_event_unreg_timeout(actions_timeout, ct);
@@ -643,171 +737,745 @@ controller_actions_diff(clixon_handle           h,
     return retval;
 }
 
-/*! Strip all service data in device config
+/*! Get index from service instance to created paths
  *
- * Read a datastore, for each device in the datastore, strip data created by services
- * as defined by the services vector cvv. Write back the changed datastore
- * @param[in]  h    Clixon handle
- * @param[in]  db   Database
- * @param[in]  cvv  Vector of services
- * @retval     0    OK
- * @retval    -1    Error
- * @note Differentiate between reading created from running while deleting from action-db
+ * The index maps a service instance tag, eg testA[name='foo'], to a vector of the created
+ * paths of the instance in running, ie services/testA[name='foo']/created/path
+ * @param[in]  h      Clixon handle
+ * @retval     index  Created paths index
+ * @retval     NULL   Not created yet
+ * @see controller_created_index_commit  where the index is maintained
+ */
+static clicon_hash_t *
+created_index_get(clixon_handle h)
+{
+    clicon_hash_t *index = NULL;
+
+    if (clicon_ptr_get(h, "controller-created-index", (void**)&index) < 0)
+        return NULL;
+    return index;
+}
+
+/*! Get pending changes of created paths index of an ongoing commit
+ *
+ * Same as the index, but a NULL paths vector marks a removed service instance.
+ * @param[in]  h        Clixon handle
+ * @retval     pending  Pending created paths index changes
+ * @retval     NULL     No pending changes
+ * @see controller_created_index_end  where the changes are applied to the index
+ */
+static clicon_hash_t *
+created_index_pending_get(clixon_handle h)
+{
+    clicon_hash_t *pending = NULL;
+
+    if (clicon_ptr_get(h, "controller-created-index-pending", (void**)&pending) < 0)
+        return NULL;
+    return pending;
+}
+
+/*! Remove service instance from created paths index
+ *
+ * @param[in]  index  Created paths index
+ * @param[in]  tag    Service instance tag
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+static int
+created_index_del(clicon_hash_t *index,
+                  char          *tag)
+{
+    void  *p;
+    size_t vlen;
+
+    if ((p = clicon_hash_value(index, tag, &vlen)) == NULL)
+        return 0;
+    if (*(cvec**)p)
+        cvec_free(*(cvec**)p);
+    return clicon_hash_del(index, tag);
+}
+
+/*! Free created paths index hash and all its paths vectors
+ *
+ * @param[in]  index  Created paths index
+ * @retval     0      OK
+ * @retval    -1      Error
  */
 static int
-strip_service_data_from_device_config(clixon_handle h,
-                                      char         *db,
-                                      cvec         *cvv)
+created_index_hash_free(clicon_hash_t *index)
 {
     int     retval = -1;
-    cxobj  *xt0 = NULL;
-    cxobj  *xt1 = NULL;
-    cxobj  *xc0;
-    cxobj  *xc1;
-    cxobj  *xp;
-    cxobj  *xd;
-    cbuf   *cbret = NULL;
-    int     ret;
+    char  **keys = NULL;
+    size_t  nkeys;
     int     i;
-    cxobj **vec = NULL;
-    size_t  veclen;
-    cg_var *cv;
-    char   *xpath;
-    int     touch = 0;
+    void   *p;
+    size_t  vlen;
 
-    /* Get services/created read-only from running_db for reading */
-    if (xmldb_get0(h, "running", YB_NONE, NULL, NULL, 1, WITHDEFAULTS_EXPLICIT, &xt0, NULL, NULL) < 0)
+    if (clicon_hash_keys(index, &keys, &nkeys) < 0)
         goto done;
-    /* Get services/created and devices from action_db for deleting */
-    if (xmldb_get0(h, db, YB_NONE, NULL, NULL, 1, WITHDEFAULTS_EXPLICIT, &xt1, NULL, NULL) < 0)
+    for (i=0; i<nkeys; i++){
+        if ((p = clicon_hash_value(index, keys[i], &vlen)) != NULL &&
+            *(cvec**)p != NULL)
+            cvec_free(*(cvec**)p);
+    }
+    clicon_hash_free(index);
+    retval = 0;
+ done:
+    if (keys)
+        free(keys);
+    return retval;
+}
+
+/*! Create service instance tag of created paths index, eg testA[name='foo']
+ *
+ * Assume first entry is key, see controller_actions_diff
+ * @param[in]  xn   Service instance
+ * @param[out] cb   Service instance tag
+ * @retval     1    OK, tag in cb
+ * @retval     0    No key
+ */
+static int
+created_index_tag(cxobj *xn,
+                  cbuf  *cb)
+{
+    cxobj *xi;
+    char  *instance;
+
+    if ((xi = xml_find_type(xn, NULL, NULL, CX_ELMNT)) == NULL ||
+        (instance = xml_body(xi)) == NULL)
+        return 0;
+    cbuf_reset(cb);
+    cprintf(cb, "%s[%s='%s']", xml_name(xn), xml_name(xi), instance);
+    return 1;
+}
+
+/*! Add service instance and its created paths to created paths index
+ *
+ * @param[in]  index  Created paths index
+ * @param[in]  tag    Service instance tag
+ * @param[in]  xc     Created container of service instance
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+static int
+created_index_add(clicon_hash_t *index,
+                  char          *tag,
+                  cxobj         *xc)
+{
+    int    retval = -1;
+    cvec  *cvv = NULL;
+    cxobj *xp;
+    char  *xpath;
+
+    if ((cvv = cvec_new(0)) == NULL){
+        clixon_err(OE_UNIX, errno, "cvec_new");
         goto done;
-    /* Go through /services/././created that match cvv service name (NULL means all)
-     * then for each xpath find object and purge
-     * Also remove created/name itself
-     */
-    if (cvec_len(cvv) != 0){ /* specific services */
-        cv = NULL;
-        while ((cv = cvec_each(cvv, cv)) != NULL){
-            if ((xc0 = xpath_first(xt0, NULL, "services/%s/created", cv_name_get(cv))) == NULL)
-                continue;
-            xc1 = xpath_first(xt1, NULL, "services/%s/created", cv_name_get(cv));
-            /* Read created from read-only running */
-            xp = NULL;
-            while ((xp = xml_child_each(xc0, xp, CX_ELMNT)) != NULL) {
-                if (strcmp(xml_name(xp), "path") != 0)
-                    continue;
-                if ((xpath = xml_body(xp)) == NULL)
-                    continue;
-                if ((xd = xpath_first(xt1, NULL, "%s", xpath)) == NULL)
-                    continue;
-                /* Purge from action-db */
-                if (xml_purge(xd) < 0) // XXX Check multiple??
-                    goto done;
-            }
-            /* Purge from action-db */
-            if (xc1 && xml_purge(xc1) < 0)
-                goto done;
-            touch++;
-        }
     }
-    else{ /* All services */
-        if (xpath_vec(xt0, NULL, "services//created", &vec, &veclen) < 0)
+    xp = NULL;
+    while ((xp = xml_child_each(xc, xp, CX_ELMNT)) != NULL) {
+        if (strcmp(xml_name(xp), "path") != 0)
+            continue;
+        if ((xpath = xml_body(xp)) == NULL)
+            continue;
+        if (cvec_add_string(cvv, xpath, NULL) < 0){
+            clixon_err(OE_UNIX, errno, "cvec_add_string");
             goto done;
-        for (i=0; i<veclen; i++){
-            xc0 = vec[i];
-            xp = NULL;
-            while ((xp = xml_child_each(xc0, xp, CX_ELMNT)) != NULL) {
-                if (strcmp(xml_name(xp), "path") != 0)
-                    continue;
-                if ((xpath = xml_body(xp)) == NULL)
-                    continue;
-                if ((xd = xpath_first(xt1, NULL, "%s", xpath)) == NULL)
-                    continue;
-                if (xml_purge(xd) < 0) // XXX Check muliple??
-                    goto done;
-                touch++;
-            }
         }
-        if (vec)
-            free(vec);
-        if (xpath_vec(xt1, NULL, "services//created", &vec, &veclen) < 0)
-            goto done;
-        for (i=0; i<veclen; i++){
-            xc1 = vec[i];
-            if (xc1 && xml_purge(xc1) < 0)
+    }
+    if (clicon_hash_add(index, tag, &cvv, sizeof(cvv)) == NULL)
+        goto done;
+    cvv = NULL;
+    retval = 0;
+ done:
+    if (cvv)
+        cvec_free(cvv);
+    return retval;
+}
+
+/*! Update created paths index from changed service instances in a running commit
+ *
+ * The changes are kept pending until the commit succeeds, and are then applied to the
+ * index in controller_created_index_end, or discarded in controller_created_index_abort.
+ * @param[in]  h       Clixon handle
+ * @param[in]  nsc     Namespace context
+ * @param[in]  src     Pre-existing xml tree
+ * @param[in]  target  Post target xml tree
+ * @retval     0       OK
+ * @retval    -1       Error
+ * @see strip_service_data_from_device_config  where the index is used
+ */
+int
+controller_created_index_commit(clixon_handle h,
+                                cvec         *nsc,
+                                cxobj        *src,
+                                cxobj        *target)
+{
+    int            retval = -1;
+    clicon_hash_t *pending;
+    cxobj         *xs;
+    cxobj         *xn;
+    cxobj         *xc;
+    cvec          *cvv = NULL;
+    cbuf          *cb = NULL;
+
+    if (controller_created_index_abort(h) < 0)
+        goto done;
+    if ((pending = clicon_hash_init()) == NULL)
+        goto done;
+    clicon_ptr_set(h, "controller-created-index-pending", pending);
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    /* Remove deleted and changed service instances */
+    if (src && (xs = xpath_first(src, nsc, "services")) != NULL){
+        xn = NULL;
+        while ((xn = xml_child_each(xs, xn,  CX_ELMNT)) != NULL){
+            if (xml_flag(xn, XML_FLAG_CHANGE|XML_FLAG_DEL) == 0)
+                continue;
+            if (created_index_tag(xn, cb) == 0)
+                continue;
+            if (created_index_del(pending, cbuf_get(cb)) < 0)
+                goto done;
+            if (clicon_hash_add(pending, cbuf_get(cb), &cvv, sizeof(cvv)) == NULL)
                 goto done;
-            touch++;
         }
     }
-    if (touch){
-        /* XXX Somewhat raw to replace the top-level tree, could do with op=REMOVE
-         * of the sub-parts instead of marking and remove
-         */
-        if ((cbret = cbuf_new()) == NULL){ // dummy
-            clixon_err(OE_UNIX, errno, "cbuf_new");
-            goto done;
-        }
-        if ((ret = xmldb_put(h, db, OP_REPLACE, xt1, NULL, cbret)) < 0)
-            goto done;
-        if (ret == 0){
-            clixon_err(OE_XML, 0, "xmldb_put failed");
-            goto done;
+    /* Add added and changed service instances with created paths */
+    if (target && (xs = xpath_first(target, nsc, "services")) != NULL){
+        xn = NULL;
+        while ((xn = xml_child_each(xs, xn,  CX_ELMNT)) != NULL){
+            if (xml_flag(xn, XML_FLAG_CHANGE|XML_FLAG_ADD) == 0)
+                continue;
+            if ((xc = xml_find_type(xn, NULL, "created", CX_ELMNT)) == NULL)
+                continue;
+            if (created_index_tag(xn, cb) == 0)
+                continue;
+            if (created_index_del(pending, cbuf_get(cb)) < 0)
+                goto done;
+            if (created_index_add(pending, cbuf_get(cb), xc) < 0)
+                goto done;
         }
     }
     retval = 0;
  done:
-    if (vec)
-        free(vec);
-    if (cbret)
-        cbuf_free(cbret);
-    if (xt0)
-        xml_free(xt0);
-    if (xt1)
-        xml_free(xt1);
+    if (cb)
+        cbuf_free(cb);
     return retval;
 }
 
-/*! Compute diff of candidate + commit and trigger service-commit notify
+/*! Apply pending created paths index changes after a successful commit
  *
  * @param[in]  h       Clixon handle
- * @param[in]  ct      Transaction
- * @param[in]  db      From where to compute diffs and push
- * @param[out] cberr   Error message (if retval = 0)
- * @retval     1       OK
- * @retval     0       Failed
+ * @retval     0       OK
  * @retval    -1       Error
+ * @see controller_created_index_commit  where the changes are made
  */
-static int
-controller_commit_push(clixon_handle           h,
-                       controller_transaction *ct,
-                       char                   *db,
-                       cbuf                  **cberr)
+int
+controller_created_index_end(clixon_handle h)
 {
-    int           retval = -1;
-    device_handle dh = NULL;
-    int           ret;
+    int            retval = -1;
+    clicon_hash_t *pending;
+    clicon_hash_t *index;
+    char         **keys = NULL;
+    size_t         nkeys;
+    int            i;
+    void          *p;
+    size_t         vlen;
+    cvec          *cvv;
 
-    while ((dh = device_handle_each(h, dh)) != NULL){
-        if (device_handle_tid_get(dh) != ct->ct_id)
+    if ((pending = created_index_pending_get(h)) == NULL)
+        goto ok;
+    if ((index = created_index_get(h)) == NULL){
+        if ((index = clicon_hash_init()) == NULL)
+            goto done;
+        clicon_ptr_set(h, "controller-created-index", index);
+    }
+    if (clicon_hash_keys(pending, &keys, &nkeys) < 0)
+        goto done;
+    for (i=0; i<nkeys; i++){
+        if ((p = clicon_hash_value(pending, keys[i], &vlen)) == NULL)
             continue;
-        if ((ret = push_device_one(h, dh, ct, db, cberr)) < 0)
+        cvv = *(cvec**)p;
+        if (created_index_del(index, keys[i]) < 0)
             goto done;
-        if (ret == 0)  /* Failed but cbret set */
-            goto failed;
+        if (cvv != NULL){
+            if (clicon_hash_add(index, keys[i], &cvv, sizeof(cvv)) == NULL)
+                goto done;
+            /* Moved to index */
+            if (clicon_hash_del(pending, keys[i]) < 0)
+                goto done;
+        }
     }
-    retval = 1;
+    if (controller_created_index_abort(h) < 0)
+        goto done;
+ ok:
+    retval = 0;
  done:
+    if (keys)
+        free(keys);
     return retval;
- failed:
-    retval = 0;
-    goto done;
 }
 
-/*! Push commit after actions completed, potentially start device push process
+/*! Discard pending created paths index changes, eg after a failed commit
  *
- * Devices are removed of no device diff
- * @param[in]  h    Clixon handle
- * @param[in]  ct   Transaction
+ * @param[in]  h       Clixon handle
+ * @retval     0       OK
+ * @retval    -1       Error
+ */
+int
+controller_created_index_abort(clixon_handle h)
+{
+    clicon_hash_t *pending;
+
+    if ((pending = created_index_pending_get(h)) == NULL)
+        return 0;
+    clicon_ptr_del(h, "controller-created-index-pending");
+    return created_index_hash_free(pending);
+}
+
+/*! Build created paths index from running
+ *
+ * Called at startup, since there may be no startup commit, eg if the backend starts
+ * in running mode.
+ * @param[in]  h       Clixon handle
+ * @retval     0       OK
+ * @retval    -1       Error
+ */
+int
+controller_created_index_init(clixon_handle h)
+{
+    int            retval = -1;
+    clicon_hash_t *index;
+    cvec          *nsc = NULL;
+    cxobj         *xt = NULL;
+    cxobj         *xs;
+    cxobj         *xn;
+    cxobj         *xc;
+    cbuf          *cb = NULL;
+
+    if (controller_created_index_free(h) < 0)
+        goto done;
+    if ((index = clicon_hash_init()) == NULL)
+        goto done;
+    clicon_ptr_set(h, "controller-created-index", index);
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    if ((nsc = xml_nsctx_init(NULL, CONTROLLER_NAMESPACE)) == NULL)
+        goto done;
+    if (xmldb_get0(h, "running", YB_MODULE, nsc, "services", 1, WITHDEFAULTS_EXPLICIT, &xt, NULL, NULL) < 0)
+        goto done;
+    if ((xs = xpath_first(xt, nsc, "services")) != NULL){
+        xn = NULL;
+        while ((xn = xml_child_each(xs, xn,  CX_ELMNT)) != NULL){
+            if ((xc = xml_find_type(xn, NULL, "created", CX_ELMNT)) == NULL)
+                continue;
+            if (created_index_tag(xn, cb) == 0)
+                continue;
+            if (created_index_add(index, cbuf_get(cb), xc) < 0)
+                goto done;
+        }
+    }
+    retval = 0;
+ done:
+    if (nsc)
+        cvec_free(nsc);
+    if (xt)
+        xml_free(xt);
+    if (cb)
+        cbuf_free(cb);
+    return retval;
+}
+
+/*! Free created paths index
+ *
+ * @param[in]  h       Clixon handle
+ * @retval     0       OK
+ * @retval    -1       Error
+ */
+int
+controller_created_index_free(clixon_handle h)
+{
+    int            retval = -1;
+    clicon_hash_t *index;
+
+    if (controller_created_index_abort(h) < 0)
+        goto done;
+    if ((index = created_index_get(h)) == NULL)
+        goto ok;
+    clicon_ptr_del(h, "controller-created-index");
+    if (created_index_hash_free(index) < 0)
+        goto done;
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Add one created path to a remove edit tree
+ *
+ * The path is read from the datastore on its own. Its node and ancestors are moved into
+ * the edit tree, joining ancestors already there, and the node is marked for removal.
+ * @param[in]  h      Clixon handle
+ * @param[in]  db     Database
+ * @param[in]  xedit  Remove edit tree
+ * @param[in]  map    Edit tree nodes indexed by path prefix
+ * @param[in]  path   Canonical path, eg /devices/device[name="d"]/config/x
+ * @param[in]  cb     Scratch buffer
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+static int
+strip_edit_path(clixon_handle  h,
+                char          *db,
+                cxobj         *xedit,
+                clicon_hash_t *map,
+                char          *path,
+                cbuf          *cb)
+{
+    int    retval = -1;
+    cxobj *xt = NULL;
+    cxobj *x0;          /* Parent in edit tree */
+    cxobj *x1;          /* Parent in lookup tree */
+    cxobj *xl;
+    cxobj *xe;
+    char  *s;
+    char  *e;
+    char  *n;
+    char  *name;
+    char   q = 0;
+    int    depth;
+    int    moved = 0;
+    void  *p;
+    size_t vlen;
+
+    if (xmldb_get0(h, db, YB_MODULE, NULL, path, 1, WITHDEFAULTS_EXPLICIT, &xt, NULL, NULL) < 0)
+        goto done;
+    cbuf_reset(cb);
+    x0 = xedit;
+    x1 = xt;
+    s = path;
+    while (*s == '/')
+        s++;
+    while (*s != '\0'){
+        /* End of segment, skipping predicates */
+        depth = 0;
+        for (e = s; *e != '\0'; e++){
+            if (q){
+                if (*e == q)
+                    q = 0;
+            }
+            else if (*e == '\'' || *e == '"')
+                q = *e;
+            else if (*e == '[')
+                depth++;
+            else if (*e == ']')
+                depth--;
+            else if (*e == '/' && depth == 0)
+                break;
+        }
+        cprintf(cb, "/%.*s", (int)(e-s), s);
+        /* Segment name without prefix and predicates */
+        name = s;
+        for (n = s; n < e && *n != '['; n++)
+            if (*n == ':')
+                name = n+1;
+        xl = NULL;
+        while ((xl = xml_child_each(x1, xl, CX_ELMNT)) != NULL)
+            if (strlen(xml_name(xl)) == n-name && strncmp(xml_name(xl), name, n-name) == 0)
+                break;
+        if (xl == NULL) /* Not in datastore */
+            goto ok;
+        if (!moved &&
+            (p = clicon_hash_value(map, cbuf_get(cb), &vlen)) != NULL){
+            xe = *(cxobj**)p;
+            if (xml_find_type(xe, NETCONF_BASE_PREFIX, "operation", CX_ATTR) != NULL)
+                goto ok; /* Already removed */
+            x0 = xe;
+            x1 = xl;
+        }
+        else {
+            if (!moved){
+                if (xml_rm(xl) < 0)
+                    goto done;
+                if (xml_addsub(x0, xl) < 0)
+                    goto done;
+                moved = 1;
+            }
+            if (clicon_hash_add(map, cbuf_get(cb), &xl, sizeof(xl)) == NULL)
+                goto done;
+            x0 = x1 = xl;
+        }
+        s = *e ? e+1 : e;
+    }
+    if (x0 != xedit &&
+        xml_find_type(x0, NETCONF_BASE_PREFIX, "operation", CX_ATTR) == NULL &&
+        xml_add_attr(x0, "operation", "remove", NETCONF_BASE_PREFIX, NULL) == NULL)
+        goto done;
+ ok:
+    retval = 0;
+ done:
+    if (xt)
+        xml_free(xt);
+    return retval;
+}
+
+/*! Check if created path is in the config of one of a set of devices
+ *
+ * Only paths on the form /devices/device[name='<name>']/.. are recognized
+ * @param[in]  path     Created path
+ * @param[in]  devices  Device handles indexed by device name
+ * @param[in]  cb       Scratch buffer
+ * @retval     1        Yes
+ * @retval     0        No
+ */
+static int
+created_path_device(char          *path,
+                    clicon_hash_t *devices,
+                    cbuf          *cb)
+{
+    char  *prefix = "/devices/device[name=";
+    char  *p;
+    char  *e;
+    char   q;
+    size_t vlen;
+
+    if (strncmp(path, prefix, strlen(prefix)) != 0)
+        return 0;
+    p = path + strlen(prefix);
+    q = *p++;
+    if ((q != '\'' && q != '"') ||
+        (e = index(p, q)) == NULL || e[1] != ']')
+        return 0;
+    cbuf_reset(cb);
+    cprintf(cb, "%.*s", (int)(e-p), p);
+    return clicon_hash_value(devices, cbuf_get(cb), &vlen) != NULL;
+}
+
+/*! Add created paths of one service instance to a remove edit tree
+ *
+ * Also add the created container itself, or if devices is set, only the created
+ * paths of those devices and their entries in the created container.
+ * @param[in]  h      Clixon handle
+ * @param[in]  db     Database
+ * @param[in]  index  Created paths index
+ * @param[in]  tag    Service instance tag, or service name for all its instances
+ * @param[in]  devices Device handles indexed by name, or NULL for all devices
+ * @param[in]  xedit  Remove edit tree
+ * @param[in]  map    Edit tree nodes indexed by path prefix
+ * @param[in]  cb     Scratch buffer
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+static int
+created_index_strip(clixon_handle  h,
+                    char          *db,
+                    clicon_hash_t *index,
+                    char          *tag,
+                    clicon_hash_t *devices,
+                    cxobj         *xedit,
+                    clicon_hash_t *map,
+                    cbuf          *cb)
+{
+    int     retval = -1;
+    void   *p;
+    size_t  vlen;
+    cg_var *cv;
+    char  **keys = NULL;
+    size_t  nkeys;
+    size_t  len;
+    int     i;
+    cbuf   *cbp = NULL;
+    char   *path;
+    char    q;
+
+    if ((p = clicon_hash_value(index, tag, &vlen)) != NULL){
+        if ((cbp = cbuf_new()) == NULL){
+            clixon_err(OE_UNIX, errno, "cbuf_new");
+            goto done;
+        }
+        cv = NULL;
+        while ((cv = cvec_each(*(cvec**)p, cv)) != NULL){
+            path = cv_name_get(cv);
+            if (devices != NULL){
+                if (created_path_device(path, devices, cb) == 0)
+                    continue;
+                q = strchr(path, '\'') == NULL ? '\'' : '"';
+                if (strchr(path, q) != NULL) /* Cannot quote, keep */
+                    continue;
+                /* Created container entry of path */
+                cbuf_reset(cbp);
+                cprintf(cbp, "/services/%s/created/path[.=%c%s%c]", tag, q, path, q);
+                if (strip_edit_path(h, db, xedit, map, cbuf_get(cbp), cb) < 0)
+                    goto done;
+            }
+            if (strip_edit_path(h, db, xedit, map, path, cb) < 0)
+                goto done;
+        }
+        if (devices == NULL){
+            cbuf_reset(cbp);
+            cprintf(cbp, "/services/%s/created", tag);
+            if (strip_edit_path(h, db, xedit, map, cbuf_get(cbp), cb) < 0)
+                goto done;
+        }
+    }
+    else if (strchr(tag, '[') == NULL){ /* Service name: all instances */
+        if (clicon_hash_keys(index, &keys, &nkeys) < 0)
+            goto done;
+        len = strlen(tag);
+        for (i=0; i<nkeys; i++){
+            if (strncmp(keys[i], tag, len) == 0 && keys[i][len] == '[' &&
+                created_index_strip(h, db, index, keys[i], devices, xedit, map, cb) < 0)
+                goto done;
+        }
+    }
+    retval = 0;
+ done:
+    if (cbp)
+        cbuf_free(cbp);
+    if (keys)
+        free(keys);
+    return retval;
+}
+
+/*! Strip all service data in device config
+ *
+ * For each service instance in cvv, find its created paths in the created paths index
+ * (mirroring services/../created in running) and remove those paths, and the created
+ * container of the service instance, from the datastore.
+ * Each path is read from the datastore on its own and added to one remove edit.
+ * If devices is set, eg in delta mode where services only regenerate config of the
+ * transaction devices, only created paths of those devices are removed, and the created
+ * container keeps the paths of other devices.
+ * @param[in]  h        Clixon handle
+ * @param[in]  db       Database
+ * @param[in]  cvv      Vector of services, empty means all
+ * @param[in]  devices  Device handles indexed by name, or NULL for all devices
+ * @retval     0        OK
+ * @retval    -1        Error
+ * @see controller_created_index_commit
+ */
+static int
+strip_service_data_from_device_config(clixon_handle  h,
+                                      char          *db,
+                                      cvec          *cvv,
+                                      clicon_hash_t *devices)
+{
+    int            retval = -1;
+    clicon_hash_t *index;
+    clicon_hash_t *map = NULL;
+    cxobj         *xedit = NULL;
+    cbuf          *cb = NULL;
+    cbuf          *cbret = NULL;
+    int            ret;
+    int            i;
+    char         **keys = NULL;
+    size_t         nkeys;
+    cg_var        *cv;
+
+    if ((index = created_index_get(h)) == NULL)
+        goto ok;
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    if ((map = clicon_hash_init()) == NULL)
+        goto done;
+    if ((xedit = xml_new(NETCONF_INPUT_CONFIG, NULL, CX_ELMNT)) == NULL)
+        goto done;
+    if (cvec_len(cvv) != 0){ /* specific services */
+        cv = NULL;
+        while ((cv = cvec_each(cvv, cv)) != NULL){
+            if (created_index_strip(h, db, index, cv_name_get(cv), devices, xedit, map, cb) < 0)
+                goto done;
+        }
+    }
+    else{ /* All services */
+        if (clicon_hash_keys(index, &keys, &nkeys) < 0)
+            goto done;
+        for (i=0; i<nkeys; i++){
+            if (created_index_strip(h, db, index, keys[i], devices, xedit, map, cb) < 0)
+                goto done;
+        }
+    }
+    if (xml_child_nr_type(xedit, CX_ELMNT) == 0)
+        goto ok;
+    if (xmlns_set(xedit, NETCONF_BASE_PREFIX, NETCONF_BASE_NAMESPACE) < 0)
+        goto done;
+    if ((cbret = cbuf_new()) == NULL){ // dummy
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    if ((ret = xmldb_put(h, db, OP_NONE, xedit, NULL, cbret)) < 0)
+        goto done;
+    if (ret == 0){
+        clixon_err(OE_XML, 0, "xmldb_put failed");
+        goto done;
+    }
+ ok:
+    retval = 0;
+ done:
+    if (keys)
+        free(keys);
+    if (map)
+        clicon_hash_free(map);
+    if (cb)
+        cbuf_free(cb);
+    if (cbret)
+        cbuf_free(cbret);
+    if (xedit)
+        xml_free(xedit);
+    return retval;
+}
+
+/*! Compute diff of candidate + commit and trigger service-commit notify
+ *
+ * All device edit-msgs are prepared, then devices are locked and pushed in waves
+ * @param[in]  h       Clixon handle
+ * @param[in]  ct      Transaction
+ * @param[in]  db      From where to compute diffs and push
+ * @param[out] cberr   Error message (if retval = 0)
+ * @retval     1       OK
+ * @retval     0       Failed
+ * @retval    -1       Error
+ * @see controller_transaction_push_wave
+ */
+static int
+controller_commit_push(clixon_handle           h,
+                       controller_transaction *ct,
+                       char                   *db,
+                       cbuf                  **cberr)
+{
+    int           retval = -1;
+    device_handle dh = NULL;
+    int           ret;
+
+    while ((dh = device_handle_each(h, dh)) != NULL){
+        if (device_handle_tid_get(dh) != ct->ct_id)
+            continue;
+        if ((ret = push_device_one(h, dh, ct, db, cberr)) < 0)
+            goto done;
+        if (ret == 0)  /* Failed but cbret set */
+            goto failed;
+    }
+    /* Start first push wave */
+    if (controller_transaction_push_wave(h, ct) < 0)
+        goto done;
+    retval = 1;
+ done:
+    return retval;
+ failed:
+    retval = 0;
+    goto done;
+}
+
+/*! Push commit after actions completed, potentially start device push process
+ *
+ * Devices are removed of no device diff
+ * @param[in]  h    Clixon handle
+ * @param[in]  ct   Transaction
  * @retval     0    OK
  * @retval    -1    Error
  */
@@ -898,6 +1566,77 @@ commit_push_after_actions(clixon_handle           h,
     return retval;
 }
 
+/*! Append changed service instances and transaction devices to services-commit notification
+ *
+ * Only if services-commit-delta is set. Action daemons may then use the inlined service
+ * instances and device names instead of reading services and devices from the source db
+ * @param[in]  h         Clixon handle
+ * @param[in]  ct        Transaction
+ * @param[in]  td        Transaction data, target is candidate
+ * @param[in]  cvv       Changed service instances as <service>[<key>='<instance>'], empty is all
+ * @param[out] cb        Notification buffer
+ * @retval     0         OK
+ * @retval    -1         Error
+ * @see service_action_handler in clixon_controller_service.c
+ */
+static int
+controller_actions_delta(clixon_handle           h,
+                         controller_transaction *ct,
+                         transaction_data_t     *td,
+                         cvec                   *cvv,
+                         cbuf                   *cb)
+{
+    int           retval = -1;
+    cxobj        *x1s;
+    cxobj        *xs;
+    cxobj       **vec = NULL;
+    size_t        veclen;
+    cg_var       *cv;
+    device_handle dh;
+    int           i;
+
+    cprintf(cb, "<services>");
+    if ((x1s = xpath_first(td->td_target, NULL, "services")) != NULL){
+        if (cvec_len(cvv) == 0){ /* All services */
+            xs = NULL;
+            while ((xs = xml_child_each(x1s, xs, CX_ELMNT)) != NULL){
+                if (clixon_xml2cbuf(cb, xs, 0, 0, NULL, -1, 0) < 0)
+                    goto done;
+            }
+        }
+        else {
+            /* Deleted instances are not found and not inlined */
+            cv = NULL;
+            while ((cv = cvec_each(cvv, cv)) != NULL){
+                if (xpath_vec(x1s, NULL, "%s", &vec, &veclen, cv_name_get(cv)) < 0)
+                    goto done;
+                for (i=0; i<veclen; i++){
+                    if (clixon_xml2cbuf(cb, vec[i], 0, 0, NULL, -1, 0) < 0)
+                        goto done;
+                }
+                if (vec){
+                    free(vec);
+                    vec = NULL;
+                }
+            }
+        }
+    }
+    cprintf(cb, "</services>");
+    dh = NULL;
+    while ((dh = device_handle_each(h, dh)) != NULL){
+        if (device_handle_tid_get(dh) != ct->ct_id)
+            continue;
+        cprintf(cb, "<device>");
+        xml_chardata_cbuf_append(cb, device_handle_name_get(dh));
+        cprintf(cb, "</device>");
+    }
+    retval = 0;
+ done:
+    if (vec)
+        free(vec);
+    return retval;
+}
+
 /*! Compute diff of candidate + commit and trigger service-commit notify
  *
  * @param[in]  h         Clixon handle
@@ -916,11 +1655,13 @@ controller_commit_actions(clixon_handle           h,
                           char                   *service_instance
                           )
 {
-    int     retval = -1;
-    cbuf   *notifycb = NULL;
-    cvec   *cvv = NULL;       /* Format: <service> <instance> */
-    int     services = 0;
-    cg_var *cv = NULL;
+    int            retval = -1;
+    cbuf          *notifycb = NULL;
+    cvec          *cvv = NULL;       /* Format: <service> <instance> */
+    int            services = 0;
+    cg_var        *cv = NULL;
+    clicon_hash_t *devices = NULL;   /* Transaction devices in delta mode */
+    device_handle  dh;
 
     if ((cvv = cvec_new(0)) == NULL){
         clixon_err(OE_UNIX, errno, "cvec_new");
@@ -960,9 +1701,22 @@ controller_commit_actions(clixon_handle           h,
             xml_chardata_cbuf_append(notifycb, cv_name_get(cv));
             cprintf(notifycb, "</service>");
         }
+        if (clicon_data_int_get(h, "controller-services-commit-delta") == 1){
+            if (controller_actions_delta(h, ct, td, cvv, notifycb) < 0)
+                goto done;
+            /* Services only regenerate config of the transaction devices */
+            if ((devices = clicon_hash_init()) == NULL)
+                goto done;
+            dh = NULL;
+            while ((dh = device_handle_each(h, dh)) != NULL){
+                if (device_handle_tid_get(dh) == ct->ct_id &&
+                    clicon_hash_add(devices, device_handle_name_get(dh), &dh, sizeof(dh)) == NULL)
+                    goto done;
+            }
+        }
         cprintf(notifycb, "</services-commit>");
         /* Strip service data in device config for services that changed */
-        if (strip_service_data_from_device_config(h, "actions", cvv) < 0)
+        if (strip_service_data_from_device_config(h, "actions", cvv, devices) < 0)
             goto done;
         clixon_debug(CLIXON_DBG_DEFAULT, "%s stream_notify: services-commit: %" PRIu64, __FUNCTION__, ct->ct_id);
         if (stream_notify(h, "services-commit", "%s", cbuf_get(notifycb)) < 0)
@@ -977,6 +1731,8 @@ controller_commit_actions(clixon_handle           h,
     }
     retval = 0;
  done:
+    if (devices)
+        clicon_hash_free(devices);
     if (cvv)
         cvec_free(cvv);
     if (notifycb)
@@ -1250,24 +2006,26 @@ device_error(clixon_handle           h,
 
 /*! Extended commit: trigger actions and device push
  *
- * @param[in]  h       Clixon handle
- * @param[in]  xe      Request: <rpc><xn></rpc>
- * @param[out] cbret   Return xml tree, eg <rpc-reply>..., <rpc-error..
- * @param[in]  arg     Domain specific arg, ec client-entry or FCGX_Request
- * @param[in]  regarg  User argument given at rpc_callback_register()
- * @retval     0       OK
- * @retval    -1       Error
+ * If another transaction is ongoing, the request is queued and this function is called again
+ * with the dequeued transaction when it is started. Local validate is then only made at start,
+ * since candidate may change while queued.
+ * @param[in]  h         Clixon handle
+ * @param[in]  xe        Request: <rpc><xn></rpc>
+ * @param[out] cbret     Return xml tree, eg <rpc-reply>..., <rpc-error..
+ * @param[in]  client_id Client id of originator
+ * @param[in]  ctq       Dequeued transaction, or NULL if direct rpc
+ * @retval     0         OK
+ * @retval    -1         Error
  * TODO: device-groups
  */
 static int
-rpc_controller_commit(clixon_handle h,
-                      cxobj        *xe,
-                      cbuf         *cbret,
-                      void         *arg,
-                      void         *regarg)
+rpc_controller_commit1(clixon_handle           h,
+                       cxobj                  *xe,
+                       cbuf                   *cbret,
+                       uint32_t                client_id,
+                       controller_transaction *ctq)
 {
     int                     retval = -1;
-    client_entry           *ce = (client_entry *)arg;
     controller_transaction *ct = NULL;
     char                   *str;
     char                   *device;
@@ -1282,6 +2040,10 @@ rpc_controller_commit(clixon_handle h,
     device_handle           changed = NULL;
     transaction_data_t     *td = NULL;
     char                   *service_instance = NULL;
+    uint32_t                window = 0;
+    uint32_t                canary = 0;
+    struct timeval          tv0 = {0,};
+    struct timeval          tv1;
 
     clixon_debug(CLIXON_DBG_DEFAULT, "%s", __FUNCTION__);
     device = xml_find_body(xe, "device");
@@ -1304,12 +2066,15 @@ rpc_controller_commit(clixon_handle h,
             goto done;
         goto ok;
     }
-    /* Local validate if candidate */
-    if (strcmp(sourcedb, "candidate") == 0){
+    /* Local validate if candidate, a queued request is validated when started */
+    if (strcmp(sourcedb, "candidate") == 0 &&
+        (ctq != NULL || controller_transaction_queued(h) == 0)){
+        gettimeofday(&tv0, NULL);
         if ((ret = candidate_validate(h, sourcedb, cbret)) < 0)
             goto done;
         if (ret == 0)
             goto ok;
+        gettimeofday(&tv1, NULL);
     }
     if ((cbtr = cbuf_new()) == NULL){
         clixon_err(OE_UNIX, errno, "cbuf_new");
@@ -1325,22 +2090,46 @@ rpc_controller_commit(clixon_handle h,
         cprintf(cbtr, " push:%s", str);
     }
     service_instance = xml_find_body(xe, "service-instance");
+    if ((str = xml_find_body(xe, "max-concurrent")) != NULL){
+        if ((ret = parse_uint32(str, &window, NULL)) < 0)
+            goto done;
+        if (ret == 0){
+            if (netconf_operation_failed(cbret, "application", "Invalid max-concurrent")< 0)
+                goto done;
+            goto ok;
+        }
+        if (window)
+            cprintf(cbtr, " max-concurrent:%u", window);
+    }
+    if ((str = xml_find_body(xe, "canary")) != NULL){
+        if ((ret = parse_uint32(str, &canary, NULL)) < 0)
+            goto done;
+        if (ret == 0){
+            if (netconf_operation_failed(cbret, "application", "Invalid canary")< 0)
+                goto done;
+            goto ok;
+        }
+        if (canary)
+            cprintf(cbtr, " canary:%u", canary);
+    }
 
     /* Initiate new transaction.
      * NB: this locks candidate, which always needs to be unlocked, eg by controller_transaction_done
      */
-    if ((ret = controller_transaction_new(h, cbuf_get(cbtr), &ct, &cberr)) < 0)
+    if ((ret = rpc_transaction_begin(h, cbuf_get(cbtr), xe, client_id, rpc_controller_commit1, ctq,
+                                     &ct, cbret)) < 0)
         goto done;
-    if (ret == 0){
-        if (netconf_operation_failed(cbret, "application", cbuf_get(cberr))< 0)
-            goto done;
+    if (ret == 0)
         goto ok;
-    }
-    ct->ct_client_id = ce->ce_id;
     ct->ct_push_type = pusht;
+    ct->ct_push_window = window;
+    ct->ct_push_canary = canary;
     ct->ct_actions_type = actions;
     ct->ct_sourcedb = sourcedb;
     sourcedb = NULL;
+    if (tv0.tv_sec != 0 &&
+        controller_transaction_trace(ct, NULL, "validate", &tv0, &tv1) < 0)
+        goto done;
     /* Mark devices with transaction-id if name matches device pattern AND state is OPEN */
     if (devices_match(h, device, ct->ct_id, &closed) < 0)
         goto done;
@@ -1360,8 +2149,11 @@ rpc_controller_commit(clixon_handle h,
     if ((td = transaction_new()) == NULL)
         goto done;
     /* Diff candidate/running and fill in a diff transaction structure td for future use */
+    gettimeofday(&tv0, NULL);
     if (devices_diff(h, ct, td) < 0)
         goto done;
+    if (controller_transaction_trace(ct, NULL, "devices-diff", &tv0, NULL) < 0)
+        goto done;
     /* Check if any local/meta device fields have changed of selected devices */
     if (devices_local_change(h, td, &changed) < 0)
         goto done;
@@ -1422,6 +2214,28 @@ rpc_controller_commit(clixon_handle h,
     return retval;
 }
 
+/*! Extended commit: trigger actions and device push
+ *
+ * @param[in]  h       Clixon handle
+ * @param[in]  xe      Request: <rpc><xn></rpc>
+ * @param[out] cbret   Return xml tree, eg <rpc-reply>..., <rpc-error..
+ * @param[in]  arg     Domain specific arg, ec client-entry or FCGX_Request
+ * @param[in]  regarg  User argument given at rpc_callback_register()
+ * @retval     0       OK
+ * @retval    -1       Error
+ */
+static int
+rpc_controller_commit(clixon_handle h,
+                      cxobj        *xe,
+                      cbuf         *cbret,
+                      void         *arg,
+                      void         *regarg)
+{
+    client_entry *ce = (client_entry *)arg;
+
+    return rpc_controller_commit1(h, xe, cbret, ce->ce_id, NULL);
+}
+
 /*! Get configuration db of a single device of name 'device-<devname>-<postfix>.xml'
  *
  * Typically this db is retrieved by the pull rpc
@@ -1532,9 +2346,11 @@ rpc_get_device_config(clixon_handle h,
     return retval;
 }
 
-/*! (Re)connect try an enabled device in CLOSED state.
+/*! Get yang-library and its fingerprint of devices
  *
- * If closed due to error it may need to be cleared and reconnected
+ * Use this instead of reading device config to get the yang-library of devices.
+ * If dedup is set, the yang-library is only returned for the first device of each
+ * fingerprint, other devices only return the fingerprint.
  * @param[in]  h       Clixon handle
  * @param[in]  xe      Request: <rpc><xn></rpc>
  * @param[out] cbret   Return xml tree, eg <rpc-reply>..., <rpc-error..
@@ -1544,14 +2360,113 @@ rpc_get_device_config(clixon_handle h,
  * @retval    -1       Error
  */
 static int
-rpc_connection_change(clixon_handle h,
-                      cxobj        *xe,
-                      cbuf         *cbret,
-                      void         *arg,
-                      void         *regarg)
+rpc_get_device_yang_library(clixon_handle h,
+                            cxobj        *xe,
+                            cbuf         *cbret,
+                            void         *arg,
+                            void         *regarg)
+{
+    int            retval = -1;
+    char          *pattern;
+    char          *str;
+    int            dedup = 0;
+    device_handle  dh;
+    char          *devname;
+    cxobj         *xylib;
+    char          *fp;
+    clicon_hash_t *fps = NULL;
+    cbuf          *cb = NULL;
+    int            one = 1;
+
+    pattern = xml_find_body(xe, "devname");
+    if ((str = xml_find_body(xe, "dedup")) != NULL && strcmp(str, "true") == 0)
+        dedup = 1;
+    if ((fps = clicon_hash_init()) == NULL)
+        goto done;
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    cprintf(cb, "<rpc-reply xmlns=\"%s\">", NETCONF_BASE_NAMESPACE);
+    dh = NULL;
+    while ((dh = device_handle_each(h, dh)) != NULL){
+        devname = device_handle_name_get(dh);
+        if (pattern != NULL && fnmatch(pattern, devname, 0) != 0)
+            continue;
+        cprintf(cb, "<device xmlns=\"%s\">", CONTROLLER_NAMESPACE);
+        cprintf(cb, "<name>%s</name>", devname);
+        if ((xylib = device_handle_yang_lib_get(dh)) != NULL){
+            if ((fp = device_handle_yang_lib_fingerprint(dh)) == NULL)
+                goto done;
+            cprintf(cb, "<fingerprint>%s</fingerprint>", fp);
+            if (dedup == 0 || clicon_hash_value(fps, fp, NULL) == NULL){
+                if (dedup && clicon_hash_add(fps, fp, &one, sizeof(one)) == NULL)
+                    goto done;
+                cprintf(cb, "<library>");
+                if (clixon_xml2cbuf(cb, xylib, 0, 0, NULL, -1, 0) < 0)
+                    goto done;
+                cprintf(cb, "</library>");
+            }
+        }
+        cprintf(cb, "</device>");
+    }
+    cprintf(cb, "</rpc-reply>");
+    cprintf(cbret, "%s", cbuf_get(cb));
+    retval = 0;
+ done:
+    if (cb)
+        cbuf_free(cb);
+    if (fps)
+        clicon_hash_free(fps);
+    return retval;
+}
+
+/*! Match device name with the devname patterns of a connection-change request
+ *
+ * An internal request may have several devname patterns, see controller_device_reconnect
+ * @param[in]  xe      Request: <rpc><xn></rpc>
+ * @param[in]  devname Device name
+ * @retval     1       Match, or no pattern
+ * @retval     0       No match
+ */
+static int
+connection_change_match(cxobj *xe,
+                        char  *devname)
+{
+    cxobj *x = NULL;
+    char  *pattern;
+    int    nr = 0;
+
+    while ((x = xml_child_each(xe, x, CX_ELMNT)) != NULL){
+        if (strcmp(xml_name(x), "devname") != 0 ||
+            (pattern = xml_body(x)) == NULL)
+            continue;
+        nr++;
+        if (fnmatch(pattern, devname, 0) == 0)
+            return 1;
+    }
+    return nr == 0;
+}
+
+/*! (Re)connect try an enabled device in CLOSED state.
+ *
+ * If closed due to error it may need to be cleared and reconnected
+ * @param[in]  h         Clixon handle
+ * @param[in]  xe        Request: <rpc><xn></rpc>
+ * @param[out] cbret     Return xml tree, eg <rpc-reply>..., <rpc-error..
+ * @param[in]  client_id Client id of originator
+ * @param[in]  ctq       Dequeued transaction, or NULL if direct rpc
+ * @retval     0         OK
+ * @retval    -1         Error
+ */
+static int
+rpc_connection_change1(clixon_handle           h,
+                       cxobj                  *xe,
+                       cbuf                   *cbret,
+                       uint32_t                client_id,
+                       controller_transaction *ctq)
 {
     int                     retval = -1;
-    char                   *pattern = NULL;
     cxobj                  *xret = NULL;
     cxobj                  *xn;
     cvec                   *nsc = NULL;
@@ -1563,31 +2478,24 @@ rpc_connection_change(clixon_handle h,
     int                     enabled;
     device_handle           dh;
     controller_transaction *ct = NULL;
-    client_entry           *ce;
     char                   *operation;
-    cbuf                   *cberr = NULL;
     cbuf                   *cbtr = NULL;
     char                   *reason = NULL;
     int                     ret;
 
     clixon_debug(CLIXON_DBG_DEFAULT, "%s", __FUNCTION__);
-    ce = (client_entry *)arg;
     if ((cbtr = cbuf_new()) == NULL){
         clixon_err(OE_UNIX, errno, "cbuf_new");
         goto done;
     }
     cprintf(cbtr, "Controller commit");
-    pattern = xml_find_body(xe, "devname");
     operation = xml_find_body(xe, "operation");
     cprintf(cbtr, " %s", operation);
-    if ((ret = controller_transaction_new(h, cbuf_get(cbtr), &ct, &cberr)) < 0)
+    if ((ret = rpc_transaction_begin(h, cbuf_get(cbtr), xe, client_id, rpc_connection_change1, ctq,
+                                     &ct, cbret)) < 0)
         goto done;
-    if (ret == 0){
-        if (netconf_operation_failed(cbret, "application", cbuf_get(cberr))< 0)
-            goto done;
+    if (ret == 0)
         goto ok;
-    }
-    ct->ct_client_id = ce->ce_id;
     // XXX: Should work with WITHDEFAULTS_EXPLICIT?
     if (xmldb_get0(h, "running", YB_MODULE, nsc, "devices", 1, WITHDEFAULTS_REPORT_ALL, &xret, NULL, NULL) < 0)
         goto done;
@@ -1600,13 +2508,17 @@ rpc_connection_change(clixon_handle h,
         if ((body = xml_find_body(xn, "enabled")) == NULL)
             continue;
         enabled = strcmp(body, "true")==0;
-        if (pattern != NULL && fnmatch(pattern, devname, 0) != 0)
+        if (connection_change_match(xe, devname) == 0)
             continue;
         dh = device_handle_find(h, devname);
         /* @see clixon-controller.yang connection-operation */
         if (strcmp(operation, "CLOSE") == 0){
-            /* Close if there is a handle and it is OPEN */
-            if (dh != NULL && device_handle_conn_state_get(dh) == CS_OPEN){
+            /* No auto-reconnect after user close */
+            if (dh != NULL && device_reconnect_cancel(dh) < 0)
+                goto done;
+            /* Close if there is a handle and it is OPEN or waiting to connect */
+            if (dh != NULL && (device_handle_conn_state_get(dh) == CS_OPEN ||
+                               device_handle_conn_state_get(dh) == CS_CONNECT_PENDING)){
                 if (device_close_connection(dh, "User request") < 0)
                     goto done;
             }
@@ -1627,6 +2539,8 @@ rpc_connection_change(clixon_handle h,
         else if (strcmp(operation, "RECONNECT") == 0){
             /* First close it if there is a handle and it is OPEN */
             if (dh != NULL && device_handle_conn_state_get(dh) == CS_OPEN){
+                if (device_reconnect_cancel(dh) < 0)
+                    goto done;
                 if (device_close_connection(dh, "User request") < 0)
                     goto done;
             }
@@ -1655,14 +2569,15 @@ rpc_connection_change(clixon_handle h,
             goto done;
     }
  ok:
+    /* Start connecting pending devices, also those requested before a failure */
+    if (device_connect_schedule(h) < 0)
+        goto done;
     retval = 0;
  done:
     if (reason)
         free(reason);
     if (cbtr)
         cbuf_free(cbtr);
-    if (cberr)
-        cbuf_free(cberr);
     if (vec)
         free(vec);
     if (xret)
@@ -1670,6 +2585,109 @@ rpc_connection_change(clixon_handle h,
     return retval;
 }
 
+/*! (Re)connect try an enabled device in CLOSED state.
+ *
+ * @param[in]  h       Clixon handle
+ * @param[in]  xe      Request: <rpc><xn></rpc>
+ * @param[out] cbret   Return xml tree, eg <rpc-reply>..., <rpc-error..
+ * @param[in]  arg     Domain specific arg, ec client-entry or FCGX_Request
+ * @param[in]  regarg  User argument given at rpc_callback_register()
+ * @retval     0       OK
+ * @retval    -1       Error
+ */
+static int
+rpc_connection_change(clixon_handle h,
+                      cxobj        *xe,
+                      cbuf         *cbret,
+                      void         *arg,
+                      void         *regarg)
+{
+    client_entry *ce = (client_entry *)arg;
+
+    return rpc_connection_change1(h, xe, cbret, ce->ce_id, NULL);
+}
+
+/*! Auto-reconnect closed devices by a single internal connection-change OPEN request
+ *
+ * Goes through the commit queue and connect scheduler as a user request. All devices are
+ * reconnected in one transaction, with one devname pattern per device.
+ * @param[in]  h        Clixon handle
+ * @param[in]  devnames Device names, as cv names
+ * @retval     1        OK, reconnect started or queued
+ * @retval     0        Reconnect not started, eg commit queue full, error logged
+ * @retval    -1        Error
+ * @see device_reconnect_timeout
+ */
+int
+controller_device_reconnect(clixon_handle h,
+                            cvec         *devnames)
+{
+    int     retval = -1;
+    cbuf   *cb = NULL;
+    cbuf   *cbpat = NULL;
+    cbuf   *cbret = NULL;
+    cxobj  *xt = NULL;
+    cxobj  *xe;
+    cxobj  *xerr;
+    char   *msg;
+    cg_var *cv;
+    char   *c;
+
+    if ((cb = cbuf_new()) == NULL ||
+        (cbpat = cbuf_new()) == NULL ||
+        (cbret = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    cprintf(cb, "<connection-change xmlns=\"%s\">", CONTROLLER_NAMESPACE);
+    cv = NULL;
+    while ((cv = cvec_each(devnames, cv)) != NULL){
+        /* Device name as fnmatch pattern */
+        cbuf_reset(cbpat);
+        for (c = cv_name_get(cv); *c; c++){
+            if (strchr("*?[\\", *c) != NULL)
+                cprintf(cbpat, "\\");
+            cprintf(cbpat, "%c", *c);
+        }
+        cprintf(cb, "<devname>");
+        xml_chardata_cbuf_append(cb, cbuf_get(cbpat));
+        cprintf(cb, "</devname>");
+    }
+    cprintf(cb, "<operation>OPEN</operation></connection-change>");
+    if (clixon_xml_parse_string(cbuf_get(cb), YB_NONE, NULL, &xt, NULL) < 0)
+        goto done;
+    if ((xe = xml_child_i_type(xt, 0, CX_ELMNT)) == NULL){
+        clixon_err(OE_XML, EINVAL, "connection-change not found");
+        goto done;
+    }
+    if (rpc_connection_change1(h, xe, cbret, TRANSACTION_CLIENT_ID, NULL) < 0)
+        goto done;
+    xml_free(xt);
+    xt = NULL;
+    if (clixon_xml_parse_string(cbuf_get(cbret), YB_NONE, NULL, &xt, NULL) < 0)
+        goto done;
+    if ((xerr = xpath_first(xt, NULL, "//rpc-error")) != NULL){
+        if ((msg = xml_find_body(xerr, "error-message")) == NULL)
+            msg = "";
+        clixon_log(h, LOG_NOTICE, "Auto-reconnect of %d devices failed: %s", cvec_len(devnames), msg);
+        goto failed;
+    }
+    retval = 1;
+ done:
+    if (xt)
+        xml_free(xt);
+    if (cb)
+        cbuf_free(cb);
+    if (cbpat)
+        cbuf_free(cbpat);
+    if (cbret)
+        cbuf_free(cbret);
+    return retval;
+ failed:
+    retval = 0;
+    goto done;
+}
+
 /*! Terminate an ongoing transaction with an error condition
  *
  * If closed due to error it may need to be cleared and reconnected
@@ -1718,6 +2736,7 @@ rpc_transaction_error(clixon_handle h,
     case TS_RESOLVED:
     case TS_INIT:
     case TS_ACTIONS:
+    case TS_QUEUED:
         break;
     case TS_DONE:
         if (netconf_operation_failed(cbret, "application", "Transaction already completed") < 0)
@@ -1727,16 +2746,89 @@ rpc_transaction_error(clixon_handle h,
     }
     origin = xml_find_body(xe, "origin");
     reason = xml_find_body(xe, "reason");
-    if (controller_transaction_failed(h, tid, ct, NULL, TR_FAILED_DEV_IGNORE, origin, reason) < 0)
+    if (ct->ct_state == TS_QUEUED){ /* Remove from commit queue */
+        if (origin && (ct->ct_origin = strdup(origin)) == NULL){
+            clixon_err(OE_UNIX, errno, "strdup");
+            goto done;
+        }
+        if (reason && (ct->ct_reason = strdup(reason)) == NULL){
+            clixon_err(OE_UNIX, errno, "strdup");
+            goto done;
+        }
+    }
+    else if (controller_transaction_failed(h, tid, ct, NULL, TR_FAILED_DEV_IGNORE, origin, reason) < 0)
+        goto done;
+    if (controller_transaction_done(h, ct, TR_FAILED) < 0)
+        goto done;
+    cprintf(cbret, "<rpc-reply xmlns=\"%s\">", NETCONF_BASE_NAMESPACE);
+    cprintf(cbret, "<ok/>");
+    cprintf(cbret, "</rpc-reply>");
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Get trace of a transaction as Chrome trace-event JSON
+ *
+ * @param[in]  h       Clixon handle
+ * @param[in]  xe      Request: <rpc><xn></rpc>
+ * @param[out] cbret   Return xml tree, eg <rpc-reply>..., <rpc-error..
+ * @param[in]  arg     Domain specific arg, ec client-entry or FCGX_Request
+ * @param[in]  regarg  User argument given at rpc_callback_register()
+ * @retval     0       OK
+ * @retval    -1       Error
+ * @see controller_transaction_trace2json
+ */
+static int
+rpc_transaction_trace(clixon_handle h,
+                      cxobj        *xe,
+                      cbuf         *cbret,
+                      void         *arg,
+                      void         *regarg)
+{
+    int                     retval = -1;
+    char                   *tidstr;
+    uint64_t                tid;
+    int                     ret;
+    controller_transaction *ct;
+    cbuf                   *cb = NULL;
+
+    clixon_debug(CLIXON_DBG_DEFAULT, "%s", __FUNCTION__);
+    if ((tidstr = xml_find_body(xe, "tid")) == NULL){
+        if (netconf_operation_failed(cbret, "application", "No tid")< 0)
+            goto done;
+        goto ok;
+    }
+    if ((ret = parse_uint64(tidstr, &tid, NULL)) < 0)
+        goto done;
+    if (ret == 0){
+        if (netconf_operation_failed(cbret, "application", "Invalid tid")< 0)
+            goto done;
+        goto ok;
+    }
+    if ((ct = controller_transaction_find(h, tid)) == NULL){
+        if (netconf_operation_failed(cbret, "application", "No such transaction")< 0)
+            goto done;
+        goto ok;
+    }
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
         goto done;
-    if (controller_transaction_done(h, ct, TR_FAILED) < 0)
+    }
+    if (controller_transaction_trace2json(ct, cb) < 0)
         goto done;
     cprintf(cbret, "<rpc-reply xmlns=\"%s\">", NETCONF_BASE_NAMESPACE);
-    cprintf(cbret, "<ok/>");
+    cprintf(cbret, "<trace xmlns=\"%s\">", CONTROLLER_NAMESPACE);
+    if (xml_chardata_cbuf_append(cbret, cbuf_get(cb)) < 0)
+        goto done;
+    cprintf(cbret, "</trace>");
     cprintf(cbret, "</rpc-reply>");
  ok:
     retval = 0;
  done:
+    if (cb)
+        cbuf_free(cb);
     return retval;
 }
 
@@ -1784,6 +2876,7 @@ rpc_transactions_actions_done(clixon_handle h,
     switch (ct->ct_state){
     case TS_RESOLVED:
     case TS_INIT:
+    case TS_QUEUED:
         if (netconf_operation_failed(cbret, "application", "Transaction in unexpected state") < 0)
             goto done;
         break;
@@ -1881,15 +2974,149 @@ datastore_diff_dsref(clixon_handle    h,
     return retval;
 }
 
+/*! Read configs of a set of devices from a datastore in one request
+ *
+ * Device config types not in a datastore, ie synced and transient, are not read
+ * @param[in]   h       Clixon handle
+ * @param[in]   dt      Type of device config
+ * @param[in]   nsc     Namespace context
+ * @param[in]   devs    Device names
+ * @param[in]   all     If set, devs are all devices, no selection is made
+ * @param[out]  xtp     XML tree, free with xml_free
+ * @retval      0       OK
+ * @retval     -1       Error
+ */
+static int
+datastore_diff_read(clixon_handle      h,
+                    device_config_type dt,
+                    cvec              *nsc,
+                    cvec              *devs,
+                    int                all,
+                    cxobj            **xtp)
+{
+    int     retval = -1;
+    cbuf   *cbxpath = NULL;
+    cg_var *cv;
+    char   *db;
+
+    switch (dt){
+    case DT_RUNNING:
+        db = "running";
+        break;
+    case DT_CANDIDATE:
+        db = "candidate";
+        break;
+    case DT_ACTIONS:
+        db = "actions";
+        break;
+    default:
+        goto ok;
+    }
+    if ((cbxpath = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    if (all)
+        cprintf(cbxpath, "devices/device/config");
+    else {
+        cv = NULL;
+        while ((cv = cvec_each(devs, cv)) != NULL){
+            if (cbuf_len(cbxpath))
+                cprintf(cbxpath, " | ");
+            cprintf(cbxpath, "devices/device[name='%s']/config", cv_string_get(cv));
+        }
+    }
+    if (xmldb_get0(h, db, Y_MODULE, nsc, cbuf_get(cbxpath), 1, WITHDEFAULTS_EXPLICIT, xtp, NULL, NULL) < 0)
+        goto done;
+ ok:
+    retval = 0;
+ done:
+    if (cbxpath)
+        cbuf_free(cbxpath);
+    return retval;
+}
+
+/*! Get config of one device for diff
+ *
+ * @param[in]   h       Clixon handle
+ * @param[in]   dt      Type of device config
+ * @param[in]   devname Device name
+ * @param[in]   nsc     Namespace context
+ * @param[in]   xt      Configs read from datastore, see datastore_diff_read
+ * @param[out]  xp      Device config in xt
+ * @param[out]  xmp     Device config read from file, free with xml_free
+ * @param[out]  cberr   Error message if retval is 0, free with cbuf_free
+ * @retval      1       OK
+ * @retval      0       Failed, reason in cberr
+ * @retval     -1       Error
+ */
+static int
+datastore_diff_device_config(clixon_handle      h,
+                             device_config_type dt,
+                             char              *devname,
+                             cvec              *nsc,
+                             cxobj             *xt,
+                             cxobj            **xp,
+                             cxobj            **xmp,
+                             cbuf             **cberr)
+{
+    char *ct;
+
+    *xp = *xmp = NULL;
+    switch (dt){
+    case DT_RUNNING:
+    case DT_CANDIDATE:
+    case DT_ACTIONS:
+        if (xt)
+            *xp = xpath_first(xt, nsc, "devices/device[name='%s']/config", devname);
+        break;
+    case DT_SYNCED:
+    case DT_TRANSIENT:
+        ct = device_config_type_int2str(dt);
+        return device_config_read(h, devname, ct, xmp, cberr);
+    }
+    return 1;
+}
+
+/*! Count changed lines in a diff, ie lines starting with + or -
+ *
+ * @param[in]   cb      Diff as produced by clixon_xml_diff2cbuf or clixon_text_diff2cbuf
+ * @retval      nr      Number of changed lines
+ */
+static uint32_t
+datastore_diff_changes(cbuf *cb)
+{
+    uint32_t nr = 0;
+    char    *s;
+
+    s = cbuf_get(cb);
+    while (*s != '\0'){
+        while (*s == ' ' || *s == '\t')
+            s++;
+        if (*s == '+' || *s == '-')
+            nr++;
+        if ((s = strchr(s, '\n')) == NULL)
+            break;
+        s++;
+    }
+    return nr;
+}
+
 /*! Given a device pattern, return diff in textual form between different device configs
  *
  * That is diff of configs for same device, only different variants, eg synced, transient, running, etc
+ * Datastore configs of all devices in a reply are read in one request.
+ * Devices may be requested in pages of limit devices starting at offset. If more devices
+ * remain, the reply contains next-offset.
  * @param[in]   h       Clixon handle
  * @param[in]   xpath   XPath
  * @param[in]   pattern Glob pattern for selecting devices
  * @param[in]   dt1     Type of device config 1
  * @param[in]   dt2     Type of device config 2
  * @param[in]   format  Format of diff
+ * @param[in]   summary Only return changed and number of changes per device
+ * @param[in]   offset  Number of matching devices to skip
+ * @param[in]   limit   Max number of devices in reply, 0 means all
  * @param[out]  cbret   CLIgen buff with NETCONF reply
  * @retval      0       OK
  * @retval     -1       Error
@@ -1902,10 +3129,12 @@ datastore_diff_device(clixon_handle      h,
                       device_config_type dt1,
                       device_config_type dt2,
                       enum format_enum   format,
+                      int                summary,
+                      uint32_t           offset,
+                      uint32_t           limit,
                       cbuf              *cbret)
 {
     int           retval = -1;
-    cbuf         *cbxpath = NULL;
     cbuf         *cberr = NULL;
     cbuf         *cb = NULL;
     cxobj        *x1;
@@ -1920,132 +3149,100 @@ datastore_diff_device(clixon_handle      h,
     size_t        veclen;
     char         *devname;
     cxobj        *xdev;
-    device_handle dh;
+    cvec         *devs = NULL;
+    cg_var       *cv;
+    uint32_t      matching = 0;
+    int           more = 0;
     int           i;
     int           ret;
-    char         *ct;
 
-    if ((cbxpath = cbuf_new()) == NULL){
+    if ((cb = cbuf_new()) == NULL){
         clixon_err(OE_UNIX, errno, "cbuf_new");
         goto done;
     }
-    if ((cb = cbuf_new()) == NULL){
-        clixon_err(OE_UNIX, errno, "cbuf_new");
+    if ((devs = cvec_new(0)) == NULL){
+        clixon_err(OE_UNIX, errno, "cvec_new");
         goto done;
     }
     if (xmldb_get0(h, "running", Y_MODULE, nsc, "devices/device/name", 1, WITHDEFAULTS_EXPLICIT, &xret, NULL, NULL) < 0)
         goto done;
-    cprintf(cbret, "<rpc-reply xmlns=\"%s\">", NETCONF_BASE_NAMESPACE);
     if (xpath_vec(xret, nsc, "devices/device/name", &vec, &veclen) < 0)
         goto done;
+    /* Select devices of this reply */
     for (i=0; i<veclen; i++){
         xdev = vec[i];
         if ((devname = xml_body(xdev)) == NULL)
             continue;
-        if ((dh = device_handle_find(h, devname)) == NULL)
+        if (device_handle_find(h, devname) == NULL)
             continue;
         if (pattern != NULL && fnmatch(pattern, devname, 0) != 0)
             continue;
-        x1 = x1m = NULL;
-        switch (dt1){
-        case DT_RUNNING:
-            cbuf_reset(cbxpath);
-            cprintf(cbxpath, "devices/device[name='%s']/config", devname);
-            if (xmldb_get0(h, "running", Y_MODULE, nsc, cbuf_get(cbxpath), 1, WITHDEFAULTS_EXPLICIT, &x1ret, NULL, NULL) < 0)
-                goto done;
-            x1 = xpath_first(x1ret, nsc, "devices/device/config");
-            break;
-        case DT_CANDIDATE:
-            cbuf_reset(cbxpath);
-            cprintf(cbxpath, "devices/device[name='%s']/config", devname);
-            if (xmldb_get0(h, "candidate", Y_MODULE, nsc, cbuf_get(cbxpath), 1, WITHDEFAULTS_EXPLICIT, &x1ret, NULL, NULL) < 0)
-                goto done;
-            x1 = xpath_first(x1ret, nsc, "devices/device/config");
-            break;
-        case DT_ACTIONS:
-            cbuf_reset(cbxpath);
-            cprintf(cbxpath, "devices/device[name='%s']/config", devname);
-            if (xmldb_get0(h, "actions", Y_MODULE, nsc, cbuf_get(cbxpath), 1, WITHDEFAULTS_EXPLICIT, &x1ret, NULL, NULL) < 0)
-                goto done;
-            x1 = xpath_first(x1ret, nsc, "devices/device/config");
-            break;
-        case DT_SYNCED:
-        case DT_TRANSIENT:
-            ct = device_config_type_int2str(dt1);
-            if ((ret = device_config_read(h, devname, ct, &x1m, &cberr)) < 0)
-                goto done;
-            if (ret == 0){
-                cbuf_reset(cbret);
-                if (netconf_operation_failed(cbret, "application", cbuf_get(cberr))< 0)
-                    goto done;
-                goto ok;
-            }
+        if (matching++ < offset)
+            continue;
+        if (limit && cvec_len(devs) == limit){
+            more++;
             break;
         }
-        x2 = x2m = NULL;
-        switch (dt2){
-        case DT_RUNNING:
-            cbuf_reset(cbxpath);
-            cprintf(cbxpath, "devices/device[name='%s']/config", devname);
-            if (xmldb_get0(h, "running", Y_MODULE, nsc, cbuf_get(cbxpath), 1, WITHDEFAULTS_EXPLICIT, &x2ret, NULL, NULL) < 0)
-                goto done;
-            x2 = xpath_first(x2ret, nsc, "devices/device/config");
-            break;
-        case DT_CANDIDATE:
-            cbuf_reset(cbxpath);
-            cprintf(cbxpath, "devices/device[name='%s']/config", devname);
-            if (xmldb_get0(h, "candidate", Y_MODULE, nsc, cbuf_get(cbxpath), 1, WITHDEFAULTS_EXPLICIT, &x2ret, NULL, NULL) < 0)
-                goto done;
-            x2 = xpath_first(x2ret, nsc, "devices/device/config");
-            break;
-        case DT_ACTIONS:
-            cbuf_reset(cbxpath);
-            cprintf(cbxpath, "devices/device[name='%s']/config", devname);
-            if (xmldb_get0(h, "actions", Y_MODULE, nsc, cbuf_get(cbxpath), 1, WITHDEFAULTS_EXPLICIT, &x2ret, NULL, NULL) < 0)
+        if (cvec_add_string(devs, NULL, devname) < 0){
+            clixon_err(OE_UNIX, errno, "cvec_add_string");
+            goto done;
+        }
+    }
+    /* Read datastore configs of all devices in one request */
+    if (cvec_len(devs)){
+        if (datastore_diff_read(h, dt1, nsc, devs, cvec_len(devs) == veclen, &x1ret) < 0)
+            goto done;
+        if (datastore_diff_read(h, dt2, nsc, devs, cvec_len(devs) == veclen, &x2ret) < 0)
+            goto done;
+    }
+    cprintf(cbret, "<rpc-reply xmlns=\"%s\">", NETCONF_BASE_NAMESPACE);
+    cv = NULL;
+    while ((cv = cvec_each(devs, cv)) != NULL){
+        devname = cv_string_get(cv);
+        if ((ret = datastore_diff_device_config(h, dt1, devname, nsc, x1ret, &x1, &x1m, &cberr)) < 0)
+            goto done;
+        if (ret == 0){
+            cbuf_reset(cbret);
+            if (netconf_operation_failed(cbret, "application", cbuf_get(cberr))< 0)
                 goto done;
-            x2 = xpath_first(x2ret, nsc, "devices/device/config");
-            break;
-        case DT_SYNCED:
-        case DT_TRANSIENT:
-            ct = device_config_type_int2str(dt2);
-            if ((ret = device_config_read(h, devname, ct, &x2m, &cberr)) < 0)
+            goto ok;
+        }
+        if ((ret = datastore_diff_device_config(h, dt2, devname, nsc, x2ret, &x2, &x2m, &cberr)) < 0)
+            goto done;
+        if (ret == 0){
+            cbuf_reset(cbret);
+            if (netconf_operation_failed(cbret, "application", cbuf_get(cberr))< 0)
                 goto done;
-            if (ret == 0){
-                cbuf_reset(cbret);
-                if (netconf_operation_failed(cbret, "application", cbuf_get(cberr))< 0)
-                    goto done;
-                goto ok;
-            }
-            break;
+            goto ok;
         }
+        cbuf_reset(cb);
         switch (format){
         case FORMAT_XML:
-            cbuf_reset(cb);
             if (clixon_xml_diff2cbuf(cb, x1?x1:x1m, x2?x2:x2m) < 0)
                 goto done;
-            if (cbuf_len(cb)){
-                cprintf(cbret, "<diff xmlns=\"%s\">", CONTROLLER_NAMESPACE);
-                cprintf(cbret, "%s:\n", devname);
-                xml_chardata_cbuf_append(cbret, cbuf_get(cb));
-                cprintf(cbret, "</diff>");
-            }
             break;
         case FORMAT_TEXT:
-            cbuf_reset(cb);
             if (clixon_text_diff2cbuf(cb, x1?x1:x1m, x2?x2:x2m) < 0)
                 goto done;
-            if (cbuf_len(cb)){
-                cprintf(cbret, "<diff xmlns=\"%s\">", CONTROLLER_NAMESPACE);
-                cprintf(cbret, "%s:\n", devname);
-                xml_chardata_cbuf_append(cbret, cbuf_get(cb));
-                cprintf(cbret, "</diff>");
-            }
             break;
         case FORMAT_JSON:
         case FORMAT_CLI:
         default:
             break;
         }
+        if (summary){
+            cprintf(cbret, "<device xmlns=\"%s\">", CONTROLLER_NAMESPACE);
+            cprintf(cbret, "<name>%s</name>", devname);
+            cprintf(cbret, "<changed>%s</changed>", cbuf_len(cb)?"true":"false");
+            cprintf(cbret, "<changes>%u</changes>", datastore_diff_changes(cb));
+            cprintf(cbret, "</device>");
+        }
+        else if (cbuf_len(cb)){
+            cprintf(cbret, "<diff xmlns=\"%s\">", CONTROLLER_NAMESPACE);
+            cprintf(cbret, "%s:\n", devname);
+            xml_chardata_cbuf_append(cbret, cbuf_get(cb));
+            cprintf(cbret, "</diff>");
+        }
         if (x1m){
             xml_free(x1m);
             x1m = NULL;
@@ -2054,19 +3251,16 @@ datastore_diff_device(clixon_handle      h,
             xml_free(x2m);
             x2m = NULL;
         }
-        if (x1ret){
-            xml_free(x1ret);
-            x1ret = NULL;
-        }
-        if (x2ret){
-            xml_free(x2ret);
-            x2ret = NULL;
-        }
     }
+    if (more)
+        cprintf(cbret, "<next-offset xmlns=\"%s\">%u</next-offset>",
+                CONTROLLER_NAMESPACE, offset + cvec_len(devs));
     cprintf(cbret, "</rpc-reply>");
  ok:
     retval = 0;
  done:
+    if (devs)
+        cvec_free(devs);
     if (x1m)
         xml_free(x1m);
     if (x2m)
@@ -2083,8 +3277,6 @@ datastore_diff_device(clixon_handle      h,
         cbuf_free(cberr);
     if (cb)
         cbuf_free(cb);
-    if (cbxpath)
-        cbuf_free(cbxpath);
     return retval;
 }
 
@@ -2120,6 +3312,11 @@ rpc_datastore_diff(clixon_handle h,
     char              *devname;
     char              *formatstr;
     enum format_enum   format = FORMAT_XML;
+    char              *str;
+    int                summary = 0;
+    uint32_t           offset = 0;
+    uint32_t           limit = 0;
+    int                ret;
 
     clixon_debug(CLIXON_DBG_DEFAULT, "%s", __FUNCTION__);
     xpath = xml_find_body(xe, "xpath");
@@ -2173,7 +3370,27 @@ rpc_datastore_diff(clixon_handle h,
                 goto done;
             goto ok;
         }
-        if (datastore_diff_device(h, xpath, devname, dt1, dt2, format, cbret) < 0)
+        if ((str = xml_find_body(xe, "summary")) != NULL)
+            summary = strcmp(str, "true") == 0;
+        if ((str = xml_find_body(xe, "offset")) != NULL){
+            if ((ret = parse_uint32(str, &offset, NULL)) < 0)
+                goto done;
+            if (ret == 0){
+                if (netconf_operation_failed(cbret, "application", "Invalid offset")< 0)
+                    goto done;
+                goto ok;
+            }
+        }
+        if ((str = xml_find_body(xe, "limit")) != NULL){
+            if ((ret = parse_uint32(str, &limit, NULL)) < 0)
+                goto done;
+            if (ret == 0){
+                if (netconf_operation_failed(cbret, "application", "Invalid limit")< 0)
+                    goto done;
+                goto ok;
+            }
+        }
+        if (datastore_diff_device(h, xpath, devname, dt1, dt2, format, summary, offset, limit, cbret) < 0)
             goto done;
     }
  ok:
@@ -2283,106 +3500,405 @@ clixon_strsep2(char   *str,
             nr += 2;
         s1 = s2 + strlen(delim2);
     }
-    /* alloc vector and append copy of string */
-    sz = (nr+1)* sizeof(char*) + strlen(str)+1;
-    if ((vec = (char**)malloc(sz)) == NULL){
-        clixon_err(OE_UNIX, errno, "malloc");
+    /* alloc vector and append copy of string */
+    sz = (nr+1)* sizeof(char*) + strlen(str)+1;
+    if ((vec = (char**)malloc(sz)) == NULL){
+        clixon_err(OE_UNIX, errno, "malloc");
+        goto done;
+    }
+    memset(vec, 0, sz);
+    ptr = (char*)vec + (nr+1)* sizeof(char*); /* this is where ptr starts */
+    strcpy(ptr, str);
+    i = 0;
+    s1 = ptr;
+    vec[i++] = ptr;
+    while ((s1 = strstr(s1, delim1)) != NULL){
+        if ((s2 = strstr(s1+strlen(delim1), delim2)) != NULL){
+            *s1 = '\0';
+            *s2 = '\0';
+            vec[i++] = s1 + strlen(delim1);
+            vec[i++] = s2 + strlen(delim2);
+        }
+        s1 = s2 + strlen(delim2);
+    }
+    *vcp = vec;
+    ptr = NULL;
+    *nvec = i;
+    retval = 0;
+ done:
+    if (ptr)
+        free(ptr);
+    return retval;
+}
+
+/*! Substitution site of a compiled device template
+ *
+ * A body of the template config containing ${var} variables, split by clixon_strsep2 into
+ * literals on even and variable names on odd positions
+ */
+struct template_site {
+    cxobj  *ts_xb;     /* Body node in private template copy */
+    char  **ts_vec;    /* Literals and variable names, see clixon_strsep2 */
+    int     ts_nvec;   /* Length of ts_vec, always odd */
+    int    *ts_slots;  /* Variable slot of each odd position of ts_vec */
+};
+
+/*! Compiled device template
+ *
+ * Compiled when committed, applying it to devices is then substitution of variable values
+ * into the sites of a private copy of the template config
+ */
+struct template_compiled {
+    cxobj                *tc_xsrc;    /* Template config as compiled, to check against running */
+    cxobj                *tc_xtmpl;   /* Private copy of template config */
+    clicon_hash_t        *tc_vars;    /* Variable name -> slot */
+    int                   tc_nvars;   /* Number of variable slots */
+    struct template_site *tc_sites;   /* Vector of substitution sites */
+    int                   tc_nsites;  /* Length of tc_sites */
+};
+
+/*! Get compiled device templates, a hash from template name to compiled template
+ *
+ * @param[in]  h      Clixon handle
+ * @retval     hash   Compiled templates
+ * @retval     NULL   Not created yet
+ * @see controller_template_commit  where the templates are compiled
+ */
+static clicon_hash_t *
+template_compiled_get(clixon_handle h)
+{
+    clicon_hash_t *tmpls = NULL;
+
+    if (clicon_ptr_get(h, "controller-templates", (void**)&tmpls) < 0)
+        return NULL;
+    return tmpls;
+}
+
+/*! Free compiled device template
+ *
+ * @param[in]  tc  Compiled template
+ */
+static int
+template_compiled_free(struct template_compiled *tc)
+{
+    int i;
+
+    if (tc->tc_sites){
+        for (i=0; i<tc->tc_nsites; i++){
+            if (tc->tc_sites[i].ts_vec)
+                free(tc->tc_sites[i].ts_vec);
+            if (tc->tc_sites[i].ts_slots)
+                free(tc->tc_sites[i].ts_slots);
+        }
+        free(tc->tc_sites);
+    }
+    if (tc->tc_vars)
+        clicon_hash_free(tc->tc_vars);
+    if (tc->tc_xtmpl)
+        xml_free(tc->tc_xtmpl);
+    if (tc->tc_xsrc)
+        xml_free(tc->tc_xsrc);
+    free(tc);
+    return 0;
+}
+
+/*! XML apply function: add substitution site of body with variables to compiled template
+ *
+ * @param[in]  x    XML node
+ * @param[in]  arg  Compiled template
+ * @retval    -1    Error, aborted at first error encounter, return -1 to end user
+ * @retval     0    OK, continue
+ */
+static int
+template_site_add(cxobj *x,
+                  void  *arg)
+{
+    int                       retval = -1;
+    struct template_compiled *tc = (struct template_compiled *)arg;
+    struct template_site     *ts;
+    cxobj                    *xb;
+    char                     *b;
+    char                    **vec = NULL;
+    int                       nvec = 0;
+    int                      *slots = NULL;
+    void                     *p;
+    size_t                    vlen;
+    int                       i;
+
+    if ((xb = xml_body_get(x)) == NULL ||
+        (b = xml_value(xb)) == NULL)
+        goto ok;
+    if (clixon_strsep2(b, "${", "}", &vec, &nvec) < 0)
+        goto done;
+    assert(nvec%2 == 1); /* Must be odd */
+    if (nvec == 1)
+        goto ok;
+    if ((slots = calloc(nvec, sizeof(int))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        goto done;
+    }
+    for (i=1; i<nvec; i+=2){
+        if ((p = clicon_hash_value(tc->tc_vars, vec[i], &vlen)) != NULL)
+            slots[i] = *(int*)p;
+        else {
+            slots[i] = tc->tc_nvars++;
+            if (clicon_hash_add(tc->tc_vars, vec[i], &slots[i], sizeof(int)) == NULL)
+                goto done;
+        }
+    }
+    if ((ts = realloc(tc->tc_sites, (tc->tc_nsites+1)*sizeof(*ts))) == NULL){
+        clixon_err(OE_UNIX, errno, "realloc");
+        goto done;
+    }
+    tc->tc_sites = ts;
+    ts = &tc->tc_sites[tc->tc_nsites++];
+    ts->ts_xb = xb;
+    ts->ts_vec = vec;
+    ts->ts_nvec = nvec;
+    ts->ts_slots = slots;
+    vec = NULL;
+    slots = NULL;
+ ok:
+    retval = 0;
+ done:
+    if (vec)
+        free(vec);
+    if (slots)
+        free(slots);
+    return retval;
+}
+
+/*! Compile device template and add it to compiled templates, replacing any old
+ *
+ * @param[in]  tmpls  Compiled templates
+ * @param[in]  name   Template name
+ * @param[in]  xconf  Template config
+ * @param[out] tcp    Compiled template (if not NULL)
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+static int
+template_compile(clicon_hash_t             *tmpls,
+                 char                      *name,
+                 cxobj                     *xconf,
+                 struct template_compiled **tcp)
+{
+    int                       retval = -1;
+    struct template_compiled *tc = NULL;
+    void                     *p;
+    size_t                    vlen;
+
+    if ((tc = calloc(1, sizeof(*tc))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        goto done;
+    }
+    if ((tc->tc_vars = clicon_hash_init()) == NULL)
+        goto done;
+    if ((tc->tc_xsrc = xml_dup(xconf)) == NULL)
+        goto done;
+    if ((tc->tc_xtmpl = xml_dup(xconf)) == NULL)
+        goto done;
+    if (xml_apply(tc->tc_xtmpl, CX_ELMNT, template_site_add, tc) < 0)
+        goto done;
+    if ((p = clicon_hash_value(tmpls, name, &vlen)) != NULL){
+        template_compiled_free(*(struct template_compiled **)p);
+        clicon_hash_del(tmpls, name);
+    }
+    if (clicon_hash_add(tmpls, name, &tc, sizeof(tc)) == NULL)
+        goto done;
+    if (tcp)
+        *tcp = tc;
+    tc = NULL;
+    retval = 0;
+ done:
+    if (tc)
+        template_compiled_free(tc);
+    return retval;
+}
+
+/*! Substitute variable values into the sites of a compiled template
+ *
+ * Values of variables not given are empty. If no variables are given, the template
+ * text is left unchanged.
+ * @param[in]  tc     Compiled template
+ * @param[in]  xvars  Variables: list of name/value pairs, or NULL
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+static int
+template_substitute(struct template_compiled *tc,
+                    cxobj                    *xvars)
+{
+    int                   retval = -1;
+    struct template_site *ts;
+    char                **vals = NULL;
+    char                 *varname;
+    char                 *val;
+    cxobj                *xv;
+    cbuf                 *cb = NULL;
+    void                 *p;
+    size_t                vlen;
+    int                   i;
+    int                   j;
+
+    if (tc->tc_nsites == 0)
+        goto ok;
+    if ((vals = calloc(tc->tc_nvars, sizeof(char*))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        goto done;
+    }
+    xv = NULL;
+    while (xvars && (xv = xml_child_each(xvars, xv, CX_ELMNT)) != NULL) {
+        if ((varname = xml_find_body(xv, "name")) == NULL)
+            continue;
+        if ((p = clicon_hash_value(tc->tc_vars, varname, &vlen)) == NULL)
+            continue;
+        if (vals[*(int*)p] == NULL)
+            vals[*(int*)p] = xml_find_body(xv, "value");
+    }
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
         goto done;
     }
-    memset(vec, 0, sz);
-    ptr = (char*)vec + (nr+1)* sizeof(char*); /* this is where ptr starts */
-    strcpy(ptr, str);
-    i = 0;
-    s1 = ptr;
-    vec[i++] = ptr;
-    while ((s1 = strstr(s1, delim1)) != NULL){
-        if ((s2 = strstr(s1+strlen(delim1), delim2)) != NULL){
-            *s1 = '\0';
-            *s2 = '\0';
-            vec[i++] = s1 + strlen(delim1);
-            vec[i++] = s2 + strlen(delim2);
+    for (i=0; i<tc->tc_nsites; i++){
+        ts = &tc->tc_sites[i];
+        cbuf_reset(cb);
+        for (j=0; j<ts->ts_nvec; j++){
+            if (j%2 == 0)
+                cprintf(cb, "%s", ts->ts_vec[j]);
+            else if (xvars == NULL)
+                cprintf(cb, "${%s}", ts->ts_vec[j]);
+            else if ((val = vals[ts->ts_slots[j]]) != NULL)
+                cprintf(cb, "%s", val);
         }
-        s1 = s2 + strlen(delim2);
+        if (xml_value_set(ts->ts_xb, cbuf_get(cb)) < 0)
+            goto done;
     }
-    *vcp = vec;
-    ptr = NULL;
-    *nvec = i;
+ ok:
     retval = 0;
  done:
-    if (ptr)
-        free(ptr);
+    if (cb)
+        cbuf_free(cb);
+    if (vals)
+        free(vals);
     return retval;
 }
 
-/*! XML apply function: replace any variables
+/*! Compile changed device templates in a running commit
  *
- * @param[in]  x    XML node
- * @param[in]  arg  xvars: list of variable substitutions
- * @retval    -1    Error, aborted at first error encounter, return -1 to end user
- * @retval     0    OK, continue
- * @retval     1    Abort, dont continue with others, return 1 to end user
- * @retval     2    Locally abort this subtree, continue with others
+ * Also called in startup commit, where all templates are compiled
+ * @param[in]  h       Clixon handle
+ * @param[in]  nsc     Namespace context
+ * @param[in]  src     Pre-existing xml tree
+ * @param[in]  target  Post target xml tree
+ * @retval     0       OK
+ * @retval    -1       Error
+ * @see rpc_device_template_apply  where compiled templates are applied
  */
-static int
-apply_template(cxobj *x,
-               void  *arg)
+int
+controller_template_commit(clixon_handle h,
+                           cvec         *nsc,
+                           cxobj        *src,
+                           cxobj        *target)
 {
-    int    retval = -1;
-    cxobj *xvars = (cxobj *)arg;
-    cxobj *xv;
-    cxobj *xb;
-    char  *b;
-    char  *var;
-    char  *varname;
-    char  *varval;
-    cbuf  *cb = NULL;
-    int    i;
-    char **vec = NULL;
-    int    nvec = 0;
+    int            retval = -1;
+    clicon_hash_t *tmpls;
+    cxobj        **vec = NULL;
+    size_t         veclen = 0;
+    cxobj         *xt;
+    cxobj         *xc;
+    char          *name;
+    void          *p;
+    size_t         vlen;
+    int            i;
 
-    xv = NULL;
-    if ((xb = xml_body_get(x)) != NULL &&
-        (b = xml_value(xb)) != NULL){
-        if (clixon_strsep2(b, "${", "}", &vec, &nvec) < 0)
+    if ((tmpls = template_compiled_get(h)) == NULL){
+        if ((tmpls = clicon_hash_init()) == NULL)
             goto done;
-        assert(nvec%2 == 1); /* Must be odd */
-        if (nvec > 1){
-            if ((cb = cbuf_new()) == NULL){
-                clixon_err(OE_UNIX, errno, "cbuf_new");
-                goto done;
-            }
-            i = 0;
-            while (i < nvec){
-                cprintf(cb, "%s", vec[i++]);
-                if (i == nvec)
-                    break;
-                var = vec[i++];
-                assert(i < nvec); /* Must be odd */
-                xv = NULL;
-                while ((xv = xml_child_each(xvars, xv, CX_ELMNT)) != NULL) {
-                    if ((varname = xml_find_body(xv, "name")) == NULL)
-                        continue;
-                    if (strcmp(varname, var) != 0)
-                        continue;
-                    varval = xml_find_body(xv, "value");
-                    cprintf(cb, "%s", varval);
-                    break;
-                }
+        clicon_ptr_set(h, "controller-templates", tmpls);
+    }
+    /* Remove deleted templates */
+    if (src && xpath_vec_flag(src, nsc, "devices/template", XML_FLAG_DEL, &vec, &veclen) < 0)
+        goto done;
+    for (i=0; i<veclen; i++){
+        xt = vec[i];
+        if ((name = xml_find_body(xt, "name")) == NULL)
+            continue;
+        if ((p = clicon_hash_value(tmpls, name, &vlen)) != NULL){
+            template_compiled_free(*(struct template_compiled **)p);
+            clicon_hash_del(tmpls, name);
+        }
+    }
+    if (vec){
+        free(vec);
+        vec = NULL;
+        veclen = 0;
+    }
+    /* Compile added and changed templates */
+    if (target && xpath_vec_flag(target, nsc, "devices/template", XML_FLAG_ADD|XML_FLAG_CHANGE,
+                                 &vec, &veclen) < 0)
+        goto done;
+    for (i=0; i<veclen; i++){
+        xt = vec[i];
+        if ((name = xml_find_body(xt, "name")) == NULL)
+            continue;
+        if ((xc = xml_find_type(xt, NULL, "config", CX_ELMNT)) == NULL){
+            if ((p = clicon_hash_value(tmpls, name, &vlen)) != NULL){
+                template_compiled_free(*(struct template_compiled **)p);
+                clicon_hash_del(tmpls, name);
             }
-            xml_value_set(xb, cbuf_get(cb));
+            continue;
         }
+        if (template_compile(tmpls, name, xc, NULL) < 0)
+            goto done;
     }
     retval = 0;
  done:
     if (vec)
         free(vec);
-    if (cb)
-        cbuf_free(cb);
+    return retval;
+}
+
+/*! Free compiled device templates
+ *
+ * @param[in]  h       Clixon handle
+ * @retval     0       OK
+ * @retval    -1       Error
+ */
+int
+controller_template_free(clixon_handle h)
+{
+    int            retval = -1;
+    clicon_hash_t *tmpls;
+    char         **keys = NULL;
+    size_t         nkeys;
+    int            i;
+    void          *p;
+    size_t         vlen;
+
+    if ((tmpls = template_compiled_get(h)) == NULL)
+        goto ok;
+    if (clicon_hash_keys(tmpls, &keys, &nkeys) < 0)
+        goto done;
+    for (i=0; i<nkeys; i++){
+        if ((p = clicon_hash_value(tmpls, keys[i], &vlen)) != NULL)
+            template_compiled_free(*(struct template_compiled **)p);
+    }
+    clicon_hash_free(tmpls);
+    clicon_ptr_del(h, "controller-templates");
+ ok:
+    retval = 0;
+ done:
+    if (keys)
+        free(keys);
     return retval;
 }
 
 /*! Action callback, see clixon-controller.yang: devices/template/apply
  *
+ * All matching device mount-points are merged into one tree and written to candidate
+ * in a single put. Devices where the template fails YANG binding are not applied, but
+ * reported individually in the reply.
  * @param[in]  h       Clixon handle
  * @param[in]  xn      Request: <rpc><xn></rpc>
  * @param[out] cbret   Return xml tree, eg <rpc-reply>..., <rpc-error..
@@ -2411,17 +3927,31 @@ rpc_device_template_apply(clixon_handle h,
     char         *pattern;
     int           matching;
     int           i;
+    int           j;
     int           ret;
     cxobj        *xerr = NULL;
-    cxobj        *xput = NULL;
     cxobj        *xtc;
-    cxobj        *xroot;
+    cxobj        *xtop = NULL;     /* Merge tree of all devices */
+    cxobj        *xdevs = NULL;    /* devices container of merge tree */
+    cxobj        *xroot = NULL;
     cxobj        *xmnt;
     cxobj        *x;
-    cbuf         *cb = NULL;
+    cbuf         *cbfail = NULL;   /* Devices where bind failed */
+    char         *reason;
     device_handle dh;
     yang_stmt    *yspec0;
     yang_stmt    *yspec1;
+    clicon_hash_t *tmpls;
+    struct template_compiled *tc = NULL;
+    void         *p;
+    size_t        vlen;
+    yang_stmt   **yspecs = NULL; /* Cache of template bound per device yspec */
+    cxobj       **xbound = NULL; /* Bound template, or NULL if bind failed */
+    char        **reasons = NULL;/* Bind error message if bind failed */
+    int           nbound = 0;
+    yang_stmt   **ys1;
+    cxobj       **xb1;
+    char        **r1;
 
     clixon_debug(CLIXON_DBG_DEFAULT, "%s", __FUNCTION__);
     yspec0 = clicon_dbspec_yang(h);
@@ -2443,21 +3973,26 @@ rpc_device_template_apply(clixon_handle h,
             goto done;
         goto ok;
     }
-    xvars = xml_find_type(xe, NULL, "variables", CX_ELMNT);
-    /* Destructively substitute variables in xtempl
-     * Maybe work on a copy instead?
-     */
-    if (xvars && xml_apply(xtmpl, CX_ELMNT, apply_template, xvars) < 0)
+    /* Get compiled template, compile if not done in commit, or if it is not the running
+     * template, eg after a failed commit */
+    if ((tmpls = template_compiled_get(h)) == NULL){
+        if ((tmpls = clicon_hash_init()) == NULL)
+            goto done;
+        clicon_ptr_set(h, "controller-templates", tmpls);
+    }
+    if ((p = clicon_hash_value(tmpls, tmplname, &vlen)) != NULL)
+        tc = *(struct template_compiled **)p;
+    if ((tc == NULL || xml_tree_equal(tc->tc_xsrc, xtmpl) != 0) &&
+        template_compile(tmpls, tmplname, xtmpl, &tc) < 0)
         goto done;
-    if (xml_sort_recurse(xtmpl) < 0)
+    xvars = xml_find_type(xe, NULL, "variables", CX_ELMNT);
+    /* Substitute variables in private copy of template */
+    if (template_substitute(tc, xvars) < 0)
         goto done;
-    if ((cb = cbuf_new()) == NULL){
+    if ((cbfail = cbuf_new()) == NULL){
         clixon_err(OE_UNIX, errno, "cbuf_new");
         goto done;
     }
-    cprintf(cb, "<devices xmlns=\"%s\" xmlns:%s=\"%s\" %s:operation=\"merge\">",
-            CONTROLLER_NAMESPACE,
-            NETCONF_BASE_PREFIX, NETCONF_BASE_NAMESPACE, NETCONF_BASE_PREFIX);
     /* Get devices from config */
     if (xpath_vec(xret, nsc, "devices/device", &vec, &veclen) < 0)
         goto done;
@@ -2471,8 +4006,6 @@ rpc_device_template_apply(clixon_handle h,
             continue;
         if ((dh = device_handle_find(h, devname)) == NULL)
             continue;
-        if (device_state_mount_point_get(devname, yspec0, &xroot, &xmnt) < 0)
-            goto done;
         yspec1 = NULL;
         if (controller_mount_yspec_get(h, devname, &yspec1) < 0)
             goto done;
@@ -2480,40 +4013,134 @@ rpc_device_template_apply(clixon_handle h,
             device_close_connection(dh, "No YANGs available");
             goto done;
         }
-        if ((xtc = xml_dup(xtmpl)) == NULL)
-            goto done;
-        if ((ret = xml_bind_yang(h, xtc, YB_MODULE, yspec1, &xerr)) < 0)
+        /* Bind template once per device yspec, shared yspecs are bound only once */
+        for (j=0; j<nbound; j++)
+            if (yspecs[j] == yspec1)
+                break;
+        if (j == nbound){
+            if ((ys1 = realloc(yspecs, (nbound+1)*sizeof(yang_stmt*))) == NULL){
+                clixon_err(OE_UNIX, errno, "realloc");
+                goto done;
+            }
+            yspecs = ys1;
+            if ((xb1 = realloc(xbound, (nbound+1)*sizeof(cxobj*))) == NULL){
+                clixon_err(OE_UNIX, errno, "realloc");
+                goto done;
+            }
+            xbound = xb1;
+            if ((r1 = realloc(reasons, (nbound+1)*sizeof(char*))) == NULL){
+                clixon_err(OE_UNIX, errno, "realloc");
+                goto done;
+            }
+            reasons = r1;
+            if ((xtc = xml_dup(tc->tc_xtmpl)) == NULL)
+                goto done;
+            yspecs[nbound] = yspec1;
+            xbound[nbound] = xtc;
+            reasons[nbound++] = NULL;
+            if ((ret = xml_bind_yang(h, xtc, YB_MODULE, yspec1, &xerr)) < 0)
+                goto done;
+            if (ret == 0){
+                xml_free(xtc);
+                xbound[j] = NULL;
+                reason = NULL;
+                if (xerr && (x = xpath_first(xerr, NULL, "//error-message")) != NULL)
+                    reason = xml_body(x);
+                if ((reasons[j] = strdup(reason?reason:"YANG bind failed")) == NULL){
+                    clixon_err(OE_UNIX, errno, "strdup");
+                    goto done;
+                }
+                if (xerr){
+                    xml_free(xerr);
+                    xerr = NULL;
+                }
+            }
+            else if (xml_sort_recurse(xtc) < 0)
+                goto done;
+        }
+        if (xbound[j] == NULL){
+            clixon_log(h, LOG_NOTICE, "%s: Template %s not applied on %s: %s",
+                       __FUNCTION__, tmplname, devname, reasons[j]);
+            cprintf(cbfail, "<failed xmlns=\"%s\">", CONTROLLER_NAMESPACE);
+            cprintf(cbfail, "<device>");
+            xml_chardata_cbuf_append(cbfail, devname);
+            cprintf(cbfail, "</device>");
+            cprintf(cbfail, "<reason>");
+            xml_chardata_cbuf_append(cbfail, reasons[j]);
+            cprintf(cbfail, "</reason>");
+            cprintf(cbfail, "</failed>");
+            continue;
+        }
+        /* Add device mount-point to merge tree */
+        if (device_state_mount_point_get(devname, yspec0, &xroot, &xmnt) < 0)
             goto done;
-        if (ret == 0){
-            if (clixon_xml2cbuf(cbret, xerr, 0, 0, NULL, -1, 0) < 0)
+        if (xtop == NULL){
+            xtop = xroot;
+            if ((xdevs = xml_find_type(xtop, NULL, "devices", CX_ELMNT)) == NULL){
+                clixon_err(OE_XML, 0, "devices not found");
                 goto done;
-            goto ok;
+            }
+        }
+        else {
+            if ((x = xpath_first(xroot, NULL, "devices/device")) == NULL){
+                clixon_err(OE_XML, 0, "device not found");
+                goto done;
+            }
+            if (xml_addsub(xdevs, x) < 0)
+                goto done;
+            xml_free(xroot);
         }
+        xroot = NULL;
+        if ((xtc = xml_dup(xbound[j])) == NULL)
+            goto done;
         while ((x = xml_child_i_type(xtc, 0, CX_ELMNT)) != NULL) {
             if (xml_addsub(xmnt, x) < 0)
                 goto done;
         }
-        if ((ret = xmldb_put(h, "candidate", OP_MERGE, xroot, NULL, cbret)) < 0)
+        xml_free(xtc);
+        matching++;
+    }
+    /* Single write of all devices */
+    if (xtop){
+        if ((ret = xmldb_put(h, "candidate", OP_MERGE, xtop, NULL, cbret)) < 0)
             goto done;
         if (ret == 0)
             goto ok;
-        xml_rm(xroot);
-        matching++;
     }
+    clixon_debug(CLIXON_DBG_DEFAULT, "%s applied on %d devices", __FUNCTION__, matching);
     cprintf(cbret, "<rpc-reply xmlns=\"%s\">", NETCONF_BASE_NAMESPACE);
-    cprintf(cbret, "<ok/>");
+    if (cbuf_len(cbfail))
+        cprintf(cbret, "%s", cbuf_get(cbfail));
+    else
+        cprintf(cbret, "<ok/>");
     cprintf(cbret, "</rpc-reply>");
  ok:
     retval = 0;
  done:
-    if (cb)
-        cbuf_free(cb);
+    if (xbound){
+        for (j=0; j<nbound; j++)
+            if (xbound[j])
+                xml_free(xbound[j]);
+        free(xbound);
+    }
+    if (reasons){
+        for (j=0; j<nbound; j++)
+            if (reasons[j])
+                free(reasons[j]);
+        free(reasons);
+    }
+    if (yspecs)
+        free(yspecs);
+    if (xroot)
+        xml_free(xroot);
+    if (xtop)
+        xml_free(xtop);
+    if (cbfail)
+        cbuf_free(cbfail);
     if (xret)
         xml_free(xret);
     if (xerr)
         xml_free(xerr);
-    if (xput)
-        xml_free(xput);
     if (vec)
         free(vec);
     return retval;
@@ -2561,94 +4188,265 @@ attr_ns_value(cxobj *x,
     goto done;
 }
 
-/*! Callback function type for xml_apply
+/*! Creator attribute processing context, built once per edit-config
  *
- * @param[in]  x    XML node
- * @param[in]  arg  General-purpose argument
- * @retval     2    Locally abort this subtree, continue with others
- * @retval     1    Abort, dont continue with others, return 1 to end user
- * @retval     0    OK, continue
- * @retval    -1    Error, aborted at first error encounter, return -1 to end user
+ * @see creator_applyfn
+ */
+struct creator_ctx {
+    cxobj         *cc_xserv;   /* Services tree where created paths are added */
+    clicon_hash_t *cc_created; /* Creator tag -> created container in cc_xserv */
+    cxobj         *cc_xparent; /* Parent of last creator-tagged node */
+    char          *cc_prefix;  /* Xpath of cc_xparent, reused for siblings, or NULL */
+    cbuf          *cc_cb;      /* Scratch buffer */
+};
+
+/*! Find or create created container of service instance given creator tag
+ *
+ * Creator tag is on the form: service[key='instance']
+ * Created containers are cached per creator tag. Tree is built and yang-bound directly
+ * @param[in]  cc       Creator context
+ * @param[in]  creator  Creator tag
+ * @param[out] xcp      Created container
+ * @retval     1        OK, xcp set
+ * @retval     0        Creator is not a service instance, skip
+ * @retval    -1        Error
  */
 static int
-creator_applyfn(cxobj *x,
-                void  *arg)
+creator_created(struct creator_ctx *cc,
+                char               *creator,
+                cxobj             **xcp)
 {
     int        retval = -1;
-    cxobj     *xserv = (cxobj*)arg;
-    char      *creator = NULL;
-    cvec      *nsc = 0;
-    char      *xpath = NULL;
+    void      *v;
+    size_t     vlen;
+    cxobj     *xserv = cc->cc_xserv;
     cxobj     *xi;
+    cxobj     *xk;
     cxobj     *xc;
+    char      *service = NULL;
     char      *instance;
     char      *p;
     char       q;
-    yang_stmt *yserv;
     yang_stmt *yi;
+    yang_stmt *yk;
+    yang_stmt *yc;
     char      *ns;
     cvec      *cvk;
     char      *key;
-    int        ret;
 
-    /* Special clixon-lib attribute for keeping track of creator of objects */
-    if ((ret = attr_ns_value(x, "creator", CLIXON_LIB_NS, &creator)) < 0)
+    if ((v = clicon_hash_value(cc->cc_created, creator, &vlen)) != NULL){
+        *xcp = *(cxobj**)v;
+        goto ok;
+    }
+    /* split creator into service and name, assuming creator is on the form:
+     * service[name='myname']
+     */
+    if ((service = strdup(creator)) == NULL){
+        clixon_err(OE_UNIX, errno, "strdup");
         goto done;
-    if (ret == 0)
-        goto fail;
-    if (creator != NULL){
-        if (xml2xpath(x, nsc, 0, 0, &xpath) < 0)
-            goto done;
-        /* Find existing entry in xserv, if not found create it */
-        if ((xi = xpath_first(xserv, NULL, "%s", creator)) != NULL){
-            if ((xc = xml_find_type(xi, NULL, "created", CX_ELMNT)) == NULL)
-                goto ok;
-            if ((ret = clixon_xml_parse_va(YB_PARENT, NULL, &xc, NULL, "<path>%s</path>", xpath)) < 0)
+    }
+    if ((p = index(service, '[')) == NULL)
+        goto skip;
+    *p++ = '\0';
+    if ((p = index(p, '=')) == NULL)
+        goto skip;
+    p++;
+    q = *p++; /* assume quote */
+    instance = p;
+    if ((p = index(p, q)) == NULL)
+        goto skip;
+    *p = '\0';
+    if ((yi = yang_find(xml_spec(xserv), Y_LIST, service)) == NULL)
+        goto skip;
+    if ((cvk = yang_cvec_get(yi)) == NULL)
+        goto skip;
+    if ((key = cvec_i_str(cvk, 0)) == NULL)
+        goto skip;
+    if ((ns = yang_find_mynamespace(yi)) == NULL)
+        goto skip;
+    if ((yk = yang_find(yi, Y_LEAF, key)) == NULL)
+        goto skip;
+    if ((yc = yang_find(yi, Y_CONTAINER, "created")) == NULL)
+        goto skip;
+    /* <service xmlns="ns"><key>instance</key><created nc:operation="merge"/></service> */
+    if ((xi = xml_new(service, xserv, CX_ELMNT)) == NULL)
+        goto done;
+    xml_spec_set(xi, yi);
+    if (xmlns_set(xi, NULL, ns) < 0)
+        goto done;
+    if ((xk = xml_new_body(key, xi, instance)) == NULL)
+        goto done;
+    xml_spec_set(xk, yk);
+    if ((xc = xml_new("created", xi, CX_ELMNT)) == NULL)
+        goto done;
+    xml_spec_set(xc, yc);
+    if (xml_add_attr(xc, "operation", "merge", NETCONF_BASE_PREFIX, NULL) == NULL)
+        goto done;
+    if (clicon_hash_add(cc->cc_created, creator, &xc, sizeof(xc)) == NULL)
+        goto done;
+    *xcp = xc;
+ ok:
+    retval = 1;
+ done:
+    if (service)
+        free(service);
+    return retval;
+ skip:
+    retval = 0;
+    goto done;
+}
+
+/*! Append xpath segment of node to buffer, on the form /name[key='value'] of xml2xpath
+ *
+ * @param[in]  x    XML node
+ * @param[out] cb   Buffer
+ * @retval     1    OK
+ * @retval     0    Key value with quote, use xml2xpath
+ */
+static int
+creator_xpath_segment(cxobj *x,
+                      cbuf  *cb)
+{
+    yang_stmt *y;
+    cvec      *cvk;
+    cg_var    *cvi;
+    char      *keyname;
+    char      *body;
+
+    cprintf(cb, "/");
+    if (xml_prefix(x))
+        cprintf(cb, "%s:", xml_prefix(x));
+    cprintf(cb, "%s", xml_name(x));
+    if ((y = xml_spec(x)) == NULL)
+        return 1;
+    switch (yang_keyword_get(y)){
+    case Y_LIST:
+        cvk = yang_cvec_get(y);
+        cvi = NULL;
+        while ((cvi = cvec_each(cvk, cvi)) != NULL){
+            keyname = cv_string_get(cvi);
+            body = xml_find_body(x, keyname);
+            if (body && index(body, '\'') != NULL)
+                return 0;
+            if (xml_prefix(x))
+                cprintf(cb, "[%s:%s='%s']", xml_prefix(x), keyname, body?body:"");
+            else
+                cprintf(cb, "[%s='%s']", keyname, body?body:"");
+        }
+        break;
+    case Y_LEAF_LIST:
+        body = xml_body(x);
+        if (body && index(body, '\'') != NULL)
+            return 0;
+        cprintf(cb, "[.='%s']", body?body:"");
+        break;
+    default:
+        break;
+    }
+    return 1;
+}
+
+/*! Get xpath of creator-tagged node, reusing xpath of parent across siblings
+ *
+ * The first tagged child of a parent gets its xpath from xml2xpath. If its last segment
+ * matches creator_xpath_segment, the parent prefix is saved and used for following siblings.
+ * @param[in]  cc      Creator context
+ * @param[in]  x       XML node
+ * @param[out] xpathp  Xpath, free with free()
+ * @retval     0       OK
+ * @retval    -1       Error
+ */
+static int
+creator_xpath(struct creator_ctx *cc,
+              cxobj              *x,
+              char              **xpathp)
+{
+    int     retval = -1;
+    cbuf   *cb = cc->cc_cb;
+    char   *xpath = NULL;
+    size_t  len;
+    size_t  seglen;
+
+    cbuf_reset(cb);
+    if (cc->cc_prefix && cc->cc_xparent == xml_parent(x)){
+        cprintf(cb, "%s", cc->cc_prefix);
+        if (creator_xpath_segment(x, cb) == 1){
+            if ((xpath = strdup(cbuf_get(cb))) == NULL){
+                clixon_err(OE_UNIX, errno, "strdup");
                 goto done;
-            if (ret == 0)
-                goto ok;
+            }
         }
-        else {
-            /* split creator into service and name, assuming creator is on the form:
-             * service[name='myname']
-             */
-            if ((p = index(creator, '[')) == NULL)
-                goto ok;
-            *p++ = '\0';
-            if ((p = index(p, '=')) == NULL)
-                goto ok;
-            p++;
-            q = *p++; /* assume quote */
-            instance = p;
-            if ((p = index(p, q)) == NULL)
-                goto ok;
-            *p = '\0';
-            yserv = xml_spec(xserv);
-            if ((yi = yang_find(yserv, Y_LIST, creator)) == NULL)
-                goto ok;
-            if ((cvk = yang_cvec_get(yi)) == NULL)
-                goto ok;
-            if ((key = cvec_i_str(cvk, 0)) == NULL)
-                goto ok;
-            if ((ns = yang_find_mynamespace(yi)) == NULL)
-                goto ok;
-            if ((ret = clixon_xml_parse_va(YB_PARENT, NULL, &xserv, NULL,
-                                           "<%s xmlns=\"%s\"><%s>%s</%s>"
-                                           "<created nc:operation=\"merge\">"
-                                           "<path>%s</path></created></%s>",
-                                           creator,
-                                           ns,
-                                           key,
-                                           instance,
-                                           key,
-                                           xpath,
-                                           creator)) < 0)
-                goto done;
-            if (ret == 0)
-                goto ok;
+        else if (xml2xpath(x, NULL, 0, 0, &xpath) < 0)
+            goto done;
+    }
+    else {
+        if (xml2xpath(x, NULL, 0, 0, &xpath) < 0)
+            goto done;
+        if (cc->cc_prefix){
+            free(cc->cc_prefix);
+            cc->cc_prefix = NULL;
+        }
+        cc->cc_xparent = xml_parent(x);
+        len = strlen(xpath);
+        if (creator_xpath_segment(x, cb) == 1 &&
+            len > (seglen = cbuf_len(cb)) &&
+            strcmp(xpath + len - seglen, cbuf_get(cb)) == 0){
+            if ((cc->cc_prefix = strndup(xpath, len - seglen)) == NULL){
+                clixon_err(OE_UNIX, errno, "strndup");
+                goto done;
+            }
         }
     }
-    ok:
+    *xpathp = xpath;
+    xpath = NULL;
+    retval = 0;
+ done:
+    if (xpath)
+        free(xpath);
+    return retval;
+}
+
+/*! Callback function type for xml_apply
+ *
+ * For each node with a creator attribute, add its xpath to services/<creator>/created
+ * @param[in]  x    XML node
+ * @param[in]  arg  Creator context
+ * @retval     2    Locally abort this subtree, continue with others
+ * @retval     1    Abort, dont continue with others, return 1 to end user
+ * @retval     0    OK, continue
+ * @retval    -1    Error, aborted at first error encounter, return -1 to end user
+ */
+static int
+creator_applyfn(cxobj *x,
+                void  *arg)
+{
+    int                 retval = -1;
+    struct creator_ctx *cc = (struct creator_ctx *)arg;
+    char               *creator = NULL;
+    char               *xpath = NULL;
+    cxobj              *xc;
+    cxobj              *xp;
+    yang_stmt          *yp;
+    int                 ret;
+
+    /* Special clixon-lib attribute for keeping track of creator of objects */
+    if ((ret = attr_ns_value(x, "creator", CLIXON_LIB_NS, &creator)) < 0)
+        goto done;
+    if (ret == 0)
+        goto fail;
+    if (creator == NULL)
+        goto ok;
+    if ((ret = creator_created(cc, creator, &xc)) < 0)
+        goto done;
+    if (ret == 0)
+        goto ok;
+    if (creator_xpath(cc, x, &xpath) < 0)
+        goto done;
+    if ((xp = xml_new_body("path", xc, xpath)) == NULL)
+        goto done;
+    if ((yp = yang_find(xml_spec(xc), Y_LEAF_LIST, "path")) != NULL)
+        xml_spec_set(xp, yp);
+ ok:
     retval = 0;
  done:
     if (creator)
@@ -2690,6 +4488,7 @@ controller_edit_config(clixon_handle h,
     cxobj     *xconfig = NULL;
     cxobj     *xserv;
     int        ret;
+    struct creator_ctx cc = {0,};
 
     clixon_debug(CLIXON_DBG_DEFAULT, "controller edit-config wrapper");
     if ((yspec =  clicon_dbspec_yang(h)) == NULL){
@@ -2727,7 +4526,14 @@ controller_edit_config(clixon_handle h,
         goto ok;
     if (xml_spec(xserv) == NULL)
         goto ok;
-    if ((ret = xml_apply(xc, CX_ELMNT, creator_applyfn, xserv)) < 0)
+    cc.cc_xserv = xserv;
+    if ((cc.cc_created = clicon_hash_init()) == NULL)
+        goto done;
+    if ((cc.cc_cb = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    if ((ret = xml_apply(xc, CX_ELMNT, creator_applyfn, &cc)) < 0)
         goto done;
     if (ret == 1)
         goto ok;
@@ -2742,6 +4548,12 @@ controller_edit_config(clixon_handle h,
  ok:
     retval = 0;
  done:
+    if (cc.cc_created)
+        clicon_hash_free(cc.cc_created);
+    if (cc.cc_prefix)
+        free(cc.cc_prefix);
+    if (cc.cc_cb)
+        cbuf_free(cc.cc_cb);
     if (xconfig)
         xml_free(xconfig);
     return retval;
@@ -2778,12 +4590,24 @@ controller_rpc_init(clixon_handle h)
                               "get-device-config"
                               ) < 0)
         goto done;
+    if (rpc_callback_register(h, rpc_get_device_yang_library,
+                              NULL,
+                              CONTROLLER_NAMESPACE,
+                              "get-device-yang-library"
+                              ) < 0)
+        goto done;
     if (rpc_callback_register(h, rpc_transaction_error,
                               NULL,
                               CONTROLLER_NAMESPACE,
                               "transaction-error"
                               ) < 0)
         goto done;
+    if (rpc_callback_register(h, rpc_transaction_trace,
+                              NULL,
+                              CONTROLLER_NAMESPACE,
+                              "transaction-trace"
+                              ) < 0)
+        goto done;
     if (rpc_callback_register(h, rpc_transactions_actions_done,
                               NULL,
                               CONTROLLER_NAMESPACE,
@@ -50,7 +50,16 @@ extern "C" {
 #endif
 
 int controller_device_apply(clixon_handle h, cxobj *xe, cbuf *cbret, void *arg, void *regarg);
+int controller_device_reconnect(clixon_handle h, cvec *devnames);
+int controller_created_index_commit(clixon_handle h, cvec *nsc, cxobj *src, cxobj *target);
+int controller_created_index_end(clixon_handle h);
+int controller_created_index_abort(clixon_handle h);
+int controller_created_index_init(clixon_handle h);
+int controller_created_index_free(clixon_handle h);
+int controller_template_commit(clixon_handle h, cvec *nsc, cxobj *src, cxobj *target);
+int controller_template_free(clixon_handle h);
 int controller_rpc_init(clixon_handle h);
+int actions_timeout_unregister(controller_transaction *ct);
 
 #ifdef __cplusplus
 }
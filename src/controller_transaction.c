@@ -61,6 +61,11 @@
   * 1. In rpc_config_pull
   * 2. In rpc_controller_commit
   * 3. In rpc_connection_change
+  *
+  * Ongoing and queued transactions are kept in "controller-transaction-list" in creation
+  * order. When done, a transaction is moved to "controller-transaction-history" which is
+  * bounded by transaction-history-max and transaction-history-age.
+  * All transactions are indexed by id in "controller-transaction-index".
  */
 
 #include <stdio.h>
@@ -75,6 +80,7 @@
 #include <fcntl.h>
 #include <fnmatch.h>
 #include <assert.h>
+#include <ctype.h>
 #include <sys/time.h>
 
 /* clicon */
@@ -93,9 +99,11 @@
 #include "controller_device_send.h"
 #include "controller_device_handle.h"
 #include "controller_transaction.h"
+#include "controller_rpc.h"
 
 /*! Set new transaction state and timestamp
  *
+ * The state left is added as a span to the transaction trace
  * @param[in]  ct     Transaction
  * @param[in]  state  New state
  * @param[in]  result New result (-1 is dont care, dont set)
@@ -106,6 +114,8 @@ controller_transaction_state_set(controller_transaction *ct,
                                  transaction_state       state,
                                  transaction_result      result)
 {
+    struct timeval now;
+
     switch (state) {
     case TS_INIT:
         assert(ct->ct_state != TS_DONE);
@@ -138,6 +148,12 @@ controller_transaction_state_set(controller_transaction *ct,
                      transaction_state_int2str(state),
                      transaction_result_int2str(result));
         break;
+    case TS_QUEUED:
+        clixon_debug(CLIXON_DBG_DEFAULT, "%s %" PRIu64 " : -> %s",
+                     __FUNCTION__,
+                     ct->ct_id,
+                     transaction_state_int2str(state));
+        break;
     case TS_DONE:
         assert(state != ct->ct_state);
         if (result != -1 && result != ct->ct_result)
@@ -154,11 +170,232 @@ controller_transaction_state_set(controller_transaction *ct,
                          transaction_state_int2str(ct->ct_state),
                          transaction_state_int2str(state));
     }
+    gettimeofday(&now, NULL);
+    /* Trace span of the state left */
+    if (state != ct->ct_state && ct->ct_timestamp.tv_sec != 0)
+        controller_transaction_trace(ct, NULL, transaction_state_int2str(ct->ct_state),
+                                     &ct->ct_timestamp, &now);
     ct->ct_state = state;
     if (result != -1 &&
         (state == TS_RESOLVED || state == TS_DONE))
         ct->ct_result = result;
-    gettimeofday(&ct->ct_timestamp, NULL);
+    ct->ct_timestamp = now;
+    return 0;
+}
+
+/*! Get trace thread of transaction phases or of a device, add it if not found
+ *
+ * @param[in]  ct     Transaction
+ * @param[in]  device Device name, or NULL for the transaction phases
+ * @param[out] thread Index in ct_trace_threads
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+static int
+controller_transaction_trace_thread(controller_transaction *ct,
+                                    const char             *device,
+                                    uint32_t               *thread)
+{
+    struct controller_trace_thread_t *tt;
+    void                             *p;
+    size_t                            vlen;
+    uint32_t                          n;
+
+    if (ct->ct_trace_threads != NULL){
+        if (device == NULL){
+            *thread = 0;
+            return 0;
+        }
+        if ((p = clicon_hash_value(ct->ct_trace_index, (char*)device, &vlen)) != NULL){
+            *thread = *(uint32_t*)p;
+            return 0;
+        }
+    }
+    else if ((ct->ct_trace_index = clicon_hash_init()) == NULL)
+        return -1;
+    /* Thread 0 is the transaction phases */
+    n = ct->ct_trace_nthreads ? ct->ct_trace_nthreads+1 : (device ? 2 : 1);
+    if ((tt = realloc(ct->ct_trace_threads, n*sizeof(*tt))) == NULL){
+        clixon_err(OE_UNIX, errno, "realloc");
+        return -1;
+    }
+    memset(&tt[ct->ct_trace_nthreads], 0, (n-ct->ct_trace_nthreads)*sizeof(*tt));
+    ct->ct_trace_threads = tt;
+    ct->ct_trace_nthreads = n;
+    *thread = 0;
+    if (device){
+        *thread = n-1;
+        if ((tt[n-1].tt_device = strdup(device)) == NULL){
+            clixon_err(OE_UNIX, errno, "strdup");
+            return -1;
+        }
+        if (clicon_hash_add(ct->ct_trace_index, (char*)device, thread, sizeof(*thread)) == NULL)
+            return -1;
+    }
+    return 0;
+}
+
+/*! Add a timestamped span to the trace of a transaction
+ *
+ * Only if transaction-trace is set. At most CONTROLLER_TRACE_THREAD_MAX spans are recorded
+ * per device and for the transaction phases, so the trace is bounded by the number of
+ * devices. Further spans are counted as dropped.
+ * @param[in]  ct     Transaction
+ * @param[in]  device Device name, or NULL for a transaction phase
+ * @param[in]  name   Name of phase or state, must be a static string
+ * @param[in]  start  Start of span
+ * @param[in]  end    End of span, or NULL for now
+ * @retval     0      OK
+ * @retval    -1      Error
+ * @see controller_transaction_trace2json
+ * @see controller_transaction_trace_end  Recording ends when the transaction is done
+ */
+int
+controller_transaction_trace(controller_transaction *ct,
+                             const char             *device,
+                             const char             *name,
+                             struct timeval         *start,
+                             struct timeval         *end)
+{
+    struct controller_trace_t        *tr;
+    struct controller_trace_thread_t *tt;
+    uint32_t                          size;
+    uint32_t                          thread;
+
+    if (name == NULL || ct->ct_state == TS_DONE)
+        return 0;
+    if (clicon_data_int_get(ct->ct_h, "controller-transaction-trace") != 1)
+        return 0;
+    if (controller_transaction_trace_thread(ct, device, &thread) < 0)
+        return -1;
+    tt = &ct->ct_trace_threads[thread];
+    if (tt->tt_spans >= CONTROLLER_TRACE_THREAD_MAX){
+        tt->tt_dropped++;
+        return 0;
+    }
+    if (ct->ct_trace_len >= ct->ct_trace_size){
+        size = ct->ct_trace_size ? ct->ct_trace_size*2 : 16;
+        if ((tr = realloc(ct->ct_trace, size*sizeof(*tr))) == NULL){
+            clixon_err(OE_UNIX, errno, "realloc");
+            return -1;
+        }
+        ct->ct_trace = tr;
+        ct->ct_trace_size = size;
+    }
+    tr = &ct->ct_trace[ct->ct_trace_len];
+    tr->tr_name = name;
+    tr->tr_thread = thread;
+    tr->tr_start = *start;
+    if (end)
+        tr->tr_end = *end;
+    else
+        gettimeofday(&tr->tr_end, NULL);
+    ct->ct_trace_len++;
+    tt->tt_spans++;
+    return 0;
+}
+
+/*! End recording of the trace of a transaction, when it is done and moved to history
+ *
+ * Free the device index and shrink the spans to their number
+ * @param[in]  ct     Transaction
+ */
+static void
+controller_transaction_trace_end(controller_transaction *ct)
+{
+    struct controller_trace_t *tr;
+
+    if (ct->ct_trace_index){
+        clicon_hash_free(ct->ct_trace_index);
+        ct->ct_trace_index = NULL;
+    }
+    if (ct->ct_trace_len < ct->ct_trace_size && ct->ct_trace_len > 0 &&
+        (tr = realloc(ct->ct_trace, ct->ct_trace_len*sizeof(*tr))) != NULL){
+        ct->ct_trace = tr;
+        ct->ct_trace_size = ct->ct_trace_len;
+    }
+}
+
+/*! Append JSON string with escapes
+ */
+static void
+trace_json_str(cbuf       *cb,
+               const char *str)
+{
+    const char *s;
+
+    cprintf(cb, "\"");
+    for (s = str; *s; s++){
+        if (*s == '"' || *s == '\\')
+            cprintf(cb, "\\%c", *s);
+        else if ((unsigned char)*s < 0x20)
+            cprintf(cb, "\\u%04x", *s);
+        else
+            cprintf(cb, "%c", *s);
+    }
+    cprintf(cb, "\"");
+}
+
+/*! Print trace of a transaction as Chrome trace-event JSON
+ *
+ * Spans are complete ("X") events with microsecond timestamps. The transaction is a
+ * process with transaction phases as thread 0 and each device as its own thread.
+ * The output can be viewed in Perfetto or chrome://tracing
+ * @param[in]  ct     Transaction
+ * @param[out] cb     JSON output
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+int
+controller_transaction_trace2json(controller_transaction *ct,
+                                  cbuf                   *cb)
+{
+    struct controller_trace_t        *tr;
+    struct controller_trace_thread_t *tt;
+    struct timeval                    dur;
+    uint32_t                          i;
+    uint32_t                          dropped = 0;
+
+    cprintf(cb, "{\"traceEvents\":[");
+    cprintf(cb, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%" PRIu64 ",\"args\":{\"name\":",
+            ct->ct_id);
+    trace_json_str(cb, ct->ct_description ? ct->ct_description : "transaction");
+    cprintf(cb, "}},");
+    cprintf(cb, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%" PRIu64 ",\"tid\":0,"
+            "\"args\":{\"name\":\"transaction\"}}", ct->ct_id);
+    for (i=0; i<ct->ct_trace_nthreads; i++){
+        tt = &ct->ct_trace_threads[i];
+        if (tt->tt_device){
+            cprintf(cb, ",{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%" PRIu64 ",\"tid\":%u,"
+                    "\"args\":{\"name\":", ct->ct_id, i);
+            trace_json_str(cb, tt->tt_device);
+            cprintf(cb, "}}");
+        }
+        /* Truncated thread: instant event with number of dropped spans */
+        if (tt->tt_dropped){
+            cprintf(cb, ",{\"name\":\"truncated\",\"ph\":\"i\",\"s\":\"t\",\"ts\":%" PRIu64
+                    ",\"pid\":%" PRIu64 ",\"tid\":%u,\"args\":{\"dropped\":%u}}",
+                    (uint64_t)ct->ct_timestamp.tv_sec*1000000 + ct->ct_timestamp.tv_usec,
+                    ct->ct_id, i, tt->tt_dropped);
+            dropped += tt->tt_dropped;
+        }
+    }
+    for (i=0; i<ct->ct_trace_len; i++){
+        tr = &ct->ct_trace[i];
+        timersub(&tr->tr_end, &tr->tr_start, &dur);
+        cprintf(cb, ",{\"name\":");
+        trace_json_str(cb, tr->tr_name);
+        cprintf(cb, ",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%" PRIu64 ",\"dur\":%" PRIu64
+                ",\"pid\":%" PRIu64 ",\"tid\":%u}",
+                tr->tr_thread ? "device" : "transaction",
+                (uint64_t)tr->tr_start.tv_sec*1000000 + tr->tr_start.tv_usec,
+                (uint64_t)dur.tv_sec*1000000 + dur.tv_usec,
+                ct->ct_id, tr->tr_thread);
+    }
+    cprintf(cb, "],\"displayTimeUnit\":\"ms\"");
+    if (dropped)
+        cprintf(cb, ",\"otherData\":{\"truncated\":\"true\",\"dropped\":\"%u\"}", dropped);
+    cprintf(cb, "}");
     return 0;
 }
 
@@ -237,6 +474,50 @@ transaction_new_id(clixon_handle h,
     return retval;
 }
 
+/*! Add transaction to id index
+ *
+ * @param[in]  h   Clixon handle
+ * @param[in]  ct  Transaction
+ * @retval     0   OK
+ * @retval    -1   Error
+ */
+static int
+transaction_index_add(clixon_handle           h,
+                      controller_transaction *ct)
+{
+    clicon_hash_t *index = NULL;
+    char           idstr[32];
+
+    if (clicon_ptr_get(h, "controller-transaction-index", (void**)&index) < 0 || index == NULL){
+        if ((index = clicon_hash_init()) == NULL)
+            return -1;
+        clicon_ptr_set(h, "controller-transaction-index", (void*)index);
+    }
+    snprintf(idstr, sizeof(idstr), "%" PRIu64, ct->ct_id);
+    if (clicon_hash_add(index, idstr, &ct, sizeof(ct)) == NULL)
+        return -1;
+    return 0;
+}
+
+/*! Remove transaction from id index
+ *
+ * @param[in]  h   Clixon handle
+ * @param[in]  ct  Transaction
+ */
+static int
+transaction_index_del(clixon_handle           h,
+                      controller_transaction *ct)
+{
+    clicon_hash_t *index = NULL;
+    char           idstr[32];
+
+    if (clicon_ptr_get(h, "controller-transaction-index", (void**)&index) == 0 && index != NULL){
+        snprintf(idstr, sizeof(idstr), "%" PRIu64, ct->ct_id);
+        clicon_hash_del(index, idstr);
+    }
+    return 0;
+}
+
 /*! Create a new controller-transaction, with a new id and locl candidate
  *
  * Failure to create a transaction include:
@@ -265,6 +546,8 @@ controller_transaction_new(clixon_handle            h,
     size_t                  sz;
     uint32_t                iddb;
     char                   *db = "candidate";
+    int                     indexed = 0;
+    int                     locked = 0;
 
     if (ctp == NULL){
         clixon_err(OE_PLUGIN, EINVAL, "ctp is NULL");
@@ -305,6 +588,7 @@ controller_transaction_new(clixon_handle            h,
     }
     memset(ct, 0, sz);
     ct->ct_h = h;
+    gettimeofday(&ct->ct_timestamp, NULL);
     if (transaction_new_id(h, &ct->ct_id) < 0)
         goto done;
     if (description &&
@@ -312,11 +596,15 @@ controller_transaction_new(clixon_handle            h,
         clixon_err(OE_UNIX, errno, "strdup");
         goto done;
     }
+    if (transaction_index_add(h, ct) < 0)
+        goto done;
+    indexed = 1;
     (void)clicon_ptr_get(h, "controller-transaction-list", (void**)&ct_list);
     ADDQ(ct, ct_list);
     clicon_ptr_set(h, "controller-transaction-list", (void*)ct_list);
     if (xmldb_lock(h, db, TRANSACTION_CLIENT_ID) < 0)
         goto done;
+    locked = 1;
      /* user callback */
     if (clixon_plugin_lockdb_all(h, db, 1, TRANSACTION_CLIENT_ID) < 0)
         goto done;
@@ -324,19 +612,423 @@ controller_transaction_new(clixon_handle            h,
     ct = NULL;
     retval = 1;
  done:
-    if (ct)
+    if (ct){
+        if (locked)
+            xmldb_unlock(h, db);
+        if (indexed){ /* Also in list */
+            transaction_index_del(h, ct);
+            (void)clicon_ptr_get(h, "controller-transaction-list", (void**)&ct_list);
+            DELQ(ct, ct_list, controller_transaction *);
+            clicon_ptr_set(h, "controller-transaction-list", (void*)ct_list);
+        }
+        if (ct->ct_description)
+            free(ct->ct_description);
         free(ct);
+    }
     return retval;
  failed:
     retval = 0;
     goto done;
 }
 
+/*! Check if a new transaction request is queued, ie another transaction is ongoing
+ *
+ * @param[in]   h      Clixon handle
+ * @retval      1      Yes, a new request is queued
+ * @retval      0      No, a new request is started directly
+ * @see controller_transaction_new_queue
+ */
+int
+controller_transaction_queued(clixon_handle h)
+{
+    controller_transaction *ct_list = NULL;
+    controller_transaction *ct;
+
+    if (clicon_ptr_get(h, "controller-transaction-list", (void**)&ct_list) == 0 &&
+        (ct = ct_list) != NULL) {
+        do {
+            if (ct->ct_state != TS_DONE)
+                return 1;
+            ct = NEXTQ(controller_transaction *, ct);
+        } while (ct && ct != ct_list);
+    }
+    return 0;
+}
+
+/*! Create a new controller-transaction, or queue it if another transaction is ongoing
+ *
+ * If no transaction is ongoing or queued, this is the same as controller_transaction_new.
+ * Otherwise the request is put last in the commit queue, bounded by transaction-queue-depth,
+ * and started by fn when all earlier transactions have terminated.
+ * If the last queued transaction is an identical request, including the selected devices,
+ * the new request is merged into that transaction, which is then returned. Requests of
+ * different clients are merged: the controller-transaction notification of the merged
+ * transaction is sent to all subscribers, and each client waits for the returned tid.
+ * @param[in]   h           Clixon handle
+ * @param[in]   description Description of transaction
+ * @param[in]   xe          RPC request, copied if queued
+ * @param[in]   client_id   Client id of originator
+ * @param[in]   fn          Start function called with xe when transaction is dequeued
+ * @param[out]  ct          Transaction struct (if retval = 1 or 2)
+ * @param[out]  cberr       Reason for failure. Freed by caller
+ * @retval      2           Queued (or merged with last queued)
+ * @retval      1           OK, new active transaction
+ * @retval      0           Failed
+ * @retval     -1           Error
+ * @see controller_transaction_activate  Activate a dequeued transaction
+ */
+int
+controller_transaction_new_queue(clixon_handle                    h,
+                                 char                            *description,
+                                 cxobj                           *xe,
+                                 uint32_t                         client_id,
+                                 controller_transaction_start_fn *fn,
+                                 controller_transaction         **ctp,
+                                 cbuf                           **cberr)
+{
+    int                     retval = -1;
+    controller_transaction *ct_list = NULL;
+    controller_transaction *ct = NULL;
+    controller_transaction *ctpending = NULL;
+    controller_transaction *ctlast = NULL;
+    int                     queued = 0;
+    int                     depth;
+    size_t                  sz;
+
+    if (ctp == NULL){
+        clixon_err(OE_PLUGIN, EINVAL, "ctp is NULL");
+        goto done;
+    }
+    if (clicon_ptr_get(h, "controller-transaction-list", (void**)&ct_list) == 0 &&
+        (ct = ct_list) != NULL) {
+        do {
+            if (ct->ct_state == TS_QUEUED){
+                queued++;
+                ctlast = ct;
+            }
+            if (ct->ct_state != TS_DONE && ctpending == NULL)
+                ctpending = ct;
+            ct = NEXTQ(controller_transaction *, ct);
+        } while (ct && ct != ct_list);
+        ct = NULL;
+    }
+    if (ctpending == NULL){
+        retval = controller_transaction_new(h, description, ctp, cberr);
+        goto done;
+    }
+    /* Merge with adjacent identical request: it will make the same device round trip */
+    if (ctlast != NULL &&
+        ctlast->ct_startfn == fn &&
+        ctlast->ct_xqueue != NULL &&
+        xml_tree_equal(ctlast->ct_xqueue, xe) == 0){
+        ctlast->ct_coalesced++;
+        clixon_debug(CLIXON_DBG_DEFAULT, "%s merged with queued %" PRIu64,
+                     __FUNCTION__, ctlast->ct_id);
+        *ctp = ctlast;
+        retval = 2;
+        goto done;
+    }
+    if ((depth = clicon_data_int_get(h, "controller-transaction-queue-depth")) < 0)
+        depth = CONTROLLER_TRANSACTION_QUEUE_DEPTH_DEFAULT;
+    if (queued >= depth){
+        if (cberr){
+            if ((*cberr = cbuf_new()) == NULL){
+                clixon_err(OE_UNIX, errno, "cbuf_new");
+                goto done;
+            }
+            if (depth == 0)
+                cprintf(*cberr, "Transaction %s is ongoing", ctpending->ct_description);
+            else
+                cprintf(*cberr, "Transaction queue is full (%d transactions)", queued);
+        }
+        goto failed;
+    }
+    sz = sizeof(controller_transaction);
+    if ((ct = malloc(sz)) == NULL){
+        clixon_err(OE_NETCONF, errno, "malloc");
+        goto done;
+    }
+    memset(ct, 0, sz);
+    ct->ct_h = h;
+    ct->ct_client_id = client_id;
+    if (transaction_new_id(h, &ct->ct_id) < 0)
+        goto done;
+    if (description &&
+        (ct->ct_description = strdup(description)) == NULL){
+        clixon_err(OE_UNIX, errno, "strdup");
+        goto done;
+    }
+    if ((ct->ct_xqueue = xml_dup(xe)) == NULL)
+        goto done;
+    ct->ct_startfn = fn;
+    controller_transaction_state_set(ct, TS_QUEUED, -1);
+    ct->ct_queued = ct->ct_timestamp;
+    if (transaction_index_add(h, ct) < 0)
+        goto done;
+    ADDQ(ct, ct_list);
+    clicon_ptr_set(h, "controller-transaction-list", (void*)ct_list);
+    *ctp = ct;
+    ct = NULL;
+    retval = 2;
+ done:
+    if (ct){
+        if (ct->ct_xqueue)
+            xml_free(ct->ct_xqueue);
+        if (ct->ct_description)
+            free(ct->ct_description);
+        free(ct);
+    }
+    return retval;
+ failed:
+    retval = 0;
+    goto done;
+}
+
+/*! Activate a queued transaction: lock candidate and enter INIT state
+ *
+ * @param[in]   h      Clixon handle
+ * @param[in]   ct     Queued transaction
+ * @param[out]  cberr  Reason for failure. Freed by caller
+ * @retval      1      OK
+ * @retval      0      Failed, transaction remains queued
+ * @retval     -1      Error
+ * @see controller_transaction_new_queue
+ */
+int
+controller_transaction_activate(clixon_handle           h,
+                                controller_transaction *ct,
+                                cbuf                  **cberr)
+{
+    int            retval = -1;
+    uint32_t       iddb;
+    char          *db = "candidate";
+    struct timeval tv;
+
+    clixon_debug(CLIXON_DBG_DEFAULT, "%s %" PRIu64, __FUNCTION__, ct->ct_id);
+    if (ct->ct_state != TS_QUEUED){
+        clixon_err(OE_CFG, EINVAL, "Transaction %" PRIu64 " is not queued", ct->ct_id);
+        goto done;
+    }
+    if ((iddb = xmldb_islocked(h, db)) != 0){
+        if (cberr){
+            if ((*cberr = cbuf_new()) == NULL){
+                clixon_err(OE_UNIX, errno, "cbuf_new");
+                goto done;
+            }
+            cprintf(*cberr, "Candidate db is locked by %u", iddb);
+        }
+        goto failed;
+    }
+    if (xmldb_lock(h, db, TRANSACTION_CLIENT_ID) < 0)
+        goto done;
+     /* user callback */
+    if (clixon_plugin_lockdb_all(h, db, 1, TRANSACTION_CLIENT_ID) < 0)
+        goto done;
+    gettimeofday(&tv, NULL);
+    timersub(&tv, &ct->ct_queued, &tv);
+    ct->ct_queue_wait = tv.tv_sec*1000 + tv.tv_usec/1000;
+    controller_transaction_state_set(ct, TS_INIT, -1);
+    retval = 1;
+ done:
+    return retval;
+ failed:
+    retval = 0;
+    goto done;
+}
+
+/*! Get first queued transaction, unless some other transaction is ongoing
+ *
+ * @param[in]  h   Clixon handle
+ * @retval     ct  First transaction in commit queue
+ * @retval     NULL No queued transaction, or a transaction is ongoing
+ */
+static controller_transaction *
+controller_transaction_queue_head(clixon_handle h)
+{
+    controller_transaction *ct_list = NULL;
+    controller_transaction *ct;
+    controller_transaction *cthead = NULL;
+
+    if (clicon_ptr_get(h, "controller-transaction-list", (void**)&ct_list) == 0 &&
+        (ct = ct_list) != NULL) {
+        do {
+            if (ct->ct_state == TS_QUEUED){
+                if (cthead == NULL)
+                    cthead = ct;
+            }
+            else if (ct->ct_state != TS_DONE)
+                return NULL;
+            ct = NEXTQ(controller_transaction *, ct);
+        } while (ct && ct != ct_list);
+    }
+    return cthead;
+}
+
+/*! Get error-message of an rpc-error reply, if any
+ *
+ * @param[in]  cbret   RPC reply
+ * @param[out] reason  Error message, malloced, free by caller (or NULL)
+ * @retval     0       OK
+ * @retval    -1       Error
+ */
+static int
+rpc_reply_error_message(cbuf  *cbret,
+                        char **reason)
+{
+    int    retval = -1;
+    cxobj *xt = NULL;
+    cxobj *x;
+    char  *b;
+
+    *reason = NULL;
+    if (cbuf_len(cbret) == 0)
+        goto ok;
+    if (clixon_xml_parse_string(cbuf_get(cbret), YB_NONE, NULL, &xt, NULL) < 0)
+        goto done;
+    if ((x = xpath_first(xt, NULL, "//error-message")) != NULL &&
+        (b = xml_body(x)) != NULL &&
+        (*reason = strdup(b)) == NULL){
+        clixon_err(OE_UNIX, errno, "strdup");
+        goto done;
+    }
+ ok:
+    retval = 0;
+ done:
+    if (xt)
+        xml_free(xt);
+    return retval;
+}
+
+/*! Start queued transactions, timeout callback
+ *
+ * Start transactions from the head of the commit queue as long as no transaction is ongoing.
+ * A queued transaction that fails before it is activated, eg due to failed validation,
+ * is terminated with the rpc-error as reason.
+ * An error in the start function fails the transaction, not the backend.
+ * Called as a timeout and not directly from controller_transaction_done to not start a new
+ * transaction in the context of the terminating one.
+ * @param[in] s     Socket (dummy)
+ * @param[in] arg   Clixon handle
+ * @retval    0     OK
+ * @retval   -1     Error
+ */
+static int
+controller_transaction_dequeue(int   s,
+                               void *arg)
+{
+    int                     retval = -1;
+    clixon_handle           h = (clixon_handle)arg;
+    controller_transaction *ct;
+    cxobj                  *xe = NULL;
+    cbuf                   *cbret = NULL;
+    char                   *reason = NULL;
+
+    clixon_debug(CLIXON_DBG_DEFAULT, "%s", __FUNCTION__);
+    if ((cbret = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    while ((ct = controller_transaction_queue_head(h)) != NULL){
+        xe = ct->ct_xqueue;
+        ct->ct_xqueue = NULL;
+        cbuf_reset(cbret);
+        if (ct->ct_startfn(h, xe, cbret, ct->ct_client_id, ct) < 0){
+            if ((reason = strdup(clixon_err_reason())) == NULL){
+                clixon_err(OE_UNIX, errno, "strdup");
+                goto done;
+            }
+            clixon_err_reset();
+            if (ct->ct_state != TS_QUEUED && ct->ct_state != TS_DONE &&
+                controller_transaction_nr_devices(h, ct->ct_id) != 0){
+                /* Devices are active: discard them and terminate when they are done */
+                if (controller_transaction_failed(h, ct->ct_id, ct, NULL, TR_FAILED_DEV_IGNORE,
+                                                  "controller", reason) < 0)
+                    goto done;
+            }
+            else if (ct->ct_state != TS_DONE){
+                if (ct->ct_reason == NULL){
+                    ct->ct_reason = reason;
+                    reason = NULL;
+                }
+                if (controller_transaction_done(h, ct, TR_FAILED) < 0)
+                    goto done;
+            }
+            if (reason){
+                free(reason);
+                reason = NULL;
+            }
+            xml_free(xe);
+            xe = NULL;
+            continue;
+        }
+        if (rpc_reply_error_message(cbret, &reason) < 0)
+            goto done;
+        if (reason && ct->ct_reason == NULL &&
+            (ct->ct_state == TS_QUEUED || ct->ct_result != TR_SUCCESS)){
+            ct->ct_reason = reason;
+            reason = NULL;
+        }
+        if (ct->ct_state == TS_QUEUED){ /* Not started */
+            if (controller_transaction_done(h, ct, TR_FAILED) < 0)
+                goto done;
+        }
+        if (reason){
+            free(reason);
+            reason = NULL;
+        }
+        xml_free(xe);
+        xe = NULL;
+    }
+    retval = 0;
+ done:
+    if (reason)
+        free(reason);
+    if (xe)
+        xml_free(xe);
+    if (cbret)
+        cbuf_free(cbret);
+    return retval;
+}
+
+/*! Schedule start of queued transactions
+ *
+ * @param[in]  h   Clixon handle
+ * @retval     0   OK
+ * @retval    -1   Error
+ */
+static int
+controller_transaction_dequeue_register(clixon_handle h)
+{
+    int            retval = -1;
+    struct timeval t;
+
+    gettimeofday(&t, NULL);
+    (void)clixon_event_unreg_timeout(controller_transaction_dequeue, h);
+    if (clixon_event_reg_timeout(t, controller_transaction_dequeue, h,
+                                 "Controller transaction queue") < 0)
+        goto done;
+    retval = 0;
+ done:
+    return retval;
+}
+
 /*! Free transaction itself
  */
 static int
 controller_transaction_free1(controller_transaction *ct)
 {
+    uint32_t i;
+
+    controller_transaction_trace_end(ct);
+    for (i=0; i<ct->ct_trace_nthreads; i++)
+        if (ct->ct_trace_threads[i].tt_device)
+            free(ct->ct_trace_threads[i].tt_device);
+    if (ct->ct_trace_threads)
+        free(ct->ct_trace_threads);
+    if (ct->ct_trace)
+        free(ct->ct_trace);
+    if (ct->ct_xqueue)
+        xml_free(ct->ct_xqueue);
     if (ct->ct_description)
         free(ct->ct_description);
     if (ct->ct_origin)
@@ -344,7 +1036,7 @@ controller_transaction_free1(controller_transaction *ct)
     if (ct->ct_reason)
         free(ct->ct_reason);
     if (ct->ct_warning)
-        free(ct->ct_reason);
+        free(ct->ct_warning);
     if (ct->ct_sourcedb)
         free(ct->ct_sourcedb);
     free(ct);
@@ -358,13 +1050,62 @@ controller_transaction_free(clixon_handle           h,
                             controller_transaction *ct)
 {
     controller_transaction *ct_list = NULL;
+    char                   *name;
+    int                     nr;
 
-    if (clicon_ptr_get(h, "controller-transaction-list", (void**)&ct_list) == 0){
+    name = ct->ct_state == TS_DONE ? "controller-transaction-history" : "controller-transaction-list";
+    if (clicon_ptr_get(h, name, (void**)&ct_list) == 0){
         DELQ(ct, ct_list, controller_transaction *);
+        clicon_ptr_set(h, name, (void*)ct_list);
     }
+    if (ct->ct_state == TS_DONE &&
+        (nr = clicon_data_int_get(h, "controller-transaction-history-nr")) > 0)
+        clicon_data_int_set(h, "controller-transaction-history-nr", nr-1);
+    transaction_index_del(h, ct);
     return controller_transaction_free1(ct);
 }
 
+/*! Remove oldest completed transactions exceeding transaction-history-max or -age
+ *
+ * @param[in]  h      Clixon handle
+ * @param[in]  ctkeep Do not remove this transaction (or NULL)
+ * @retval     0      OK
+ * @see clixon-controller.yang transaction-history-max
+ */
+static int
+controller_transaction_history_prune(clixon_handle           h,
+                                     controller_transaction *ctkeep)
+{
+    controller_transaction *ct_list = NULL;
+    controller_transaction *ct;
+    struct timeval          now;
+    int                     max;
+    int                     age;
+    int                     nr;
+
+    if ((max = clicon_data_int_get(h, "controller-transaction-history-max")) < 0)
+        max = CONTROLLER_TRANSACTION_HISTORY_MAX_DEFAULT;
+    if ((age = clicon_data_int_get(h, "controller-transaction-history-age")) < 0)
+        age = 0;
+    if ((nr = clicon_data_int_get(h, "controller-transaction-history-nr")) < 0)
+        nr = 0;
+    gettimeofday(&now, NULL);
+    clicon_ptr_get(h, "controller-transaction-history", (void**)&ct_list);
+    /* Oldest first */
+    while ((ct = ct_list) != NULL && ct != ctkeep){
+        if (nr <= max &&
+            (age == 0 || now.tv_sec - ct->ct_timestamp.tv_sec < age))
+            break;
+        DELQ(ct, ct_list, controller_transaction *);
+        transaction_index_del(h, ct);
+        controller_transaction_free1(ct);
+        nr--;
+    }
+    clicon_ptr_set(h, "controller-transaction-history", (void*)ct_list);
+    clicon_data_int_set(h, "controller-transaction-history-nr", nr);
+    return 0;
+}
+
 /*! Free all controller transactions
  *
  * @param[in]  h   Clixon handle
@@ -374,18 +1115,35 @@ controller_transaction_free_all(clixon_handle h)
 {
     controller_transaction *ct_list = NULL;
     controller_transaction *ct;
+    clicon_hash_t          *index = NULL;
 
+    (void)clixon_event_unreg_timeout(controller_transaction_dequeue, h);
     clicon_ptr_get(h, "controller-transaction-list", (void**)&ct_list);
     while ((ct = ct_list) != NULL) {
         DELQ(ct, ct_list, controller_transaction *);
         controller_transaction_free1(ct);
     }
     clicon_ptr_set(h, "controller-transaction-list", (void*)ct_list);
+    clicon_ptr_get(h, "controller-transaction-history", (void**)&ct_list);
+    while ((ct = ct_list) != NULL) {
+        DELQ(ct, ct_list, controller_transaction *);
+        controller_transaction_free1(ct);
+    }
+    clicon_ptr_set(h, "controller-transaction-history", (void*)ct_list);
+    clicon_data_int_set(h, "controller-transaction-history-nr", 0);
+    if (clicon_ptr_get(h, "controller-transaction-index", (void**)&index) == 0 && index != NULL){
+        clicon_hash_free(index);
+        clicon_ptr_del(h, "controller-transaction-index");
+    }
     return 0;
 }
 
 /*! Terminate/close transaction, unlock candidate, unmark all devices and notify
  *
+ * A queued transaction has not locked candidate and is just removed from the commit queue.
+ * The transaction is moved to the transaction history, where older transactions may be
+ * removed, but ct itself remains valid until a later transaction is done.
+ * Finally, schedule start of next transaction in commit queue, if any.
  * @param[in]  h      Clixon handle
  * @param[in]  ct     Transaction
  * @param[in]  result Can be -1 for already set
@@ -398,59 +1156,101 @@ controller_transaction_done(clixon_handle           h,
                             controller_transaction *ct,
                             transaction_result      result)
 {
-    int           retval = -1;
-    uint32_t      iddb;
-    char         *db = "candidate";
-    device_handle dh;
+    int                     retval = -1;
+    uint32_t                iddb;
+    char                   *db = "candidate";
+    device_handle           dh;
+    int                     queued;
+    int                     isdone;
+    controller_transaction *ct_list = NULL;
+    int                     nr;
 
     clixon_debug(CLIXON_DBG_DEFAULT, "%s %s", __FUNCTION__, transaction_result_int2str(ct->ct_state));
+    queued = (ct->ct_state == TS_QUEUED);
+    isdone = (ct->ct_state == TS_DONE);
     controller_transaction_state_set(ct, TS_DONE, result);
-    iddb = xmldb_islocked(h, db);
-    if (iddb != TRANSACTION_CLIENT_ID){
-        clixon_err(OE_NETCONF, 0, "Unlock failed, not locked by transaction");
-        goto done;
+    controller_transaction_trace_end(ct);
+    actions_timeout_unregister(ct);
+    /* Move from ongoing transactions to history */
+    if (!isdone){
+        if (clicon_ptr_get(h, "controller-transaction-list", (void**)&ct_list) == 0 && ct_list != NULL){
+            DELQ(ct, ct_list, controller_transaction *);
+            clicon_ptr_set(h, "controller-transaction-list", (void*)ct_list);
+        }
+        ct_list = NULL;
+        (void)clicon_ptr_get(h, "controller-transaction-history", (void**)&ct_list);
+        ADDQ(ct, ct_list);
+        clicon_ptr_set(h, "controller-transaction-history", (void*)ct_list);
+        if ((nr = clicon_data_int_get(h, "controller-transaction-history-nr")) < 0)
+            nr = 0;
+        clicon_data_int_set(h, "controller-transaction-history-nr", nr+1);
+        controller_transaction_history_prune(h, ct);
     }
-    if (xmldb_unlock(h, db) < 0)
-        goto done;
-     /* user callback */
-    if (clixon_plugin_lockdb_all(h, db, 0, TRANSACTION_CLIENT_ID) < 0)
-        goto done;
-    /* Unmark all devices */
+    if (!queued){
+        iddb = xmldb_islocked(h, db);
+        if (iddb != TRANSACTION_CLIENT_ID){
+            clixon_err(OE_NETCONF, 0, "Unlock failed, not locked by transaction");
+            goto done;
+        }
+        if (xmldb_unlock(h, db) < 0)
+            goto done;
+        /* user callback */
+        if (clixon_plugin_lockdb_all(h, db, 0, TRANSACTION_CLIENT_ID) < 0)
+            goto done;
+    }
+    /* Unmark all devices, devices waiting for a push wave that never started are reset
+     * and devices waiting for a connect slot are closed */
     dh = NULL;
     while ((dh = device_handle_each(h, dh)) != NULL){
-        if (device_handle_tid_get(dh) == ct->ct_id)
-            device_handle_tid_set(dh, 0);
+        if (device_handle_tid_get(dh) != ct->ct_id)
+            continue;
+        device_handle_tid_set(dh, 0);
+        if (device_handle_conn_state_get(dh) == CS_PUSH_QUEUE){
+            device_handle_outmsg_set(dh, NULL);
+            if (device_state_set(dh, CS_OPEN) < 0)
+                goto done;
+        }
+        else if (device_handle_conn_state_get(dh) == CS_CONNECT_PENDING){
+            if (device_reconnect_cancel(dh) < 0)
+                goto done;
+            if (device_close_connection(dh, "Connect cancelled") < 0)
+                goto done;
+        }
     }
     /* This should be the only place */
     if (controller_transaction_notify(h, ct) < 0)
         goto done;
+    if (controller_transaction_queue_head(h) != NULL &&
+        controller_transaction_dequeue_register(h) < 0)
+        goto done;
     retval = 0;
  done:
     return retval;
 }
 
-/*! Find clixon-client given name
+/*! Find transaction given id
  *
+ * Uses the id index of transactions, including completed transactions in history
  * @param[in]  h     Clixon  handle
  * @param[in]  id    Transaction id
  * @retval     ct    Transaction struct
+ * @retval     NULL  Not found
  */
 controller_transaction *
 controller_transaction_find(clixon_handle  h,
                             const uint64_t id)
 {
-    controller_transaction *ct_list = NULL;
-    controller_transaction *ct = NULL;
+    clicon_hash_t *index = NULL;
+    void          *p;
+    size_t         vlen;
+    char           idstr[32];
 
-    if (clicon_ptr_get(h, "controller-transaction-list", (void**)&ct_list) == 0 &&
-        (ct = ct_list) != NULL) {
-        do {
-            if (ct->ct_id == id)
-                return ct;
-            ct = NEXTQ(controller_transaction *, ct);
-        } while (ct && ct != ct_list);
-    }
-    return NULL;
+    if (clicon_ptr_get(h, "controller-transaction-index", (void**)&index) < 0 || index == NULL)
+        return NULL;
+    snprintf(idstr, sizeof(idstr), "%" PRIu64, id);
+    if ((p = clicon_hash_value(index, idstr, &vlen)) == NULL)
+        return NULL;
+    return *(controller_transaction **)p;
 }
 
 /*! Return number of devices in a specific transaction
@@ -560,6 +1360,11 @@ controller_transaction_failed(clixon_handle           h,
     else if (ct->ct_result == TR_SUCCESS){
         clixon_err(OE_XML, 0, "Sanity: may not be in resolved OK state");
     }
+    /* 1.4 If device left and was last of push wave, cancel remaining waves */
+    if (dh != NULL && devclose != TR_FAILED_DEV_IGNORE && ct->ct_state != TS_DONE){
+        if (controller_transaction_push_wave(h, ct) < 0)
+            goto done;
+    }
     retval = 0;
  done:
     clixon_debug(CLIXON_DBG_DEFAULT, "%s retval:%d", __FUNCTION__, retval);
@@ -586,6 +1391,8 @@ controller_transaction_wait(clixon_handle h,
     while ((dh = device_handle_each(h, dh)) != NULL){
         if (device_handle_tid_get(dh) != tid)
             continue;
+        if (device_handle_conn_state_get(dh) == CS_PUSH_QUEUE) /* Not in current push wave */
+            continue;
         if (
             device_handle_conn_state_get(dh) == CS_PUSH_LOCK ||
             device_handle_conn_state_get(dh) == CS_PUSH_CHECK ||
@@ -648,8 +1455,242 @@ controller_transaction_wait_trigger(clixon_handle h,
     return retval;
 }
 
+/*! Get number of devices of a transaction waiting for a later push wave
+ *
+ * @param[in]  h    Clixon handle
+ * @param[in]  tid  Transaction id
+ * @retval     n    Number of devices in PUSH-QUEUE state
+ * @see controller_transaction_push_wave
+ */
+int
+controller_transaction_push_queued(clixon_handle h,
+                                   uint64_t      tid)
+{
+    device_handle dh;
+    int           n = 0;
+
+    dh = NULL;
+    while ((dh = device_handle_each(h, dh)) != NULL){
+        if (device_handle_tid_get(dh) == tid &&
+            device_handle_conn_state_get(dh) == CS_PUSH_QUEUE)
+            n++;
+    }
+    return n;
+}
+
+/*! Start next push wave of a transaction if no device of the current wave is active
+ *
+ * Devices to push are first put in PUSH-QUEUE state, with edit-msg prepared but no lock.
+ * A wave locks at most ct_push_window devices (all if 0), the first wave at most
+ * ct_push_canary devices if set. A wave starts when all devices of the earlier wave have
+ * left the transaction. If the transaction has failed, remaining waves are cancelled and
+ * the transaction is terminated.
+ * @param[in]  h    Clixon handle
+ * @param[in]  ct   Transaction
+ * @retval     0    OK
+ * @retval    -1    Error
+ * @see controller_commit_push  Where devices are put in push queue
+ */
+int
+controller_transaction_push_wave(clixon_handle           h,
+                                 controller_transaction *ct)
+{
+    int           retval = -1;
+    device_handle dh;
+    int           active = 0;
+    int           queued = 0;
+    uint32_t      size;
+    uint32_t      n = 0;
+
+    dh = NULL;
+    while ((dh = device_handle_each(h, dh)) != NULL){
+        if (device_handle_tid_get(dh) != ct->ct_id)
+            continue;
+        if (device_handle_conn_state_get(dh) == CS_PUSH_QUEUE)
+            queued++;
+        else
+            active++;
+    }
+    if (active || queued == 0)
+        goto ok;
+    if (ct->ct_state == TS_RESOLVED){
+        clixon_debug(CLIXON_DBG_DEFAULT, "%s %" PRIu64 " wave %u failed, %d devices not pushed",
+                     __FUNCTION__, ct->ct_id, ct->ct_push_wave, queued);
+        if (controller_transaction_done(h, ct, -1) < 0)
+            goto done;
+        goto ok;
+    }
+    size = ct->ct_push_window;
+    if (ct->ct_push_wave == 0 && ct->ct_push_canary)
+        size = ct->ct_push_canary;
+    ct->ct_push_wave++;
+    dh = NULL;
+    while ((dh = device_handle_each(h, dh)) != NULL){
+        if (size && n >= size)
+            break;
+        if (device_handle_tid_get(dh) != ct->ct_id)
+            continue;
+        if (device_handle_conn_state_get(dh) != CS_PUSH_QUEUE)
+            continue;
+        if (device_send_lock(h, dh, 1) < 0)
+            goto done;
+        if (device_state_set(dh, CS_PUSH_LOCK) < 0)
+            goto done;
+        n++;
+    }
+    clixon_debug(CLIXON_DBG_DEFAULT, "%s %" PRIu64 " wave %u: %u of %d devices",
+                 __FUNCTION__, ct->ct_id, ct->ct_push_wave, n, queued);
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Get tid selector if xpath selects transactions on tid
+ *
+ * Accepts xpaths on the form: /transactions/transaction[tid='x'] or [tid>x] or [tid>=x],
+ * with optional prefixes and quotes
+ * @param[in]  xpath  XPath
+ * @param[out] op     0: no tid selector, 1: tid = x, 2: tid > x, 3: tid >= x
+ * @param[out] tid    Transaction id x
+ * @retval     0      OK
+ */
+static int
+statedata_xpath_tid(char     *xpath,
+                    int      *op,
+                    uint64_t *tid)
+{
+    char *s;
+    char *p;
+    char  q = '\0';
+    int   op1;
+
+    *op = 0;
+    if (strchr(xpath, '|') != NULL || strstr(xpath, "//") != NULL)
+        return 0;
+    if ((s = strstr(xpath, "transaction[")) == NULL)
+        return 0;
+    if (s != xpath && *(s-1) != '/' && *(s-1) != ':')
+        return 0;
+    s += strlen("transaction[");
+    if ((p = strchr(s, ':')) != NULL && p < strpbrk(s, "=>]"))
+        s = p+1;
+    if (strncmp(s, "tid", strlen("tid")) != 0)
+        return 0;
+    s += strlen("tid");
+    while (isspace(*s))
+        s++;
+    if (*s == '=')
+        op1 = 1;
+    else if (*s == '>' && *(s+1) == '='){
+        op1 = 3;
+        s++;
+    }
+    else if (*s == '>')
+        op1 = 2;
+    else
+        return 0;
+    s++;
+    while (isspace(*s))
+        s++;
+    if (*s == '\'' || *s == '"')
+        q = *s++;
+    if (!isdigit(*s))
+        return 0;
+    *tid = strtoull(s, &p, 10);
+    if (q && *p++ != q)
+        return 0;
+    while (isspace(*p))
+        p++;
+    if (*p != ']')
+        return 0;
+    *op = op1;
+    return 0;
+}
+
+/*! Add state data of one transaction as XML
+ *
+ * @param[in]  ct     Transaction
+ * @param[in]  now    Current time
+ * @param[in]  pos    Position in commit queue if queued
+ * @param[in]  xts    XML transactions container
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+static int
+transaction_statedata(controller_transaction *ct,
+                      struct timeval         *now,
+                      uint32_t                pos,
+                      cxobj                  *xts)
+{
+    int            retval = -1;
+    cxobj         *xt;
+    struct timeval wait;
+    char           timestr[28];
+    char           nr[32];
+
+    if ((xt = xml_new("transaction", xts, CX_ELMNT)) == NULL)
+        goto done;
+    snprintf(nr, sizeof(nr), "%" PRIu64, ct->ct_id);
+    if (xml_new_body("tid", xt, nr) == NULL)
+        goto done;
+    if (xml_new_body("state", xt, transaction_state_int2str(ct->ct_state)) == NULL)
+        goto done;
+    if (ct->ct_description &&
+        xml_new_body("description", xt, ct->ct_description) == NULL)
+        goto done;
+    if (ct->ct_origin &&
+        xml_new_body("origin", xt, ct->ct_origin) == NULL)
+        goto done;
+    if (ct->ct_reason &&
+        xml_new_body("reason", xt, ct->ct_reason) == NULL)
+        goto done;
+    if (ct->ct_warning &&
+        xml_new_body("warning", xt, ct->ct_warning) == NULL)
+        goto done;
+    if (ct->ct_state != TS_INIT && ct->ct_state != TS_QUEUED &&
+        xml_new_body("result", xt, transaction_result_int2str(ct->ct_result)) == NULL)
+        goto done;
+    if (ct->ct_timestamp.tv_sec != 0){
+        if (time2str(&ct->ct_timestamp, timestr, sizeof(timestr)) < 0)
+            goto done;
+        if (xml_new_body("timestamp", xt, timestr) == NULL)
+            goto done;
+    }
+    if (ct->ct_state == TS_QUEUED){
+        snprintf(nr, sizeof(nr), "%u", pos);
+        if (xml_new_body("queue-position", xt, nr) == NULL)
+            goto done;
+        timersub(now, &ct->ct_queued, &wait);
+        snprintf(nr, sizeof(nr), "%lu", (unsigned long)(wait.tv_sec*1000 + wait.tv_usec/1000));
+        if (xml_new_body("queue-wait", xt, nr) == NULL)
+            goto done;
+    }
+    else if (ct->ct_queued.tv_sec != 0){
+        snprintf(nr, sizeof(nr), "%u", ct->ct_queue_wait);
+        if (xml_new_body("queue-wait", xt, nr) == NULL)
+            goto done;
+    }
+    if (ct->ct_coalesced){
+        snprintf(nr, sizeof(nr), "%u", ct->ct_coalesced);
+        if (xml_new_body("coalesced", xt, nr) == NULL)
+            goto done;
+    }
+    if (ct->ct_push_wave && (ct->ct_push_window || ct->ct_push_canary)){
+        snprintf(nr, sizeof(nr), "%u", ct->ct_push_wave);
+        if (xml_new_body("push-wave", xt, nr) == NULL)
+            goto done;
+    }
+    retval = 0;
+ done:
+    return retval;
+}
+
 /*! Get transactions statedata
  *
+ * Completed transactions in history are listed first, then ongoing and queued transactions.
+ * State is only generated if xpath may select transactions, and only for the transactions
+ * selected by a tid predicate, if any.
  * @param[in]    h        Clixon handle
  * @param[in]    nsc      External XML namespace context, or NULL
  * @param[in]    xpath    String with XPath syntax. or NULL for all
@@ -663,63 +1704,79 @@ controller_transaction_statedata(clixon_handle   h,
                                  char           *xpath,
                                  cxobj          *xstate)
 {
-    int            retval = -1;
-    cxobj        **vec = NULL;
-    cxobj         *xret = NULL;
-    cbuf          *cb = NULL;
-    struct timeval *tv;
+    int                     retval = -1;
+    cbuf                   *cb = NULL;
+    cxobj                  *xts = NULL;
     controller_transaction *ct_list = NULL;
     controller_transaction *ct = NULL;
+    struct timeval          now;
+    uint32_t                pos = 0;
+    char                   *lists[] = {"controller-transaction-history", "controller-transaction-list"};
+    int                     i;
+    int                     op = 0;
+    uint64_t                tid = 0;
 
     clixon_debug(CLIXON_DBG_DEFAULT|CLIXON_DBG_DETAIL, "%s", __FUNCTION__);
     if ((cb = cbuf_new()) == NULL){
         clixon_err(OE_UNIX, errno, "cbuf_new");
         goto done;
     }
-    cprintf(cb, "<transactions xmlns=\"%s\">", CONTROLLER_NAMESPACE);
-    if (clicon_ptr_get(h, "controller-transaction-list", (void**)&ct_list) == 0 &&
-        (ct = ct_list) != NULL) {
-        do {
-            cprintf(cb, "<transaction>");
-            cprintf(cb, "<tid>%" PRIu64  "</tid>", ct->ct_id);
-            cprintf(cb, "<state>%s</state>", transaction_state_int2str(ct->ct_state));
-            if (ct->ct_description)
-                cprintf(cb, "<description>%s</description>", ct->ct_description);
-            if (ct->ct_origin)
-                cprintf(cb, "<origin>%s</origin>", ct->ct_origin);
-            if (ct->ct_reason){
-                cprintf(cb, "<reason>");
-                xml_chardata_cbuf_append(cb, ct->ct_reason);
-                cprintf(cb, "</reason>");
-            }
-            if (ct->ct_warning){
-                cprintf(cb, "<warning>");
-                xml_chardata_cbuf_append(cb, ct->ct_warning);
-                cprintf(cb, "</warning>");
+    if (xpath && strchr(xpath, '|') == NULL){
+        /* Skip if xpath selects other top-level node */
+        if (statedata_xpath_step(xpath, 0, cb) < 0)
+            goto done;
+        if (cbuf_len(cb) && strcmp(cbuf_get(cb), "transactions") != 0)
+            goto ok;
+        if (statedata_xpath_tid(xpath, &op, &tid) < 0)
+            goto done;
+    }
+    gettimeofday(&now, NULL);
+    /* Remove completed transactions that have aged */
+    controller_transaction_history_prune(h, NULL);
+    if ((xts = xml_new("transactions", NULL, CX_ELMNT)) == NULL)
+        goto done;
+    if (xmlns_set(xts, NULL, CONTROLLER_NAMESPACE) < 0)
+        goto done;
+    if (op == 1){ /* Single transaction */
+        if ((ct = controller_transaction_find(h, tid)) != NULL){
+            if (ct->ct_state == TS_QUEUED &&
+                clicon_ptr_get(h, "controller-transaction-list", (void**)&ct_list) == 0 &&
+                ct_list != NULL){
+                for (; ct_list != ct; ct_list = NEXTQ(controller_transaction *, ct_list))
+                    if (ct_list->ct_state == TS_QUEUED)
+                        pos++;
             }
-            if (ct->ct_state != TS_INIT)
-                cprintf(cb, "<result>%s</result>", transaction_result_int2str(ct->ct_result));
-            tv = &ct->ct_timestamp;
-            if (tv->tv_sec != 0){
-                char timestr[28];
-                if (time2str(tv, timestr, sizeof(timestr)) < 0)
+            if (transaction_statedata(ct, &now, ++pos, xts) < 0)
+                goto done;
+        }
+    }
+    else for (i=0; i<sizeof(lists)/sizeof(*lists); i++){
+        ct_list = NULL;
+        if (clicon_ptr_get(h, lists[i], (void**)&ct_list) == 0 &&
+            (ct = ct_list) != NULL) {
+            do {
+                if (ct->ct_state == TS_QUEUED)
+                    pos++;
+                if ((op == 2 && ct->ct_id <= tid) ||
+                    (op == 3 && ct->ct_id < tid)){
+                    ct = NEXTQ(controller_transaction *, ct);
+                    continue;
+                }
+                if (transaction_statedata(ct, &now, pos, xts) < 0)
                     goto done;
-                cprintf(cb, "<timestamp>%s</timestamp>", timestr);
-            }
-            cprintf(cb, "</transaction>");
-            ct = NEXTQ(controller_transaction *, ct);
-        } while (ct && ct != ct_list);
+                ct = NEXTQ(controller_transaction *, ct);
+            } while (ct && ct != ct_list);
+        }
     }
-    cprintf(cb, "</transactions>");
-    if (clixon_xml_parse_string(cbuf_get(cb), YB_NONE, NULL, &xstate, NULL) < 0)
+    if (xml_addsub(xstate, xts) < 0)
         goto done;
+    xts = NULL;
+ ok:
     retval = 0;
  done:
+    if (xts)
+        xml_free(xts);
     if (cb)
         cbuf_free(cb);
-    if (vec)
-        free(vec);
-    if (xret)
-        xml_free(xret);
     return retval;
 }
@@ -40,6 +40,56 @@
 /* Controller transaction id beyond 16-bit to != pid? */
 #define TRANSACTION_CLIENT_ID 0x199999
 
+/* Default max number of transactions waiting in commit queue
+ * @see clixon-controller.yang transaction-queue-depth
+ */
+#define CONTROLLER_TRANSACTION_QUEUE_DEPTH_DEFAULT 16
+
+/* Default max number of completed transactions kept
+ * @see clixon-controller.yang transaction-history-max
+ */
+#define CONTROLLER_TRANSACTION_HISTORY_MAX_DEFAULT 1000
+
+/* Max number of trace spans recorded per device of a transaction, and for the phases of
+ * the transaction itself, further spans are dropped
+ * @see controller_transaction_trace
+ */
+#define CONTROLLER_TRACE_THREAD_MAX 64
+
+struct controller_transaction_t;
+
+/*! Timestamped span of a transaction trace
+ *
+ * A span is either a transaction phase or a device state
+ */
+struct controller_trace_t{
+    const char        *tr_name;          /* Name of phase or state, static string */
+    uint32_t           tr_thread;        /* Index in ct_trace_threads, 0 if transaction phase */
+    struct timeval     tr_start;         /* Start of span */
+    struct timeval     tr_end;           /* End of span */
+};
+
+/*! Trace thread, ie the transaction phases or one device of a transaction trace
+ */
+struct controller_trace_thread_t{
+    char              *tt_device;        /* Device name, or NULL if transaction phases */
+    uint32_t           tt_spans;         /* Number of recorded spans */
+    uint32_t           tt_dropped;       /* Spans dropped after CONTROLLER_TRACE_THREAD_MAX */
+};
+
+/*! Start function of queued transaction, called when ongoing transaction terminates
+ *
+ * @param[in]  h      Clixon handle
+ * @param[in]  xe     Original RPC request
+ * @param[out] cbret  Return xml tree, eg <rpc-reply>..., <rpc-error..
+ * @param[in]  client_id Client id of originator
+ * @param[in]  ct     Queued transaction
+ * @see controller_transaction_new_queue
+ */
+typedef int (controller_transaction_start_fn)(clixon_handle h, cxobj *xe, cbuf *cbret,
+                                              uint32_t client_id,
+                                              struct controller_transaction_t *ct);
+
 /*! Clixon controller distributed transactions spanning device operation
  */
 struct controller_transaction_t{
@@ -61,6 +111,20 @@ struct controller_transaction_t{
     char              *ct_reason;        /* Reason of error (if result != SUCCESS) */
     char              *ct_warning;       /* Warning, first encountered */
     struct timeval     ct_timestamp;     /* Timestamp when entering current state */
+    cxobj             *ct_xqueue;        /* Queued RPC request, started by ct_startfn */
+    controller_transaction_start_fn *ct_startfn; /* Start function of queued transaction */
+    struct timeval     ct_queued;        /* Timestamp when entering commit queue */
+    uint32_t           ct_queue_wait;    /* Time spent in commit queue in ms (when started) */
+    uint32_t           ct_coalesced;     /* Number of queued requests merged into this */
+    uint32_t           ct_push_window;   /* Max number of devices pushed concurrently, 0: all */
+    uint32_t           ct_push_canary;   /* Number of devices in first (canary) wave, 0: none */
+    uint32_t           ct_push_wave;     /* Current push wave, 0: push not started */
+    struct controller_trace_t *ct_trace; /* Vector of trace spans */
+    uint32_t           ct_trace_len;     /* Number of trace spans */
+    uint32_t           ct_trace_size;    /* Allocated trace spans */
+    struct controller_trace_thread_t *ct_trace_threads; /* Vector of trace threads */
+    uint32_t           ct_trace_nthreads;/* Number of trace threads */
+    clicon_hash_t     *ct_trace_index;   /* Trace thread index by device name, while recording */
 };
 typedef struct controller_transaction_t controller_transaction;
 
@@ -85,6 +149,11 @@ extern "C" {
 int   controller_transaction_state_set(controller_transaction *ct, transaction_state state, transaction_result result);
 int   controller_transaction_notify(clixon_handle h, controller_transaction *ct);
 int   controller_transaction_new(clixon_handle h, char *description, controller_transaction **ct, cbuf **cberr);
+int   controller_transaction_new_queue(clixon_handle h, char *description, cxobj *xe, uint32_t client_id,
+                                       controller_transaction_start_fn *fn,
+                                       controller_transaction **ct, cbuf **cberr);
+int   controller_transaction_queued(clixon_handle h);
+int   controller_transaction_activate(clixon_handle h, controller_transaction *ct, cbuf **cberr);
 int   controller_transaction_free(clixon_handle h, controller_transaction *ct);
 int   controller_transaction_free_all(clixon_handle h);
 int   controller_transaction_done(clixon_handle h, controller_transaction *ct, transaction_result result);
@@ -95,7 +164,12 @@ int   controller_transaction_failed(clixon_handle h, uint64_t tid, controller_tr
                                     tr_failed_devclose devclose, char *origin, char *reason);
 int   controller_transaction_wait(clixon_handle h, uint64_t tid);
 int   controller_transaction_wait_trigger(clixon_handle h, uint64_t tid, int commit);
+int   controller_transaction_push_queued(clixon_handle h, uint64_t tid);
+int   controller_transaction_push_wave(clixon_handle h, controller_transaction *ct);
 int   controller_transaction_statedata(clixon_handle h, cvec *nsc, char *xpath, cxobj *xstate);
+int   controller_transaction_trace(controller_transaction *ct, const char *device, const char *name,
+                                   struct timeval *start, struct timeval *end);
+int   controller_transaction_trace2json(controller_transaction *ct, cbuf *cb);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,82 @@
+#!/usr/bin/env bash
+# Automatic reconnect with jittered exponential backoff
+# Reset devices and backend
+# 1. Set reconnect-backoff on all devices and reconnect to apply it
+# 2. Kill netconf session on first device, check it is reconnected automatically
+# 3. Close devices by user request and check they are not reconnected
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+set -u
+
+# Reset devices
+. ./reset-devices.sh
+
+if $BE; then
+    new "Kill old backend"
+    sudo clixon_backend -s init -f $CFG -z
+
+    new "Start new backend -s init -f $CFG"
+    start_backend -s init -f $CFG
+fi
+
+new "Wait backend"
+wait_backend
+
+# Reset controller
+. ./reset-controller.sh
+
+new "Set reconnect-backoff 1"
+expectpart "$($clixon_cli -1 -m configure -f $CFG set devices device openconfig* reconnect-backoff 1)" 0 "^$"
+
+new "Set reconnect-backoff-max 2"
+expectpart "$($clixon_cli -1 -m configure -f $CFG set devices device openconfig* reconnect-backoff-max 2)" 0 "^$"
+
+new "commit local"
+expectpart "$($clixon_cli -1 -m configure -f $CFG commit local)" 0 "^$"
+
+new "connection reconnect"
+expectpart "$($clixon_cli -1 -f $CFG connection reconnect)" 0 ""
+
+new "Check devices are open"
+expectpart "$($clixon_cli -1 -f $CFG show devices)" 0 "openconfig1.*OPEN"
+
+ip=$(echo $CONTAINERS | awk '{print $1}')
+new "Kill netconf session on first device"
+ssh -l $USER $ip pkill clixon_netconf || true
+
+new "Wait for auto-reconnect of openconfig1"
+for i in $(seq 1 10); do
+    sleep 1
+    ret=$($clixon_cli -1 -f $CFG show devices openconfig1 detail)
+    match=$(echo "$ret" | grep --null -o "<conn-state>OPEN</conn-state>") || true
+    if [ -n "$match" ]; then
+        break
+    fi
+done
+expectpart "$ret" 0 "<conn-state>OPEN</conn-state>" --not-- "<reconnect-next>"
+
+new "connection close"
+expectpart "$($clixon_cli -1 -f $CFG connection close)" 0 ""
+
+sleep 3
+new "Check devices are not reconnected after user close"
+expectpart "$($clixon_cli -1 -f $CFG show devices openconfig1 detail)" 0 "<conn-state>CLOSED</conn-state>" --not-- "<reconnect-next>"
+
+new "Restore reconnect-backoff"
+expectpart "$($clixon_cli -1 -m configure -f $CFG delete devices device openconfig* reconnect-backoff)" 0 "^$"
+expectpart "$($clixon_cli -1 -m configure -f $CFG delete devices device openconfig* reconnect-backoff-max)" 0 "^$"
+
+new "commit local"
+expectpart "$($clixon_cli -1 -m configure -f $CFG commit local)" 0 "^$"
+
+new "connection open"
+expectpart "$($clixon_cli -1 -f $CFG connection open)" 0 ""
+
+if $BE; then
+    new "Kill old backend"
+    stop_backend -f $CFG
+fi
+
+endtest
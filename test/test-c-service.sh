@@ -29,6 +29,7 @@
 # +------------------------------------------------+
 #
 # Also, after testA(1) do a pull and a restart to ensure creator attributes are intact
+# and that service data is stripped using the created paths index rebuilt from running
 #
 # For debug start service daemon externally: ${BINDIR}/clixon_controller_service -f $CFG and
 # disable CONTROLLER_ACTION_COMMAND
@@ -583,6 +584,8 @@ fi
 
 new "commit diff 4"
 # Ax removed, Az added
+# Backend restarted in running mode without startup commit: Ax is stripped using the
+# created paths index built from running, while Bx of testB is not stripped
 ret=$(${clixon_cli} -m configure -1f $CFG commit diff 2> /dev/null) 
 #echo "ret:$ret"
 match=$(echo $ret | grep --null -Eo '\+ <name>Az</name>') || true
@@ -593,6 +596,10 @@ match=$(echo $ret | grep --null -Eo '\- <name>Ax</name') || true
 if [ -z "$match" ]; then
     err "diff - Ax entry" "$ret"
 fi
+match=$(echo $ret | grep --null -Eo '\- <name>Bx</name') || true
+if [ -n "$match" ]; then
+    err "no diff - Bx entry" "$ret"
+fi
 
 # Delete testA completely
 new "delete testA(3)"
@@ -8,6 +8,7 @@
 # Push validate to devices which should fail
 # Push commit to devices which should fail
 # make a cli show devices check and diff
+# Get device diff summary, and in pages of one device
 
 # Magic line must be first in script (see README.md)
 s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
@@ -260,6 +261,84 @@ if [ -z "$match" ]; then
     exit 1
 fi
 
+new "device diff summary"
+ret=$(${clixon_netconf} -0 -f $CFG <<EOF
+<?xml version="1.0" encoding="UTF-8"?>
+<hello xmlns="urn:ietf:params:xml:ns:netconf:base:1.0">
+   <capabilities>
+      <capability>urn:ietf:params:netconf:base:1.0</capability>
+   </capabilities>
+</hello>]]>]]>
+<rpc xmlns="urn:ietf:params:xml:ns:netconf:base:1.0" message-id="42">
+  <datastore-diff xmlns="http://clicon.org/controller">
+    <devname>$NAME</devname>
+    <config-type1>RUNNING</config-type1>
+    <config-type2>TRANSIENT</config-type2>
+    <summary>true</summary>
+  </datastore-diff>
+</rpc>]]>]]>
+EOF
+)
+match=$(echo $ret | grep --null -Eo "<device xmlns=\"http://clicon.org/controller\"><name>$NAME</name><changed>true</changed><changes>[1-9][0-9]*</changes></device>") || true
+if [ -z "$match" ]; then
+    err1 "changed device" "$ret"
+fi
+match=$(echo $ret | grep --null -Eo "<diff") || true
+if [ -n "$match" ]; then
+    err1 "No diff in summary" "$ret"
+fi
+
+if [ $nr -gt 1 ]; then
+    new "device diff summary first page"
+    ret=$(${clixon_netconf} -0 -f $CFG <<EOF
+<?xml version="1.0" encoding="UTF-8"?>
+<hello xmlns="urn:ietf:params:xml:ns:netconf:base:1.0">
+   <capabilities>
+      <capability>urn:ietf:params:netconf:base:1.0</capability>
+   </capabilities>
+</hello>]]>]]>
+<rpc xmlns="urn:ietf:params:xml:ns:netconf:base:1.0" message-id="42">
+  <datastore-diff xmlns="http://clicon.org/controller">
+    <devname>${IMG}*</devname>
+    <config-type1>SYNCED</config-type1>
+    <config-type2>RUNNING</config-type2>
+    <summary>true</summary>
+    <limit>1</limit>
+  </datastore-diff>
+</rpc>]]>]]>
+EOF
+)
+    match=$(echo $ret | grep --null -Eo "<name>${IMG}1</name>.*<next-offset xmlns=\"http://clicon.org/controller\">1</next-offset>") || true
+    if [ -z "$match" ]; then
+        err1 "first device and next-offset" "$ret"
+    fi
+
+    new "device diff summary second page"
+    ret=$(${clixon_netconf} -0 -f $CFG <<EOF
+<?xml version="1.0" encoding="UTF-8"?>
+<hello xmlns="urn:ietf:params:xml:ns:netconf:base:1.0">
+   <capabilities>
+      <capability>urn:ietf:params:netconf:base:1.0</capability>
+   </capabilities>
+</hello>]]>]]>
+<rpc xmlns="urn:ietf:params:xml:ns:netconf:base:1.0" message-id="42">
+  <datastore-diff xmlns="http://clicon.org/controller">
+    <devname>${IMG}*</devname>
+    <config-type1>SYNCED</config-type1>
+    <config-type2>RUNNING</config-type2>
+    <summary>true</summary>
+    <offset>1</offset>
+    <limit>1</limit>
+  </datastore-diff>
+</rpc>]]>]]>
+EOF
+)
+    match=$(echo $ret | grep --null -Eo "<name>${IMG}2</name>") || true
+    if [ -z "$match" ]; then
+        err1 "second device" "$ret"
+    fi
+fi
+
 # Cannot pull if edits in candidate
 new "edit local candidate"
 expectpart "$($clixon_cli -1f $CFG -m configure delete devices device openconfig1 config interfaces interface z)" 0 "^$"
@@ -0,0 +1,103 @@
+#!/usr/bin/env bash
+# Persistent autocli cache of device trees
+# Reset devices and backend
+# 1. Cold: generate autocli trees with empty cache dir, check cache file is created
+# 2. Warm: load autocli trees from cache, check cache file is not rewritten
+#    Report cold and warm times of clixon_cli -1 show devices
+# 3. Check edit of device config using cached tree
+# 4. Corrupt cache file, check it is regenerated
+# 5. Other autocli options, check another cache file is created
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+set -u
+
+cachedir=/var/tmp/$0/cache
+rm -rf $cachedir
+mkdir -p $cachedir
+
+# Reset devices
+. ./reset-devices.sh
+
+if $BE; then
+    new "Kill old backend"
+    sudo clixon_backend -s init -f $CFG -z
+
+    new "Start new backend -s init -f $CFG"
+    start_backend -s init -f $CFG
+fi
+
+new "Wait backend"
+wait_backend
+
+# Reset controller
+. ./reset-controller.sh
+
+# Time in ms
+function ms()
+{
+    echo $(($(date +%s%N)/1000000))
+}
+
+t0=$(ms)
+new "Cold: show devices with expanded autocli trees"
+expectpart "$($clixon_cli -1 -f $CFG -o CONTROLLER_AUTOCLI_CACHE_DIR=$cachedir show devices -- -g)" 0 "${IMG}1.*OPEN"
+t1=$(ms)
+
+new "Check cache file created"
+nrfiles=$(ls $cachedir/autocli-*.cli 2> /dev/null | wc -l)
+if [ $nrfiles -lt 1 ]; then
+    err1 "At least one cache file" "$nrfiles"
+fi
+fcache=$(ls $cachedir/autocli-*.cli | head -1)
+mtime0=$(stat -c %Y $fcache)
+sleep 1
+
+t2=$(ms)
+new "Warm: show devices with expanded autocli trees"
+expectpart "$($clixon_cli -1 -f $CFG -o CONTROLLER_AUTOCLI_CACHE_DIR=$cachedir show devices -- -g)" 0 "${IMG}1.*OPEN"
+t3=$(ms)
+>&2 echo "clixon_cli -1 show devices cold: $((t1-t0))ms warm: $((t3-t2))ms"
+
+new "Check cache file not rewritten"
+mtime1=$(stat -c %Y $fcache)
+if [ $mtime0 -ne $mtime1 ]; then
+    err1 "$mtime0" "$mtime1"
+fi
+
+new "Set hostname using cached autocli tree"
+expectpart "$($clixon_cli -1 -f $CFG -o CONTROLLER_AUTOCLI_CACHE_DIR=$cachedir -m configure set devices device ${IMG}1 config system config hostname cached)" 0 "^$"
+
+new "Show compare"
+expectpart "$($clixon_cli -1 -f $CFG -m configure show compare)" 0 "^+\ *hostname cached;"
+
+new "Discard"
+expectpart "$($clixon_cli -1 -f $CFG -m configure discard)" 0 "^$"
+
+new "Corrupt cache file"
+echo "garbage {" > $fcache
+
+new "Show devices with corrupt cache"
+expectpart "$($clixon_cli -1 -f $CFG -o CONTROLLER_AUTOCLI_CACHE_DIR=$cachedir show devices -- -g)" 0 "${IMG}1.*OPEN"
+
+new "Check cache file regenerated"
+expectpart "$(cat $fcache)" 0 "" --not-- "garbage"
+
+new "Show devices with other autocli options"
+expectpart "$($clixon_cli -1 -f $CFG -o CONTROLLER_AUTOCLI_CACHE_DIR=$cachedir -o CLICON_CLI_HELPSTRING_LINES=2 show devices -- -g)" 0 "${IMG}1.*OPEN"
+
+new "Check other cache file created"
+nrfiles1=$(ls $cachedir/autocli-*.cli 2> /dev/null | wc -l)
+if [ $nrfiles1 -le $nrfiles ]; then
+    err1 "More than $nrfiles cache files" "$nrfiles1"
+fi
+
+if $BE; then
+    new "Kill old backend"
+    stop_backend -f $CFG
+fi
+
+rm -rf $cachedir
+
+endtest
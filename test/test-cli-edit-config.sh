@@ -146,6 +146,16 @@ sleep_open
 new "First testrun"
 testrun
 
+# The CLI caches the device list, and invalidates it on device-change notifications
+new "Close openconfig1"
+expectpart "$($clixon_cli -1 -f $CFG connection openconfig1 close)" 0 ""
+
+new "Completion of interfaces after open in same CLI session"
+expectpart "$((echo "set devices device openconfig1 config interfaces interface ?"; sleep 1; $clixon_cli -1 -f $CFG connection openconfig1 open > /dev/null; sleep $sleep; echo "set devices device openconfig1 config interfaces interface ?") | $clixon_cli -f $CFG -m configure 2> /dev/null)" 0 "<name>"
+
+new "Sleep and verify devices are open 3"
+sleep_open
+
 if $BE; then
     new "Kill old backend"
     stop_backend -f $CFG
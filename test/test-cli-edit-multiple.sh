@@ -1,4 +1,5 @@
 # Controller test script for cli set/delete multiple, using glob '*'
+# Also load of multiple devices in batches, and abort of replace if first batch fails
 
 # Magic line must be first in script (see README.md)
 s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
@@ -9,6 +10,7 @@ CFD=$dir/conf.d
 test -d $dir || mkdir -p $dir
 test -d $CFD || mkdir -p $CFD
 fin=$dir/in
+fin2=$dir/in2
 
 cat<<EOF > $CFG
 <clixon-config xmlns="http://clicon.org/config">
@@ -80,6 +82,7 @@ delete("Delete a configuration item") {
       @datamodel, cli_auto_del_devs(); 
       all("Delete whole candidate configuration"), delete_all("candidate");
 }
+load("Load configuration from file to candidate") <operation:string choice:replace|merge|create>("Write operation on candidate") <format:string choice:xml|json>("File format") [filename <filename:string>("Filename (local filename)")] [batch <batch:uint32>("Max devices per edit-config")], cli_auto_load_devs();
 quit("Quit"), cli_quit();
 show("Show a particular state of the system"), @datamodelshow, cli_show_auto_mode("candidate", "xml", true, false);{
     @datamodelshow, cli_show_auto_devs("candidate", "xml", false, false);
@@ -153,6 +156,41 @@ expectpart "$($clixon_cli -1 -m configure -f $CFG del devices device ${IMG}* con
 new "verify no z"
 expectpart "$($clixon_cli -1 -m configure -f $CFG show cli devices device ${IMG}* config interface interface z)" 0 "${IMG}1:" "${IMG}2:" --not-- "set interface z"
 
+# Batch load: one interface y per device
+echo "<config><devices xmlns=\"http://clicon.org/controller\">" > $fin
+for i in $(seq 1 $nr); do
+    cat <<EOF >> $fin
+<device><name>${IMG}$i</name><config><interfaces xmlns="http://openconfig.net/yang/interfaces"><interface><name>y</name><config><name>y</name><type xmlns:ianaift="urn:ietf:params:xml:ns:yang:iana-if-type">ianaift:atm</type></config></interface></interfaces></config></device>
+EOF
+done
+echo "</devices></config>" >> $fin
+
+new "load merge xml batch 1"
+expectpart "$($clixon_cli -1 -m configure -f $CFG load merge xml filename $fin batch 1)" 0 "Batch 1: 1 devices (${IMG}1..${IMG}1)" "Loaded $nr devices in $nr batches"
+
+new "verify y atm"
+expectpart "$($clixon_cli -1 -m configure -f $CFG show cli devices device ${IMG}* config interfaces interface y)" 0 "${IMG}1:" "${IMG}2:" "set interface y config type atm"
+
+# First batch of replace fails: abort, candidate unchanged
+cat <<EOF > $fin2
+<config><devices xmlns="http://clicon.org/controller">
+<device><name>${IMG}1</name><config><xxx xmlns="urn:example:unknown"/></config></device>
+<device><name>${IMG}2</name><config/></device>
+</devices></config>
+EOF
+
+new "load replace xml batch first batch error"
+expectpart "$($clixon_cli -1 -m configure -f $CFG load replace xml filename $fin2 batch 1 2>&1)" 255 "Batch 1 failed, load aborted" --not-- "Batch 2"
+
+new "verify y atm after aborted load"
+expectpart "$($clixon_cli -1 -m configure -f $CFG show cli devices device ${IMG}* config interfaces interface y)" 0 "${IMG}1:" "${IMG}2:" "set interface y config type atm"
+
+new "load json batch error"
+expectpart "$($clixon_cli -1 -m configure -f $CFG load merge json filename $fin batch 1 2>&1)" 255 "batch load only implemented for xml"
+
+new "del * y"
+expectpart "$($clixon_cli -1 -m configure -f $CFG del devices device ${IMG}* config interfaces interface y)" 0 "^$"
+
 if $BE; then
     new "Kill old backend"
     stop_backend -f $CFG
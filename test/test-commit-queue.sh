@@ -0,0 +1,88 @@
+#!/usr/bin/env bash
+# Transaction commit queue
+# Reset devices and backend
+# 1. Send reconnect and two identical pulls in one session, check second pull is queued
+#    and third pull merged with it
+# 2. Set transaction-queue-depth to 0 and check that a second request is rejected
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+set -u
+
+# Reset devices
+. ./reset-devices.sh
+
+if $BE; then
+    new "Kill old backend"
+    sudo clixon_backend -s init -f $CFG -z
+
+    new "Start new backend -s init -f $CFG"
+    start_backend -s init -f $CFG
+fi
+
+new "Wait backend"
+wait_backend
+
+# Reset controller
+. ./reset-controller.sh
+
+# Send reconnect followed by two identical pulls in one netconf session
+# The reconnect is ongoing when the pulls arrive
+function send_queue()
+{
+    ${clixon_netconf} -q0 -f $CFG <<EOF
+<rpc xmlns="urn:ietf:params:xml:ns:netconf:base:1.0" message-id="42">
+  <connection-change xmlns="http://clicon.org/controller">
+    <devname>*</devname>
+    <operation>RECONNECT</operation>
+  </connection-change>
+</rpc>]]>]]>
+<rpc xmlns="urn:ietf:params:xml:ns:netconf:base:1.0" message-id="43">
+  <config-pull xmlns="http://clicon.org/controller">
+    <devname>*</devname>
+  </config-pull>
+</rpc>]]>]]>
+<rpc xmlns="urn:ietf:params:xml:ns:netconf:base:1.0" message-id="44">
+  <config-pull xmlns="http://clicon.org/controller">
+    <devname>*</devname>
+  </config-pull>
+</rpc>]]>]]>
+EOF
+}
+
+new "Send reconnect and queued pulls"
+ret=$(send_queue)
+match=$(echo "$ret" | grep --null -Eo "<rpc-error>") || true
+if [ -n "$match" ]; then
+    err1 "No rpc-error" "$ret"
+fi
+
+sleep $sleep
+
+new "Check queued transactions are done"
+expectpart "$($clixon_cli -1 -f $CFG show transaction)" 0 "<description>pull</description>" "<queue-wait>" "<coalesced>1</coalesced>" "<result>SUCCESS</result>" --not-- "<state>QUEUED</state>" "<result>FAILED</result>"
+
+new "Set transaction-queue-depth 0"
+expectpart "$($clixon_cli -1 -m configure -f $CFG set devices transaction-queue-depth 0)" 0 "^$"
+
+new "commit local"
+expectpart "$($clixon_cli -1 -m configure -f $CFG commit local)" 0 "^$"
+
+new "Send reconnect and rejected pulls"
+expectpart "$(send_queue)" 0 "<rpc-error>" "is ongoing"
+
+sleep $sleep
+
+new "Restore transaction-queue-depth"
+expectpart "$($clixon_cli -1 -m configure -f $CFG delete devices transaction-queue-depth)" 0 "^$"
+
+new "commit local"
+expectpart "$($clixon_cli -1 -m configure -f $CFG commit local)" 0 "^$"
+
+if $BE; then
+    new "Kill old backend"
+    stop_backend -f $CFG
+fi
+
+endtest
@@ -0,0 +1,73 @@
+#!/usr/bin/env bash
+# Rate-limited connect scheduler
+# Reset devices and backend
+# 1. Set connect-max-inflight 1 and connect-rate 1, reconnect all devices
+#    Check that all devices are open and that connecting took at least (nr-1) seconds
+# 2. Close all devices and check no device is left in CONNECT-PENDING
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+set -u
+
+# Reset devices
+. ./reset-devices.sh
+
+if $BE; then
+    new "Kill old backend"
+    sudo clixon_backend -s init -f $CFG -z
+
+    new "Start new backend -s init -f $CFG"
+    start_backend -s init -f $CFG
+fi
+
+new "Wait backend"
+wait_backend
+
+# Reset controller
+. ./reset-controller.sh
+
+new "Set connect-max-inflight 1"
+expectpart "$($clixon_cli -1 -m configure -f $CFG set devices connect-max-inflight 1)" 0 "^$"
+
+new "Set connect-rate 1"
+expectpart "$($clixon_cli -1 -m configure -f $CFG set devices connect-rate 1)" 0 "^$"
+
+new "commit local"
+expectpart "$($clixon_cli -1 -m configure -f $CFG commit local)" 0 "^$"
+
+t0=$(date +%s)
+new "connection reconnect"
+expectpart "$($clixon_cli -1 -f $CFG connection reconnect)" 0 ""
+t1=$(date +%s)
+
+new "Check devices are open"
+expectpart "$($clixon_cli -1 -f $CFG show devices)" 0 "openconfig1.*OPEN" --not-- "CONNECT-PENDING"
+
+new "Check connects were rate limited"
+if [ $((t1-t0)) -lt $((nr-1)) ]; then
+    err1 "At least $((nr-1))s" "$((t1-t0))s"
+fi
+
+new "connection close"
+expectpart "$($clixon_cli -1 -f $CFG connection close)" 0 ""
+
+new "Check no device pending"
+expectpart "$($clixon_cli -1 -f $CFG show devices)" 0 "openconfig1.*CLOSED" --not-- "CONNECT-PENDING" "OPEN"
+
+new "Restore connect-max-inflight and connect-rate"
+expectpart "$($clixon_cli -1 -m configure -f $CFG delete devices connect-max-inflight)" 0 "^$"
+expectpart "$($clixon_cli -1 -m configure -f $CFG delete devices connect-rate)" 0 "^$"
+
+new "commit local"
+expectpart "$($clixon_cli -1 -m configure -f $CFG commit local)" 0 "^$"
+
+new "connection open"
+expectpart "$($clixon_cli -1 -f $CFG connection open)" 0 ""
+
+if $BE; then
+    new "Kill old backend"
+    stop_backend -f $CFG
+fi
+
+endtest
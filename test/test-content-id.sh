@@ -0,0 +1,66 @@
+#!/usr/bin/env bash
+# RFC 8525 content-id driven schema discovery
+# Reset devices and backend
+# 1. Connect and check the content-id of the devices, if announced
+# 2. Reconnect and check that schema discovery is skipped, ie no more SCHEMA-LIST samples
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+set -u
+
+# Reset devices
+. ./reset-devices.sh
+
+if $BE; then
+    new "Kill old backend"
+    sudo clixon_backend -s init -f $CFG -z
+
+    new "Start new backend -s init -f $CFG"
+    start_backend -s init -f $CFG
+fi
+
+new "Wait backend"
+wait_backend
+
+# Reset controller
+. ./reset-controller.sh
+
+new "Check devices are open"
+expectpart "$($clixon_cli -1 -f $CFG show devices)" 0 "openconfig1.*OPEN"
+
+ret=$($clixon_cli -1 -f $CFG show devices openconfig1 detail)
+match=$(echo "$ret" | grep --null -o "<content-id>") || true
+if [ -z "$match" ]; then
+    echo "Device does not announce yang-library content-id, skip"
+    if $BE; then
+        new "Kill old backend"
+        stop_backend -f $CFG
+    fi
+    endtest
+    if [ "$s" = $0 ]; then exit 0; else return 0; fi
+fi
+
+# Number of SCHEMA-LIST latency samples of first device
+function schema_list_samples()
+{
+    $clixon_cli -1 -f $CFG show devices openconfig1 detail | grep -A1 "<state>SCHEMA-LIST</state>" | grep -o "<samples>[0-9]*</samples>"
+}
+
+samples=$(schema_list_samples)
+
+new "connection reconnect"
+expectpart "$($clixon_cli -1 -f $CFG connection reconnect)" 0 ""
+
+new "Check devices are open"
+expectpart "$($clixon_cli -1 -f $CFG show devices)" 0 "openconfig1.*OPEN" "openconfig2.*OPEN"
+
+new "Check schema discovery is skipped on reconnect"
+expectpart "$(schema_list_samples)" 0 "^$samples$"
+
+if $BE; then
+    new "Kill old backend"
+    stop_backend -f $CFG
+fi
+
+endtest
@@ -0,0 +1,98 @@
+#!/usr/bin/env bash
+# Device state filtered by xpath
+# Reset devices and backend
+# 1. Get conn-state of one device, check no other devices and no capabilities
+#    Get conn-state of two devices, and devices selected by statistics predicate
+# 2. Get one device, check capabilities
+# 3. Get statistics of one device, check get-config round-trip time
+# 4. Get other state than devices, check no device state
+# 5. Get yang-library of devices, with and without dedup
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+set -u
+
+# Reset devices
+. ./reset-devices.sh
+
+if $BE; then
+    new "Kill old backend"
+    sudo clixon_backend -s init -f $CFG -z
+
+    new "Start new backend -s init -f $CFG"
+    start_backend -s init -f $CFG
+fi
+
+new "Wait backend"
+wait_backend
+
+# Reset controller
+. ./reset-controller.sh
+
+# Get state with xpath filter
+# 1: xpath
+function get_state()
+{
+    xpath=$1
+    ${clixon_netconf} -q0 -f $CFG <<EOF
+<rpc xmlns="urn:ietf:params:xml:ns:netconf:base:1.0" xmlns:nc="urn:ietf:params:xml:ns:netconf:base:1.0" message-id="42">
+   <get cl:content="nonconfig" xmlns:cl="http://clicon.org/lib">
+      <nc:filter nc:type="xpath" nc:select="$xpath" xmlns:co="http://clicon.org/controller"/>
+   </get>
+</rpc>]]>]]>
+EOF
+}
+
+new "Get conn-state of ${IMG}1"
+expectpart "$(get_state "co:devices/co:device[co:name='${IMG}1']/co:conn-state")" 0 "<name>${IMG}1</name><conn-state>OPEN</conn-state>" --not-- "<name>${IMG}2</name>" "<capabilities>" "<rpc-error>"
+
+new "Get ${IMG}1"
+expectpart "$(get_state "co:devices/co:device[co:name='${IMG}1']")" 0 "<name>${IMG}1</name><conn-state>OPEN</conn-state><capabilities><capability>" --not-- "<name>${IMG}2</name>" "<rpc-error>"
+
+new "Get all devices conn-state"
+expectpart "$(get_state "co:devices/co:device/co:conn-state")" 0 "<name>${IMG}1</name><conn-state>OPEN</conn-state>" --not-- "<capabilities>" "<statistics>" "<rpc-error>"
+
+if [ $nr -gt 1 ]; then
+    new "Get conn-state of ${IMG}1 or ${IMG}2"
+    expectpart "$(get_state "co:devices/co:device[co:name='${IMG}1' or co:name='${IMG}2']/co:conn-state")" 0 "<name>${IMG}1</name><conn-state>OPEN</conn-state>" "<name>${IMG}2</name><conn-state>OPEN</conn-state>" --not-- "<capabilities>" "<rpc-error>"
+fi
+
+new "Get name of devices with statistics"
+expectpart "$(get_state "co:devices/co:device[co:statistics/co:in-bytes>0]/co:name")" 0 "<name>${IMG}1</name>" --not-- "<rpc-error>"
+
+new "Get statistics of ${IMG}1"
+expectpart "$(get_state "co:devices/co:device[co:name='${IMG}1']/co:statistics")" 0 "<statistics><in-bytes>[1-9][0-9]*</in-bytes><out-bytes>[1-9][0-9]*</out-bytes>" "<parse-time><count>[1-9][0-9]*</count>" "<rpc><name>get-config</name><requests>[1-9][0-9]*</requests><round-trip-time><count>[1-9][0-9]*</count><min>[0-9]*</min><max>[0-9]*</max><mean>[0-9]*</mean><p50>[0-9]*</p50>" "<bucket><le>[0-9]*</le><count>[1-9][0-9]*</count></bucket>" --not-- "<name>${IMG}2</name>" "<capabilities>" "<rpc-error>"
+
+new "Get transactions"
+expectpart "$(get_state "co:transactions")" 0 "<transactions" --not-- "<conn-state>" "<rpc-error>"
+
+# Get device yang-library
+# 1: dedup
+function get_yanglib()
+{
+    dedup=$1
+    ${clixon_netconf} -q0 -f $CFG <<EOF
+<rpc xmlns="urn:ietf:params:xml:ns:netconf:base:1.0" message-id="42">
+   <get-device-yang-library xmlns="http://clicon.org/controller">
+      <devname>${IMG}*</devname>
+      <dedup>$dedup</dedup>
+   </get-device-yang-library>
+</rpc>]]>]]>
+EOF
+}
+
+new "Get yang-library"
+expectpart "$(get_yanglib false)" 0 "<name>${IMG}1</name><fingerprint>[0-9a-f]*</fingerprint><library><yang-library" "<module-set><name>mount</name>" --not-- "<rpc-error>" "<config>"
+
+if [ $nr -gt 1 ]; then
+    new "Get yang-library with dedup, only once"
+    expectpart "$(get_yanglib true)" 0 "<name>${IMG}1</name><fingerprint>[0-9a-f]*</fingerprint><library><yang-library" "<name>${IMG}2</name><fingerprint>[0-9a-f]*</fingerprint></device>" --not-- "<rpc-error>"
+fi
+
+if $BE; then
+    new "Kill old backend"
+    stop_backend -f $CFG
+fi
+
+endtest
@@ -0,0 +1,73 @@
+#!/usr/bin/env bash
+# Adaptive device timeouts
+# Reset devices and backend
+# 1. Check device latency state is recorded after connect
+# 2. Enable adaptive timeouts with device-timeout-max, pull several times
+#    and check that the timeout of DEVICE-SYNC is derived from latency and within bounds
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+set -u
+
+# Reset devices
+. ./reset-devices.sh
+
+if $BE; then
+    new "Kill old backend"
+    sudo clixon_backend -s init -f $CFG -z
+
+    new "Start new backend -s init -f $CFG"
+    start_backend -s init -f $CFG
+fi
+
+new "Wait backend"
+wait_backend
+
+# Reset controller
+. ./reset-controller.sh
+
+# Show latency of DEVICE-SYNC state of first device
+function sync_latency()
+{
+    $clixon_cli -1 -f $CFG show devices detail | grep -m 1 -A4 "<state>DEVICE-SYNC</state>" | tr -d " \n"
+}
+
+new "Check latency after connect"
+expectpart "$($clixon_cli -1 -f $CFG show devices detail)" 0 "<latency>" "<state>CONNECTING</state>" "<state>DEVICE-SYNC</state>"
+
+new "Check DEVICE-SYNC default timeout 60s"
+expectpart "$(sync_latency)" 0 "<samples>2</samples><ewma>[0-9]*</ewma><p99>[0-9]*</p99><timeout>60000</timeout>"
+
+new "Set device-timeout-min 1"
+expectpart "$($clixon_cli -1 -m configure -f $CFG set devices device-timeout-min 1)" 0 "^$"
+
+new "Set device-timeout-max 10"
+expectpart "$($clixon_cli -1 -m configure -f $CFG set devices device-timeout-max 10)" 0 "^$"
+
+new "commit local"
+expectpart "$($clixon_cli -1 -m configure -f $CFG commit local)" 0 "^$"
+
+new "Check timeout is bounded by max before enough samples"
+expectpart "$(sync_latency)" 0 "<samples>2</samples><ewma>[0-9]*</ewma><p99>[0-9]*</p99><timeout>10000</timeout>"
+
+for i in $(seq 1 4); do
+    new "pull $i"
+    expectpart "$($clixon_cli -1 -f $CFG pull 2>&1)" 0 "OK"
+done
+
+new "Check timeout is adapted to latency"
+expectpart "$(sync_latency)" 0 "<samples>6</samples>" --not-- "<timeout>10000</timeout>"
+
+new "Restore device-timeout-max"
+expectpart "$($clixon_cli -1 -m configure -f $CFG set devices device-timeout-max 0)" 0 "^$"
+
+new "commit local"
+expectpart "$($clixon_cli -1 -m configure -f $CFG commit local)" 0 "^$"
+
+if $BE; then
+    new "Kill old backend"
+    stop_backend -f $CFG
+fi
+
+endtest
@@ -0,0 +1,174 @@
+#!/usr/bin/env bash
+# Rolling push with canary wave and max-concurrent devices
+# Reset devices and backend
+# 1. Change hostname on all devices and push with canary 1 and max-concurrent 1
+#    Check one wave per device and that all devices are changed
+#    Check trace of transaction has transaction and device spans, with tracing enabled
+# 2. Change first device directly so it is out-of-sync and push with canary 1
+#    Check that the canary wave fails and no other device is changed
+# 3. Change last device directly so it is out-of-sync and commit candidate with
+#    max-concurrent 1. Check that the last wave fails and running is not changed
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+if [ $nr -lt 2 ]; then
+    echo "Test requires nr=$nr to be greater than 1"
+    if [ "$s" = $0 ]; then exit 0; else return 0; fi
+fi
+
+set -u
+
+# Reset devices
+. ./reset-devices.sh
+
+if $BE; then
+    new "Kill old backend"
+    sudo clixon_backend -s init -f $CFG -z
+
+    new "Start new backend -s init -f $CFG"
+    start_backend -s init -f $CFG
+fi
+
+new "Wait backend"
+wait_backend
+
+# Reset controller
+. ./reset-controller.sh
+
+new "Enable transaction trace"
+expectpart "$($clixon_cli -1 -f $CFG -m configure set devices transaction-trace true)" 0 "^$"
+
+new "Set hostname on openconfig*"
+expectpart "$($clixon_cli -1 -f $CFG -m configure 'set devices device openconfig* config system config hostname rolling')" 0 "^$"
+
+new "Local commit"
+expectpart "$($clixon_cli -1 -f $CFG -m configure commit local)" 0 "^$"
+
+new "Rolling push: canary 1 max-concurrent 1"
+expectpart "$($clixon_cli -1 -f $CFG push commit max-concurrent 1 canary 1 2>&1)" 0 "OK" --not-- "failed"
+
+new "Check one wave per device"
+expectpart "$($clixon_cli -1 -f $CFG show transaction)" 0 "<push-wave>$nr</push-wave>" "<result>SUCCESS</result>" --not-- "PUSH-QUEUE"
+
+tid=$($clixon_cli -1 -f $CFG show transaction | grep -o "<tid>[0-9]*</tid>" | grep -o "[0-9]*")
+
+new "Check trace of transaction $tid"
+expectpart "$($clixon_cli -1 -f $CFG show transactions trace $tid)" 0 '{"traceEvents":\[' '"name":"devices-diff","cat":"transaction","ph":"X"' '"args":{"name":"openconfig1"}' '"name":"PUSH-EDIT","cat":"device"' '"name":"diff","cat":"device"'
+
+for container in $CONTAINERS; do
+    new "Verify hostname on $container"
+    expectpart "$(ssh -l $USER $container clixon_cli -1 show configuration cli)" 0 "system config hostname rolling"
+done
+
+new "Check devices are open"
+expectpart "$($clixon_cli -1 -f $CFG show devices)" 0 "openconfig1.*OPEN" "openconfig2.*OPEN" --not-- "PUSH"
+
+new "Set hostname on openconfig*"
+expectpart "$($clixon_cli -1 -f $CFG -m configure 'set devices device openconfig* config system config hostname canary')" 0 "^$"
+
+new "Local commit"
+expectpart "$($clixon_cli -1 -f $CFG -m configure commit local)" 0 "^$"
+
+# Change first device directly, so it is out-of-sync and fails in the canary wave
+ip=$(echo $CONTAINERS | awk '{print $1}')
+new "Change hostname on first device"
+ret=$(ssh $ip -l ${USER} -o StrictHostKeyChecking=no -o PasswordAuthentication=no -s netconf <<EOF
+<?xml version="1.0" encoding="UTF-8"?>
+<hello xmlns="urn:ietf:params:xml:ns:netconf:base:1.0">
+   <capabilities>
+      <capability>urn:ietf:params:netconf:base:1.0</capability>
+   </capabilities>
+</hello>]]>]]>
+<rpc xmlns="urn:ietf:params:xml:ns:netconf:base:1.0" message-id="42">
+  <edit-config>
+    <target><candidate/></target>
+    <config>
+       <system xmlns="http://openconfig.net/yang/system">
+          <config>
+             <hostname>outofsync</hostname>
+          </config>
+       </system>
+    </config>
+  </edit-config>
+</rpc>]]>]]>
+<rpc xmlns="urn:ietf:params:xml:ns:netconf:base:1.0" message-id="43"><commit/></rpc>]]>]]>
+EOF
+   )
+match=$(echo $ret | grep --null -Eo "<rpc-error>") || true
+if [ -n "$match" ]; then
+    err1 "No rpc-error" "$ret"
+fi
+
+new "Rolling push with failing canary"
+expectpart "$($clixon_cli -1 -f $CFG push commit max-concurrent 1 canary 1 2>&1)" 0 "Transaction [0-9]* failed"
+
+new "Check first wave failed"
+expectpart "$($clixon_cli -1 -f $CFG show transaction)" 0 "<push-wave>1</push-wave>" "<result>FAILED</result>"
+
+i=1
+for container in $CONTAINERS; do
+    if [ $i -gt 1 ]; then
+        new "Verify hostname not pushed to $container"
+        expectpart "$(ssh -l $USER $container clixon_cli -1 show configuration cli)" 0 "system config hostname rolling" --not-- "hostname canary"
+    fi
+    i=$((i+1))
+done
+
+new "Check devices are open"
+expectpart "$($clixon_cli -1 -f $CFG show devices)" 0 "openconfig1.*OPEN" "openconfig2.*OPEN" --not-- "PUSH"
+
+new "Pull to sync first device"
+expectpart "$($clixon_cli -1 -f $CFG pull 2>&1)" 0 ""
+
+# Change last device directly, so it is out-of-sync and fails in the last wave
+ip=$(echo $CONTAINERS | awk '{print $NF}')
+new "Change hostname on last device"
+ret=$(ssh $ip -l ${USER} -o StrictHostKeyChecking=no -o PasswordAuthentication=no -s netconf <<EOF
+<?xml version="1.0" encoding="UTF-8"?>
+<hello xmlns="urn:ietf:params:xml:ns:netconf:base:1.0">
+   <capabilities>
+      <capability>urn:ietf:params:netconf:base:1.0</capability>
+   </capabilities>
+</hello>]]>]]>
+<rpc xmlns="urn:ietf:params:xml:ns:netconf:base:1.0" message-id="42">
+  <edit-config>
+    <target><candidate/></target>
+    <config>
+       <system xmlns="http://openconfig.net/yang/system">
+          <config>
+             <hostname>outofsync</hostname>
+          </config>
+       </system>
+    </config>
+  </edit-config>
+</rpc>]]>]]>
+<rpc xmlns="urn:ietf:params:xml:ns:netconf:base:1.0" message-id="43"><commit/></rpc>]]>]]>
+EOF
+   )
+match=$(echo $ret | grep --null -Eo "<rpc-error>") || true
+if [ -n "$match" ]; then
+    err1 "No rpc-error" "$ret"
+fi
+
+new "Set hostname lastwave on openconfig*"
+expectpart "$($clixon_cli -1 -f $CFG -m configure 'set devices device openconfig* config system config hostname lastwave')" 0 "^$"
+
+new "Commit candidate with failing last wave"
+expectpart "$($clixon_cli -1 -f $CFG -m configure commit push max-concurrent 1 2>&1)" 0 "Transaction [0-9]* failed"
+
+new "Check last wave failed"
+expectpart "$($clixon_cli -1 -f $CFG show transaction)" 0 "<push-wave>$nr</push-wave>" "<result>FAILED</result>"
+
+new "Check running is not changed"
+expectpart "$($clixon_cli -1 -f $CFG show configuration devices device openconfig1 config system)" 0 --not-- "lastwave"
+
+new "Discard candidate"
+expectpart "$($clixon_cli -1 -f $CFG -m configure discard)" 0 ""
+
+if $BE; then
+    new "Kill old backend"
+    stop_backend -f $CFG
+fi
+
+endtest
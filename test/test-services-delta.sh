@@ -0,0 +1,235 @@
+#!/usr/bin/env bash
+# Delta services-commit notifications using util/clixon_controller_service.c
+# With services-commit-delta set, the changed service instances and the devices of the
+# transaction are inlined in the notification, and the action daemon does not read them
+# 1. Add, change and remove service params and check device config
+# 2. Change service of two devices with only one device in transaction, check the other
+#    device keeps its service config
+# 3. Apply all services (no service entry in notification)
+# 4. Delete service instance (not inlined) and check its device config is removed
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+dir=/var/tmp/$0
+CFG=$dir/controller.xml
+CFD=$dir/confdir
+test -d $dir || mkdir -p $dir
+test -d $CFD || mkdir -p $CFD
+
+fyang=$dir/myyang.yang
+
+# source IMG/USER etc
+. ./site.sh
+
+cat<<EOF > $CFG
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$CFG</CLICON_CONFIGFILE>
+  <CLICON_CONFIGDIR>$CFD</CLICON_CONFIGDIR>
+  <CLICON_FEATURE>ietf-netconf:startup</CLICON_FEATURE>
+  <CLICON_FEATURE>clixon-restconf:allow-auth-none</CLICON_FEATURE>
+  <CLICON_CONFIG_EXTEND>clixon-controller-config</CLICON_CONFIG_EXTEND>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_DIR>$dir</CLICON_YANG_MAIN_DIR>
+  <CLICON_CLI_MODE>operation</CLICON_CLI_MODE>
+  <CLICON_CLI_DIR>${LIBDIR}/controller/cli</CLICON_CLI_DIR>
+  <CLICON_CLISPEC_DIR>${LIBDIR}/controller/clispec</CLICON_CLISPEC_DIR>
+  <CLICON_BACKEND_DIR>${LIBDIR}/controller/backend</CLICON_BACKEND_DIR>
+  <CLICON_SOCK>${LOCALSTATEDIR}/run/controller.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>${LOCALSTATEDIR}/run/controller.pid</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_STARTUP_MODE>init</CLICON_STARTUP_MODE>
+  <CLICON_STREAM_DISCOVERY_RFC5277>true</CLICON_STREAM_DISCOVERY_RFC5277>
+  <CLICON_BACKEND_USER>${CLICON_USER}</CLICON_BACKEND_USER>
+  <CLICON_SOCK_GROUP>${CLICON_GROUP}</CLICON_SOCK_GROUP>
+  <CLICON_VALIDATE_STATE_XML>true</CLICON_VALIDATE_STATE_XML>
+  <CLICON_CLI_HELPSTRING_TRUNCATE>true</CLICON_CLI_HELPSTRING_TRUNCATE>
+  <CLICON_CLI_HELPSTRING_LINES>1</CLICON_CLI_HELPSTRING_LINES>
+  <CLICON_YANG_SCHEMA_MOUNT>true</CLICON_YANG_SCHEMA_MOUNT>
+</clixon-config>
+EOF
+
+cat<<EOF > $CFD/action-command.xml
+<clixon-config xmlns="http://clicon.org/config">
+  <CONTROLLER_ACTION_COMMAND xmlns="http://clicon.org/controller-config">${BINDIR}/clixon_controller_service -f $CFG</CONTROLLER_ACTION_COMMAND>
+</clixon-config>
+EOF
+
+cat<<EOF > $CFD/autocli.xml
+<clixon-config xmlns="http://clicon.org/config">
+  <autocli>
+     <module-default>false</module-default>
+     <list-keyword-default>kw-nokey</list-keyword-default>
+     <treeref-state-default>true</treeref-state-default>
+     <grouping-treeref>true</grouping-treeref>
+     <rule>
+       <name>include controller</name>
+       <module-name>clixon-controller</module-name>
+       <operation>enable</operation>
+     </rule>
+     <rule>
+       <name>include openconfig</name>
+       <module-name>openconfig*</module-name>
+       <operation>enable</operation>
+     </rule>
+  </autocli>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module myyang {
+    yang-version 1.1;
+    namespace "urn:example:test";
+    prefix test;
+    import clixon-controller {
+      prefix ctrl;
+    }
+    revision 2023-03-22{
+	description "Initial prototype";
+    }
+    augment "/ctrl:services" {
+	list testA {
+	    key name;
+	    leaf name {
+		type string;
+	    }
+	    description "Test service A";
+	    leaf-list params{
+	       type string;
+	    }
+            uses ctrl:created-by-service;
+	}
+    }
+}
+EOF
+
+cat <<EOF > $dir/startup_db
+<config>
+  <processes xmlns="http://clicon.org/controller">
+    <services>
+      <enabled>true</enabled>
+    </services>
+  </processes>
+</config>
+EOF
+
+# Reset devices with initial config
+. ./reset-devices.sh
+
+if $BE; then
+    new "Kill old backend $CFG"
+    sudo clixon_backend -f $CFG -z
+
+    new "Start new backend -s startup -f $CFG"
+    start_backend -s startup -f $CFG
+fi
+
+new "Wait backend"
+wait_backend
+
+# Reset controller by initiating with clixon/openconfig devices and a pull
+. ./reset-controller.sh
+
+new "Set services-commit-delta"
+expectpart "$(${clixon_cli} -m configure -1f $CFG set devices services-commit-delta true)" 0 "^$"
+
+new "commit local"
+expectpart "$(${clixon_cli} -m configure -1f $CFG commit local)" 0 "^$"
+
+new "Add Sx"
+expectpart "$(${clixon_cli} -m configure -1f $CFG set services testA foo params Sx)" 0 "^$"
+
+new "Add Sy"
+expectpart "$(${clixon_cli} -m configure -1f $CFG set services testA foo params Sy)" 0 "^$"
+
+new "commit add"
+expectpart "$(${clixon_cli} -m configure -1f $CFG commit 2>&1)" 0 "OK"
+
+for i in $(seq 1 $nr); do
+    new "Check Sx and Sy on openconfig$i"
+    expectpart "$(${clixon_cli} -1f $CFG show configuration devices device openconfig$i config interfaces)" 0 "<name>Sx</name>" "<name>Sy</name>"
+done
+
+new "remove Sy"
+expectpart "$(${clixon_cli} -m configure -1f $CFG delete services testA foo params Sy)" 0 "^$"
+
+new "commit remove"
+expectpart "$(${clixon_cli} -m configure -1f $CFG commit 2>&1)" 0 "OK"
+
+new "Check Sx and not Sy"
+expectpart "$(${clixon_cli} -1f $CFG show configuration devices device openconfig1 config interfaces)" 0 "<name>Sx</name>" --not-- "<name>Sy</name>"
+
+if [ $nr -gt 1 ]; then
+    new "Add Sz"
+    expectpart "$(${clixon_cli} -m configure -1f $CFG set services testA foo params Sz)" 0 "^$"
+
+    new "commit Sz to openconfig1 only"
+    ret=$(${clixon_netconf} -q0 -f $CFG <<EOF
+<rpc xmlns="urn:ietf:params:xml:ns:netconf:base:1.0" message-id="43">
+  <controller-commit xmlns="http://clicon.org/controller">
+    <device>openconfig1</device>
+    <push>COMMIT</push>
+    <actions>CHANGE</actions>
+    <source>ds:candidate</source>
+  </controller-commit>
+</rpc>]]>]]>
+EOF
+       )
+    match=$(echo $ret | grep --null -Eo "<rpc-error>") || true
+    if [ -n "$match" ]; then
+        err1 "no rpc-error" "$ret"
+    fi
+
+    sleep $sleep
+
+    new "Check Sx and Sz on openconfig1"
+    expectpart "$(${clixon_cli} -1f $CFG show configuration devices device openconfig1 config interfaces)" 0 "<name>Sx</name>" "<name>Sz</name>"
+
+    new "Check Sx on openconfig2 is kept"
+    expectpart "$(${clixon_cli} -1f $CFG show configuration devices device openconfig2 config interfaces)" 0 "<name>Sx</name>" --not-- "<name>Sz</name>"
+
+    new "Check created paths of both devices"
+    ret=$(${clixon_netconf} -q0 -f $CFG <<EOF
+<rpc xmlns="urn:ietf:params:xml:ns:netconf:base:1.0" message-id="43">
+  <get-config>
+    <source><running/></source>
+    <filter type='subtree'>
+      <services xmlns="http://clicon.org/controller">
+        <testA xmlns="urn:example:test">
+          <name>foo</name>
+        </testA>
+      </services>
+    </filter>
+  </get-config>
+</rpc>]]>]]>
+EOF
+       )
+    for d in openconfig1 openconfig2; do
+        match=$(echo $ret | grep --null -Eo "<path>/devices/device\[name=[\"']$d[\"']\]/config/interfaces/interface\[name=[\"']Sx[\"']\]</path>") || true
+        if [ -z "$match" ]; then
+            err1 "created path of Sx on $d" "$ret"
+        fi
+    done
+fi
+
+new "apply all services"
+expectpart "$(${clixon_cli} -m configure -1f $CFG apply services 2>&1)" 0 "OK"
+
+new "Check Sx after apply"
+expectpart "$(${clixon_cli} -1f $CFG show configuration devices device openconfig1 config interfaces)" 0 "<name>Sx</name>"
+
+new "delete service"
+expectpart "$(${clixon_cli} -m configure -1f $CFG delete services testA foo)" 0 "^$"
+
+new "commit delete"
+expectpart "$(${clixon_cli} -m configure -1f $CFG commit 2>&1)" 0 "OK"
+
+new "Check not Sx"
+expectpart "$(${clixon_cli} -1f $CFG show configuration devices device openconfig1 config interfaces)" 0 --not-- "<name>Sx</name>"
+
+if $BE; then
+    new "Kill old backend"
+    stop_backend -f $CFG
+fi
+
+endtest
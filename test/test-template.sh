@@ -1,6 +1,8 @@
 #!/usr/bin/env bash
 # Load a template and apply it via XML and check compare
 # Reset and load a template and apply if via CLI
+# Apply compiled template again with other values, and after template is changed
+# Apply template failing YANG binding, check devices are reported
 
 # Magic line must be first in script (see README.md)
 s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
@@ -165,6 +167,88 @@ expectpart "$($clixon_cli -1 -f $CFG -m configure apply template interfaces open
 new "Verify compare 2"
 expectpart "$($clixon_cli -1 -f $CFG -m configure show compare)" 0 "^+\ *interface z {" "^+\ *type ianaift:v35;" "^+\ *description \"Config of interface z,z and ianaift:v35 type\";" --not-- "^\-" 
 
+new "rollback"
+expectpart "$($clixon_cli -1 -f $CFG -m configure rollback)" 0 "^$"
+
+new "Apply template CLI other values"
+expectpart "$($clixon_cli -1 -f $CFG -m configure apply template interfaces openconfig* variables NAME y TYPE ianaift:v35)" 0 "^$"
+
+new "Verify compare 3"
+expectpart "$($clixon_cli -1 -f $CFG -m configure show compare)" 0 "^+\ *interface y {" "^+\ *description \"Config of interface y,y and ianaift:v35 type\";" --not-- "^\-" "interface z"
+
+new "rollback"
+expectpart "$($clixon_cli -1 -f $CFG -m configure rollback)" 0 "^$"
+
+new "change template"
+ret=$(${clixon_cli} -1f $CFG -m configure load merge xml <<'EOF'
+      <config>
+         <devices xmlns="http://clicon.org/controller">
+            <template nc:operation="replace">
+               <name>interfaces</name>
+               <config>
+                  <interfaces xmlns="http://openconfig.net/yang/interfaces">
+                     <interface>
+                        <name>${NAME}</name>
+                        <config>
+                           <name>${NAME}</name>
+                           <type xmlns:ianaift="urn:ietf:params:xml:ns:yang:iana-if-type">${TYPE}</type>
+                           <description>Changed ${NAME}</description>
+                        </config>
+                     </interface>
+                  </interfaces>
+               </config>
+            </template>
+         </devices>
+      </config>
+EOF
+)
+
+if [ -n "$ret" ]; then
+    err1 "$ret"
+    exit 1
+fi
+
+new "commit changed template local"
+expectpart "$($clixon_cli -1f $CFG -m configure commit local 2>&1)" 0 "^$"
+
+new "Apply changed template CLI"
+expectpart "$($clixon_cli -1 -f $CFG -m configure apply template interfaces openconfig* variables NAME x TYPE ianaift:v35)" 0 "^$"
+
+new "Verify compare 4"
+expectpart "$($clixon_cli -1 -f $CFG -m configure show compare)" 0 "^+\ *interface x {" "^+\ *description \"Changed x\";" --not-- "^\-" "Config of interface"
+
+new "rollback"
+expectpart "$($clixon_cli -1 -f $CFG -m configure rollback)" 0 "^$"
+
+new "load template failing bind"
+ret=$(${clixon_cli} -1f $CFG -m configure load merge xml <<'EOF'
+      <config>
+         <devices xmlns="http://clicon.org/controller">
+            <template nc:operation="replace">
+               <name>unknown</name>
+               <config>
+                  <unknown xmlns="urn:example:unknown">${NAME}</unknown>
+               </config>
+            </template>
+         </devices>
+      </config>
+EOF
+)
+
+if [ -n "$ret" ]; then
+    err1 "$ret"
+    exit 1
+fi
+
+new "commit template local"
+expectpart "$($clixon_cli -1f $CFG -m configure commit local 2>&1)" 0 "^$"
+
+new "Apply template failing bind"
+expectpart "$($clixon_cli -1 -f $CFG -m configure apply template unknown openconfig* variables NAME x 2>&1)" 0 "Template not applied on openconfig1"
+
+new "Verify no compare"
+expectpart "$($clixon_cli -1 -f $CFG -m configure show compare)" 0 --not-- "unknown"
+
 if $BE; then
     new "Kill old backend"
     stop_backend -f $CFG
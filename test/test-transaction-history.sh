@@ -0,0 +1,84 @@
+#!/usr/bin/env bash
+# Bounded transaction history and transaction state filtered by xpath
+# Reset devices and backend
+# 1. Set transaction-history-max to 2, make three pulls and check only two transactions are kept
+# 2. Get single transaction and transactions after a tid with xpath
+# 3. Get device state, check no transaction state
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+set -u
+
+# Reset devices
+. ./reset-devices.sh
+
+if $BE; then
+    new "Kill old backend"
+    sudo clixon_backend -s init -f $CFG -z
+
+    new "Start new backend -s init -f $CFG"
+    start_backend -s init -f $CFG
+fi
+
+new "Wait backend"
+wait_backend
+
+# Reset controller
+. ./reset-controller.sh
+
+# Get state with xpath filter
+# 1: xpath
+function get_state()
+{
+    xpath=$1
+    ${clixon_netconf} -q0 -f $CFG <<EOF
+<rpc xmlns="urn:ietf:params:xml:ns:netconf:base:1.0" xmlns:nc="urn:ietf:params:xml:ns:netconf:base:1.0" message-id="42">
+   <get cl:content="nonconfig" xmlns:cl="http://clicon.org/lib">
+      <nc:filter nc:type="xpath" nc:select="$xpath" xmlns:co="http://clicon.org/controller"/>
+   </get>
+</rpc>]]>]]>
+EOF
+}
+
+new "Set transaction-history-max 2"
+expectpart "$($clixon_cli -1 -m configure -f $CFG set devices transaction-history-max 2)" 0 "^$"
+
+new "commit local"
+expectpart "$($clixon_cli -1 -m configure -f $CFG commit local)" 0 "^$"
+
+for i in 1 2 3; do
+    new "pull $i"
+    expectpart "$($clixon_cli -1 -f $CFG pull 2>&1)" 0 "OK"
+done
+
+new "Check two transactions kept"
+ret=$($clixon_cli -1 -f $CFG show transactions all | grep -c "<tid>")
+if [ $ret -ne 2 ]; then
+    err "2" "$ret"
+fi
+
+tid=$($clixon_cli -1 -f $CFG show transaction | grep -o "<tid>[0-9]*</tid>" | grep -o "[0-9]*")
+prev=$((tid-1))
+
+new "Get transaction $tid"
+expectpart "$(get_state "co:transactions/co:transaction[co:tid='$tid']")" 0 "<tid>$tid</tid>" "<result>SUCCESS</result>" --not-- "<tid>$prev</tid>" "<rpc-error>"
+
+new "Get transactions after $prev"
+expectpart "$(get_state "co:transactions/co:transaction[co:tid>$prev]")" 0 "<tid>$tid</tid>" --not-- "<tid>$prev</tid>" "<rpc-error>"
+
+new "Get device state, no transactions"
+expectpart "$(get_state "co:devices/co:device/co:conn-state")" 0 "<conn-state>OPEN</conn-state>" --not-- "<transactions" "<rpc-error>"
+
+new "Restore transaction-history-max"
+expectpart "$($clixon_cli -1 -m configure -f $CFG delete devices transaction-history-max)" 0 "^$"
+
+new "commit local"
+expectpart "$($clixon_cli -1 -m configure -f $CFG commit local)" 0 "^$"
+
+if $BE; then
+    new "Kill old backend"
+    stop_backend -f $CFG
+fi
+
+endtest
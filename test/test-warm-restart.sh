@@ -0,0 +1,128 @@
+#!/usr/bin/env bash
+# Warm restart from persisted device state
+# Reset devices and backend
+# 1. Enable warm-restart and reconnect so that device state is persisted
+# 2. Restart backend from running and connect
+#    Check devices are open without schema discovery (no SCHEMA-LIST latency)
+# 3. Change config on first device, restart backend and connect
+#    Check drift is detected and the change is synced
+# 4. Change device config locally in running, restart backend and connect
+#    Check the local change is detected and running is synced from the device
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+if ! $BE; then
+    echo "Test requires backend restart"
+    if [ "$s" = $0 ]; then exit 0; else return 0; fi
+fi
+
+set -u
+
+# Reset devices
+. ./reset-devices.sh
+
+new "Kill old backend"
+sudo clixon_backend -s init -f $CFG -z
+
+new "Start new backend -s init -f $CFG"
+start_backend -s init -f $CFG
+
+new "Wait backend"
+wait_backend
+
+# Reset controller
+. ./reset-controller.sh
+
+new "Set warm-restart"
+expectpart "$($clixon_cli -1 -m configure -f $CFG set devices warm-restart true)" 0 "^$"
+
+new "commit local"
+expectpart "$($clixon_cli -1 -m configure -f $CFG commit local)" 0 "^$"
+
+new "connection reconnect, persist state"
+expectpart "$($clixon_cli -1 -f $CFG connection reconnect)" 0 ""
+
+new "Check devices are open"
+expectpart "$($clixon_cli -1 -f $CFG show devices)" 0 "openconfig1.*OPEN"
+
+# Restart backend from running and connect all devices
+function restart_connect()
+{
+    new "Kill old backend"
+    sudo clixon_backend -f $CFG -z
+
+    new "Start new backend -s running -f $CFG"
+    start_backend -s running -f $CFG
+
+    new "Wait backend"
+    wait_backend
+
+    new "connection open"
+    expectpart "$($clixon_cli -1 -f $CFG connection open)" 0 ""
+
+    new "Check devices are open"
+    expectpart "$($clixon_cli -1 -f $CFG show devices)" 0 "openconfig1.*OPEN" "openconfig2.*OPEN"
+}
+
+restart_connect
+
+new "Check schema discovery is skipped"
+expectpart "$($clixon_cli -1 -f $CFG show devices openconfig1 detail)" 0 "<state>DEVICE-SYNC</state>" --not-- "<state>SCHEMA-LIST</state>"
+
+# Change first device directly, so that its config has drifted
+ip=$(echo $CONTAINERS | awk '{print $1}')
+new "Change hostname on first device"
+ret=$(ssh $ip -l ${USER} -o StrictHostKeyChecking=no -o PasswordAuthentication=no -s netconf <<EOF
+<?xml version="1.0" encoding="UTF-8"?>
+<hello xmlns="urn:ietf:params:xml:ns:netconf:base:1.0">
+   <capabilities>
+      <capability>urn:ietf:params:netconf:base:1.0</capability>
+   </capabilities>
+</hello>]]>]]>
+<rpc xmlns="urn:ietf:params:xml:ns:netconf:base:1.0" message-id="42">
+  <edit-config>
+    <target><candidate/></target>
+    <config>
+       <system xmlns="http://openconfig.net/yang/system">
+          <config>
+             <hostname>drifted</hostname>
+          </config>
+       </system>
+    </config>
+  </edit-config>
+</rpc>]]>]]>
+<rpc xmlns="urn:ietf:params:xml:ns:netconf:base:1.0" message-id="43"><commit/></rpc>]]>]]>
+EOF
+   )
+match=$(echo $ret | grep --null -Eo "<rpc-error>") || true
+if [ -n "$match" ]; then
+    err1 "No rpc-error" "$ret"
+fi
+
+restart_connect
+
+new "Check drifted config is synced"
+expectpart "$($clixon_cli -1 -f $CFG show configuration devices device openconfig1 config system config hostname)" 0 "drifted"
+
+new "Change hostname of first device locally"
+expectpart "$($clixon_cli -1 -m configure -f $CFG set devices device openconfig1 config system config hostname localonly)" 0 "^$"
+
+new "commit local"
+expectpart "$($clixon_cli -1 -m configure -f $CFG commit local)" 0 "^$"
+
+restart_connect
+
+new "Check running is synced from device"
+expectpart "$($clixon_cli -1 -f $CFG show configuration devices device openconfig1 config system config hostname)" 0 "drifted" --not-- "localonly"
+
+new "Restore warm-restart"
+expectpart "$($clixon_cli -1 -m configure -f $CFG set devices warm-restart false)" 0 "^$"
+
+new "commit local"
+expectpart "$($clixon_cli -1 -m configure -f $CFG commit local)" 0 "^$"
+
+new "Kill old backend"
+stop_backend -f $CFG
+
+endtest
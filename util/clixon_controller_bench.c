@@ -0,0 +1,451 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+
+  Copyright (C) 2023 Olof Hagsand
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  ***** END LICENSE BLOCK *****
+  * Benchmark of controller service actions
+  * Trigger controller-commit with forced actions and no push, and measure the time until the
+  * transaction terminates, ie mainly the actions phase, against number of devices.
+  * Alternatively (-e) measure edit-config of creator-tagged entries.
+  * Run with different number of devices, eg by varying the device pattern or nr of devices.
+  * Example, with a services daemon and service config in place:
+  *   clixon_controller_bench -f /usr/local/etc/clixon/controller.xml -n 10 -d "openconfig*"
+  *   clixon_controller_bench -f /usr/local/etc/clixon/controller.xml -e 100000
+ */
+
+#include <unistd.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <inttypes.h>
+#include <syslog.h>
+#include <fnmatch.h>
+#include <errno.h>
+#include <sys/time.h>
+
+#include <cligen/cligen.h>
+#include <clixon/clixon.h>
+
+#define CONTROLLER_NAMESPACE "http://clicon.org/controller"
+
+/* Command line options to be passed to getopt(3) */
+#define BENCH_OPTS "hD:f:l:n:d:s:e:c:"
+
+/*! Count configured devices in running matching pattern
+ *
+ * @param[in]  h        Clixon handle
+ * @param[in]  pattern  Glob of device names
+ * @param[out] nr       Number of matching devices
+ * @retval     0        OK
+ * @retval    -1        Error
+ */
+static int
+bench_devices_nr(clixon_handle h,
+                 char         *pattern,
+                 int          *nr)
+{
+    int                retval = -1;
+    cxobj             *xt = NULL;
+    cxobj            **vec = NULL;
+    size_t             veclen;
+    struct clicon_msg *msg = NULL;
+    cbuf              *cb = NULL;
+    char              *name;
+    int                i;
+
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_XML, errno, "cbuf_new");
+        goto done;
+    }
+    cprintf(cb, "<rpc xmlns=\"%s\"", NETCONF_BASE_NAMESPACE);
+    cprintf(cb, " xmlns:%s=\"%s\"",
+            NETCONF_BASE_PREFIX, NETCONF_BASE_NAMESPACE);
+    cprintf(cb, " %s", NETCONF_MESSAGE_ID_ATTR);
+    cprintf(cb, ">");
+    cprintf(cb, "<get-config>");
+    cprintf(cb, "<source><running/></source>");
+    cprintf(cb, "<%s:filter %s:type=\"xpath\" %s:select=\"ctrl:devices/ctrl:device/ctrl:name\" xmlns:ctrl=\"%s\"",
+            NETCONF_BASE_PREFIX, NETCONF_BASE_PREFIX, NETCONF_BASE_PREFIX,
+            CONTROLLER_NAMESPACE);
+    cprintf(cb, "/>");
+    cprintf(cb, "</get-config></rpc>");
+    if ((msg = clicon_msg_encode(0, "%s", cbuf_get(cb))) == NULL)
+        goto done;
+    if (clicon_rpc_msg(h, msg, &xt) < 0)
+        goto done;
+    if (xpath_first(xt,  NULL, "rpc-reply/rpc-error") != NULL){
+        clixon_err(OE_NETCONF, 0, "rpc-error");
+        goto done;
+    }
+    if (xpath_vec(xt, NULL, "rpc-reply/data/devices/device/name", &vec, &veclen) < 0)
+        goto done;
+    *nr = 0;
+    for (i=0; i<veclen; i++){
+        if ((name = xml_body(vec[i])) == NULL)
+            continue;
+        if (fnmatch(pattern, name, 0) == 0)
+            (*nr)++;
+    }
+    retval = 0;
+ done:
+    if (vec)
+        free(vec);
+    if (cb)
+        cbuf_free(cb);
+    if (msg)
+        free(msg);
+    if (xt)
+        xml_free(xt);
+    return retval;
+}
+
+/*! Send controller-commit with forced actions and wait for transaction notification
+ *
+ * @param[in]  h        Clixon handle
+ * @param[in]  s        Notification socket of controller-transaction stream
+ * @param[in]  pattern  Glob of device names
+ * @param[in]  service  Service instance, or NULL for all
+ * @param[out] ms       Time in ms from request until transaction terminated
+ * @retval     0        OK
+ * @retval    -1        Error
+ */
+static int
+bench_commit(clixon_handle h,
+             int           s,
+             char         *pattern,
+             char         *service,
+             uint64_t     *ms)
+{
+    int                retval = -1;
+    cbuf              *cb = NULL;
+    struct clicon_msg *msg = NULL;
+    struct clicon_msg *reply = NULL;
+    cxobj             *xt = NULL;
+    cxobj             *xn;
+    char              *tidstr0;
+    char              *tidstr;
+    char              *result;
+    char              *reason;
+    int                eof = 0;
+    int                ret;
+    struct timeval     t0;
+    struct timeval     t1;
+    struct timeval     td;
+
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_XML, errno, "cbuf_new");
+        goto done;
+    }
+    cprintf(cb, "<rpc xmlns=\"%s\" %s>", NETCONF_BASE_NAMESPACE, NETCONF_MESSAGE_ID_ATTR);
+    cprintf(cb, "<controller-commit xmlns=\"%s\">", CONTROLLER_NAMESPACE);
+    cprintf(cb, "<device>");
+    xml_chardata_cbuf_append(cb, pattern);
+    cprintf(cb, "</device>");
+    cprintf(cb, "<push>NONE</push>");
+    cprintf(cb, "<actions>FORCE</actions>");
+    if (service){
+        cprintf(cb, "<service-instance>");
+        xml_chardata_cbuf_append(cb, service);
+        cprintf(cb, "</service-instance>");
+    }
+    cprintf(cb, "<source>ds:candidate</source>");
+    cprintf(cb, "</controller-commit>");
+    cprintf(cb, "</rpc>");
+    if ((msg = clicon_msg_encode(0, "%s", cbuf_get(cb))) == NULL)
+        goto done;
+    gettimeofday(&t0, NULL);
+    if (clicon_rpc_msg(h, msg, &xt) < 0)
+        goto done;
+    if (xpath_first(xt,  NULL, "rpc-reply/rpc-error") != NULL){
+        clixon_err(OE_NETCONF, 0, "rpc-error");
+        goto done;
+    }
+    if ((xn = xpath_first(xt, NULL, "rpc-reply/tid")) == NULL ||
+        (tidstr0 = xml_body(xn)) == NULL){
+        clixon_err(OE_NETCONF, 0, "No returned tid");
+        goto done;
+    }
+    if ((tidstr0 = strdup(tidstr0)) == NULL){
+        clixon_err(OE_UNIX, errno, "strdup");
+        goto done;
+    }
+    xml_free(xt);
+    xt = NULL;
+    /* Wait for controller-transaction notification of this tid */
+    while (1){
+        if (clicon_msg_rcv(s, NULL, 0, &reply, &eof) < 0)
+            break;
+        if (eof){
+            clixon_err(OE_PROTO, ESHUTDOWN, "Socket unexpected close");
+            break;
+        }
+        if ((ret = clicon_msg_decode(reply, NULL, NULL, &xt, NULL)) < 0)
+            break;
+        free(reply);
+        reply = NULL;
+        if (ret == 1 &&
+            (xn = xpath_first(xt, 0, "notification/controller-transaction")) != NULL &&
+            (tidstr = xml_find_body(xn, "tid")) != NULL &&
+            strcmp(tidstr, tidstr0) == 0){
+            gettimeofday(&t1, NULL);
+            timersub(&t1, &t0, &td);
+            *ms = td.tv_sec*1000 + td.tv_usec/1000;
+            if ((result = xml_find_body(xn, "result")) == NULL || strcmp(result, "SUCCESS") != 0){
+                reason = xml_find_body(xn, "reason");
+                clixon_err(OE_NETCONF, 0, "Transaction %s %s: %s", tidstr0,
+                           result?result:"no result", reason?reason:"no reason");
+                break;
+            }
+            retval = 0;
+            break;
+        }
+        xml_free(xt);
+        xt = NULL;
+    }
+    free(tidstr0);
+ done:
+    if (reply)
+        free(reply);
+    if (cb)
+        cbuf_free(cb);
+    if (msg)
+        free(msg);
+    if (xt)
+        xml_free(xt);
+    return retval;
+}
+
+/*! Send edit-config of creator-tagged entries to candidate, then discard
+ *
+ * Each entry is a device-group tagged with a creator attribute, which the controller
+ * edit-config wrapper adds as a created path to the service instance
+ * @param[in]  h        Clixon handle
+ * @param[in]  nr       Number of tagged entries
+ * @param[in]  creator  Creator tag, a service instance, eg testA[name='foo']
+ * @param[out] ms       Time in ms of edit-config request
+ * @retval     0        OK
+ * @retval    -1        Error
+ */
+static int
+bench_edit(clixon_handle h,
+           int           nr,
+           char         *creator,
+           uint64_t     *ms)
+{
+    int                retval = -1;
+    cbuf              *cb = NULL;
+    struct clicon_msg *msg = NULL;
+    cxobj             *xt = NULL;
+    int                i;
+    struct timeval     t0;
+    struct timeval     t1;
+    struct timeval     td;
+
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_XML, errno, "cbuf_new");
+        goto done;
+    }
+    cprintf(cb, "<rpc xmlns=\"%s\"", NETCONF_BASE_NAMESPACE);
+    cprintf(cb, " xmlns:%s=\"%s\"",
+            NETCONF_BASE_PREFIX, NETCONF_BASE_NAMESPACE);
+    cprintf(cb, " %s", NETCONF_MESSAGE_ID_ATTR);
+    cprintf(cb, ">");
+    cprintf(cb, "<edit-config>");
+    cprintf(cb, "<target><candidate/></target>");
+    cprintf(cb, "<config>");
+    cprintf(cb, "<devices xmlns=\"%s\" xmlns:%s=\"%s\">",
+            CONTROLLER_NAMESPACE, CLIXON_LIB_PREFIX, CLIXON_LIB_NS);
+    for (i=0; i<nr; i++){
+        cprintf(cb, "<device-group %s:creator=\"", CLIXON_LIB_PREFIX);
+        xml_chardata_cbuf_append(cb, creator);
+        cprintf(cb, "\">");
+        cprintf(cb, "<name>bench%d</name>", i);
+        cprintf(cb, "</device-group>");
+    }
+    cprintf(cb, "</devices>");
+    cprintf(cb, "</config>");
+    cprintf(cb, "</edit-config></rpc>");
+    if ((msg = clicon_msg_encode(0, "%s", cbuf_get(cb))) == NULL)
+        goto done;
+    gettimeofday(&t0, NULL);
+    if (clicon_rpc_msg(h, msg, &xt) < 0)
+        goto done;
+    gettimeofday(&t1, NULL);
+    if (xpath_first(xt,  NULL, "rpc-reply/rpc-error") != NULL){
+        clixon_err(OE_NETCONF, 0, "rpc-error");
+        goto done;
+    }
+    timersub(&t1, &t0, &td);
+    *ms = td.tv_sec*1000 + td.tv_usec/1000;
+    if (clicon_rpc_discard_changes(h) < 0)
+        goto done;
+    retval = 0;
+ done:
+    if (cb)
+        cbuf_free(cb);
+    if (msg)
+        free(msg);
+    if (xt)
+        xml_free(xt);
+    return retval;
+}
+
+/*! Usage
+ */
+static void
+usage(clixon_handle h,
+      char         *argv0)
+{
+    fprintf(stderr, "usage:%s <options>*\n"
+            "where options are\n"
+            "\t-h\t\tHelp\n"
+            "\t-D <level>\tDebug level\n"
+            "\t-f <file> \tConfig-file (mandatory)\n"
+            "\t-l <s|e|o|n|f<file>> \tLog on (s)yslog, std(e)rr, std(o)ut, (n)one or (f)ile (stderr is default)\n"
+            "\t-n <nr> \tNumber of iterations (default 1)\n"
+            "\t-d <pattern> \tGlob pattern of devices (default *)\n"
+            "\t-s <instance> \tService instance, eg testA[name='foo'] (default all)\n"
+            "\t-e <nr> \tInstead of actions, measure edit-config of <nr> creator-tagged entries, eg 100000\n"
+            "\t-c <creator> \tCreator tag of edit entries (default testA[name='bench'])\n",
+            argv0
+            );
+    exit(-1);
+}
+
+int
+main(int    argc,
+     char **argv)
+{
+    int           retval = -1;
+    int           c;
+    int           dbg = 0;
+    int           logdst = CLIXON_LOG_STDERR;
+    clixon_handle h = NULL;
+    int           s = -1;
+    int           iterations = 1;
+    char         *pattern = "*";
+    char         *service = NULL;
+    int           edit = 0;
+    char         *creator = "testA[name='bench']";
+    int           nr = 0;
+    int           i;
+    uint64_t      ms;
+    uint64_t      min = UINT64_MAX;
+    uint64_t      max = 0;
+    uint64_t      sum = 0;
+
+    if ((h = clixon_handle_init()) == NULL)
+        goto done;
+    clixon_log_init(h, __PROGRAM__, LOG_INFO, logdst);
+    opterr = 0;
+    optind = 1;
+    while ((c = getopt(argc, argv, BENCH_OPTS)) != -1)
+        switch (c) {
+        case 'h':
+            usage(h, argv[0]);
+            break;
+        case 'D' : /* debug */
+            if (sscanf(optarg, "%d", &dbg) != 1)
+                usage(h, argv[0]);
+            break;
+        case 'f': /* config file */
+            if (!strlen(optarg))
+                usage(h, argv[0]);
+            clicon_option_str_set(h, "CLICON_CONFIGFILE", optarg);
+            break;
+        case 'l': /* Log destination: s|e|o */
+            if ((logdst = clixon_log_opt(optarg[0])) < 0)
+                usage(h, argv[0]);
+            if (logdst == CLIXON_LOG_FILE &&
+                strlen(optarg)>1 &&
+                clixon_log_file(optarg+1) < 0)
+                goto done;
+            break;
+        case 'n': /* iterations */
+            if (sscanf(optarg, "%d", &iterations) != 1 || iterations < 1)
+                usage(h, argv[0]);
+            break;
+        case 'd': /* device pattern */
+            if (!strlen(optarg))
+                usage(h, argv[0]);
+            pattern = optarg;
+            break;
+        case 's': /* service instance */
+            if (!strlen(optarg))
+                usage(h, argv[0]);
+            service = optarg;
+            break;
+        case 'e': /* edit entries */
+            if (sscanf(optarg, "%d", &edit) != 1 || edit < 1)
+                usage(h, argv[0]);
+            break;
+        case 'c': /* creator tag */
+            if (!strlen(optarg))
+                usage(h, argv[0]);
+            creator = optarg;
+            break;
+        }
+    clixon_log_init(h, __PROGRAM__, dbg?LOG_DEBUG:LOG_INFO, logdst);
+    clixon_debug_init(h, dbg);
+    /* Find, read and parse configfile */
+    if (clicon_options_main(h) < 0)
+        goto done;
+    if (edit){
+        for (i=0; i<iterations; i++){
+            if (bench_edit(h, edit, creator, &ms) < 0)
+                goto done;
+            if (ms < min)
+                min = ms;
+            if (ms > max)
+                max = ms;
+            sum += ms;
+        }
+        fprintf(stdout, "entries: %d iterations: %d min: %" PRIu64 " avg: %" PRIu64 " max: %" PRIu64 " ms\n",
+                edit, iterations, min, sum/iterations, max);
+        goto ok;
+    }
+    if (bench_devices_nr(h, pattern, &nr) < 0)
+        goto done;
+    if (clicon_rpc_create_subscription(h, "controller-transaction", NULL, &s) < 0){
+        clixon_log(h, LOG_NOTICE, "controller-transaction: subscription failed: %s", clixon_err_reason());
+        goto done;
+    }
+    for (i=0; i<iterations; i++){
+        if (bench_commit(h, s, pattern, service, &ms) < 0)
+            goto done;
+        if (ms < min)
+            min = ms;
+        if (ms > max)
+            max = ms;
+        sum += ms;
+    }
+    fprintf(stdout, "devices: %d iterations: %d min: %" PRIu64 " avg: %" PRIu64 " max: %" PRIu64 " ms\n",
+            nr, iterations, min, sum/iterations, max);
+ ok:
+    retval = 0;
+  done:
+    if (s != -1)
+        close(s);
+    if (h){
+        clixon_err_exit();
+        clixon_log_exit();
+        clixon_handle_exit(h);
+    }
+    return retval;
+}
@@ -37,7 +37,7 @@
 #define CONTROLLER_NAMESPACE "http://clicon.org/controller"
 
 /* Command line options to be passed to getopt(3) */
-#define SERVICE_ACTION_OPTS "hD:f:l:s:e1"
+#define SERVICE_ACTION_OPTS "hD:f:l:s:b:e1"
 
 /*! Read services definition, write and mark an interface for each param in the service
  *
@@ -261,41 +261,64 @@ read_devices(clixon_handle h,
     return retval;
 }
 
-/*! Given service+instance config, send an edit-config interface for each param in the service
+/*! Get devices definition from delta services-commit notification, to devices/device/name
  *
- * @param[in] h       Clixon handle
- * @param[in] s       Socket
+ * @param[in]  xn   services-commit notification
+ * @param[out] xtp  Top of devices tree
+ * @retval     0    OK
+ * @retval    -1    Error
+ * @see read_devices  Read devices from backend if not delta notification
+ */
+static int
+notification_devices(cxobj  *xn,
+                     cxobj **xtp)
+{
+    int    retval = -1;
+    cxobj *xt = NULL;
+    cxobj *xd;
+    cxobj *x;
+    char  *devname;
+
+    if ((xt = xml_new("devices", NULL, CX_ELMNT)) == NULL)
+        goto done;
+    x = NULL;
+    while ((x = xml_child_each(xn, x,  CX_ELMNT)) != NULL){
+        if (strcmp(xml_name(x), "device") != 0)
+            continue;
+        if ((devname = xml_body(x)) == NULL)
+            continue;
+        if ((xd = xml_new("device", xt, CX_ELMNT)) == NULL)
+            goto done;
+        if (xml_new_body("name", xd, devname) == NULL)
+            goto done;
+    }
+    *xtp = xt;
+    xt = NULL;
+    retval = 0;
+ done:
+    if (xt)
+        xml_free(xt);
+    return retval;
+}
+
+/*! Given service+instance config, append device config with an interface for each param
+ *
+ * @param[in] cb      Edit-config buffer, appended with <device> of devname
  * @param[in] devname Device name
  * @param[in] xsc     XML service tree
- * @param[in] db      Target datastore
  * @param[in] tag     Creator tag
  * @retval    0       OK
  * @retval   -1       Error
  */
 static int
-do_service(clixon_handle h,
-           int           s,
-           char         *devname,
-           cxobj        *xsc,
-           char         *db,
-           char         *tag)
+do_service(cbuf  *cb,
+           char  *devname,
+           cxobj *xsc,
+           char  *tag)
 {
-    int    retval = -1;
-    cbuf  *cb = NULL;
     cxobj *x;
     char  *p;
 
-    if (strcmp(db, "actions") != 0){
-        clixon_err(OE_CFG, 0, "Unexpected datastore: %s (expected actions)", db);
-        goto done;
-    }
-    /* Write and mark a interface for each param in the service */
-    if ((cb = cbuf_new()) == NULL){
-        clixon_err(OE_XML, errno, "cbuf_new");
-        goto done;
-    }
-    cprintf(cb, "<config>");
-    cprintf(cb, "<devices xmlns=\"%s\">", CONTROLLER_NAMESPACE);
     cprintf(cb, "<device>");
     cprintf(cb, "<name>%s</name>", devname);
     cprintf(cb, "<config>");
@@ -320,23 +343,34 @@ do_service(clixon_handle h,
     cprintf(cb, "</interfaces>");
     cprintf(cb, "</config>");
     cprintf(cb, "</device>");
+    return 0;
+}
+
+/*! Send one edit-config of a batch of devices to the actions datastore
+ *
+ * @param[in] h       Clixon handle
+ * @param[in] cb      Edit-config buffer with <config><devices> and <device> entries
+ * @retval    0       OK
+ * @retval   -1       Error
+ */
+static int
+service_edit_config(clixon_handle h,
+                    cbuf         *cb)
+{
     cprintf(cb, "</devices>");
     cprintf(cb, "</config>");
     /* (Read service and) produce device output and mark with service name */
     if (clicon_rpc_edit_config(h, "actions xmlns=\"http://clicon.org/controller\"",
                                OP_NONE, cbuf_get(cb)) < 0)
-        goto done;
-    retval = 0;
- done:
-    if (cb)
-        cbuf_free(cb);
-    return retval;
+        return -1;
+    return 0;
 }
 
 /*! Loop over all devices
  *
+ * Device configs are sent in batches of service-batch devices in one edit-config,
+ * or all devices in one edit-config if 0
  * @param[in]  h         Clixon handle
- * @param[in]  s         Socket
  * @param[in]  targetdb  Datastore to edit
  * @param[in]  xdevs     Devices XML tree
  * @param[in]  xs        XML tree of one service instance (in config services tree)
@@ -346,7 +380,6 @@ do_service(clixon_handle h,
  */
 static int
 service_loop_devices(clixon_handle h,
-                     int           s,
                      char         *targetdb,
                      cxobj        *xdevs,
                      cxobj        *xs,
@@ -355,22 +388,49 @@ service_loop_devices(clixon_handle h,
     int     retval = -1;
     cxobj  *xd;
     char   *devname;
+    cbuf   *cb = NULL;
+    int     batch;
+    int     n = 0;
 
+    if (strcmp(targetdb, "actions") != 0){
+        clixon_err(OE_CFG, 0, "Unexpected datastore: %s (expected actions)", targetdb);
+        goto done;
+    }
+    /* Write and mark a interface for each param in the service */
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_XML, errno, "cbuf_new");
+        goto done;
+    }
+    batch = clicon_data_int_get(h, "service-batch");
     xd = NULL;
     while ((xd = xml_child_each(xdevs, xd,  CX_ELMNT)) != NULL){
-        devname = xml_find_body(xd, "name");
-        if (do_service(h, s, devname, xs, targetdb, tag) < 0)
+        if ((devname = xml_find_body(xd, "name")) == NULL)
+            continue;
+        if (n == 0){
+            cbuf_reset(cb);
+            cprintf(cb, "<config>");
+            cprintf(cb, "<devices xmlns=\"%s\">", CONTROLLER_NAMESPACE);
+        }
+        if (do_service(cb, devname, xs, tag) < 0)
             goto done;
+        if (++n == batch){
+            if (service_edit_config(h, cb) < 0)
+                goto done;
+            n = 0;
+        }
     }
+    if (n > 0 && service_edit_config(h, cb) < 0)
+        goto done;
     retval = 0;
  done:
+    if (cb)
+        cbuf_free(cb);
     return retval;
 }
 
 /*! Iterate through one service+instance
  *
  * @param[in]  h         Clixon handle
- * @param[in]  s         Socket
  * @param[in]  pattern   Glob of services/instance, typically '*'
  * @param[in]  targetdb  Datastore to edit
  * @param[in]  xdevs     Devices XML tree
@@ -380,7 +440,6 @@ service_loop_devices(clixon_handle h,
  */
 static int
 service_action_one(clixon_handle h,
-                   int           s,
                    char         *pattern,
                    char         *targetdb,
                    cxobj        *xdevs,
@@ -400,7 +459,7 @@ service_action_one(clixon_handle h,
     }
     /* XXX See also controller_actions_diff where tags are also created */
     cprintf(cb, "%s[%s='%s']", xml_name(xs), xml_name(xi), instance);
-    if (service_loop_devices(h, s, targetdb, xdevs, xs, cbuf_get(cb)) < 0)
+    if (service_loop_devices(h, targetdb, xdevs, xs, cbuf_get(cb)) < 0)
         goto done;
  ok:
     retval = 0;
@@ -413,7 +472,6 @@ service_action_one(clixon_handle h,
 /*! Specific service+instance handler, given tag find that service instance and handle it
  *
  * @param[in]  h         Clixon handle
- * @param[in]  s         Socket
  * @param[in]  pattern   Glob of services/instance, typically '*'
  * @param[in]  targetdb  Datastore to edit
  * @param[in]  xservices Services XML tree
@@ -424,7 +482,6 @@ service_action_one(clixon_handle h,
  */
 static int
 service_action_instance(clixon_handle h,
-                        int           s,
                         char         *pattern,
                         char         *targetdb,
                         cxobj        *xservices,
@@ -443,7 +500,7 @@ service_action_instance(clixon_handle h,
      * See also controller_actions_diff()
      */
     if ((xs = xpath_first(xservices, NULL, "%s", tag)) != NULL){
-        if (service_loop_devices(h, s, targetdb, xdevs, xs, tag) < 0)
+        if (service_loop_devices(h, targetdb, xdevs, xs, tag) < 0)
             goto done;
     }
  ok:
@@ -455,7 +512,6 @@ service_action_instance(clixon_handle h,
 /*! Service commit notification handling, actions on test* services on all devices
  *
  * @param[in]  h            Clixon handle
- * @param[in]  s            Socket
  * @param[in]  notification XML of notification
  * @param[in]  pattern      Glob of services/instance, typically '*'
  * @param[in]  send_error   Send error instead of edit-config/done
@@ -464,7 +520,6 @@ service_action_instance(clixon_handle h,
  */
 static int
 service_action_handler(clixon_handle      h,
-                       int                s,
                        struct clicon_msg *notification,
                        char              *pattern,
                        int                send_error)
@@ -511,15 +566,23 @@ service_action_handler(clixon_handle      h,
         goto ok;
     }
 #endif
-    /* Read services and devices definition */
-    if (read_services(h, sourcedb, &xservices) < 0)
-        goto done;
-    if (read_devices(h, sourcedb, &xdevs) < 0)
-        goto done;
+    /* Services and devices are inlined in delta notification (services-commit-delta),
+     * otherwise read services and devices definition */
+    if ((xservices = xml_find_type(xn, NULL, "services", CX_ELMNT)) != NULL){
+        xml_rm(xservices);
+        if (notification_devices(xn, &xdevs) < 0)
+            goto done;
+    }
+    else {
+        if (read_services(h, sourcedb, &xservices) < 0)
+            goto done;
+        if (read_devices(h, sourcedb, &xdevs) < 0)
+            goto done;
+    }
     if (xpath_first(xn, 0, "service") == 0){ /* All services: loop through service definitions */
         xs = NULL;
         while ((xs = xml_child_each(xservices, xs,  CX_ELMNT)) != NULL){
-            if (service_action_one(h, s, pattern, targetdb, xdevs, xs) < 0)
+            if (service_action_one(h, pattern, targetdb, xdevs, xs) < 0)
                 goto done;
         }
     }
@@ -528,7 +591,7 @@ service_action_handler(clixon_handle      h,
         while ((xsi = xml_child_each(xn, xsi,  CX_ELMNT)) != NULL){
             if (strcmp(xml_name(xsi), "service") != 0)
                 continue;
-            if (service_action_instance(h, s, pattern, targetdb, xservices, xdevs, xsi) < 0)
+            if (service_action_instance(h, pattern, targetdb, xservices, xdevs, xsi) < 0)
                 goto done;
         }
     }
@@ -597,6 +660,7 @@ usage(clixon_handle h,
             "\t-f <file> \tConfig-file (mandatory)\n"
             "\t-l <s|e|o|n|f<file>> \tLog on (s)yslog, std(e)rr, std(o)ut, (n)one or (f)ile (syslog is default)\n"
             "\t-s <pattern> \tGlob pattern of services served, (default *)\n"
+            "\t-b <nr> \tNumber of devices per edit-config, 0 means all (default 0)\n"
             "\t-e  \tSend an error instead of done\n"
             "\t-1\t\tRun once and then quit (dont wait for events)\n",
             argv0
@@ -620,6 +684,7 @@ main(int    argc,
     char                *service_pattern = "*";
     int                  send_error = 0;
     int                  once = 0;
+    int                  batch = 0;
 
     if ((h = clixon_handle_init()) == NULL)
         goto done;;
@@ -656,6 +721,10 @@ main(int    argc,
                 usage(h, argv[0]);
             service_pattern = optarg;
             break;
+        case 'b': /* batch */
+            if (sscanf(optarg, "%d", &batch) != 1 || batch < 0)
+                usage(h, argv[0]);
+            break;
         case 'e': /* error */
             send_error++;
             break;
@@ -665,6 +734,7 @@ main(int    argc,
         }
     clixon_log_init(h, __PROGRAM__, dbg?LOG_DEBUG:LOG_INFO, logdst);
     clixon_debug_init(h, dbg);
+    clicon_data_int_set(h, "service-batch", batch);
     /* Setup handlers to exit cleanly when killed from parent or user */
     if (set_signal(SIGTERM, service_action_sig_term, NULL) < 0){
         clixon_err(OE_DAEMON, errno, "Setting signal");
@@ -691,7 +761,7 @@ main(int    argc,
         while (clicon_msg_rcv(s, NULL, 0, &notification, &eof) == 0){
             if (eof)
                 break;
-            if (service_action_handler(h, s, notification, service_pattern, send_error) < 0)
+            if (service_action_handler(h, notification, service_pattern, send_error) < 0)
                 goto done;
             if (notification){
                 free(notification);